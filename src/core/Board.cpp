@@ -3,6 +3,8 @@
 #include "moves/hpp/MoveGeneration.hpp"
 #include "moves/hpp/MoveSimulation.hpp"
 #include "../engine/EngineMove.hpp"
+#include "Tablebase.hpp"
+#include "Kpk.hpp"
 #include <raymath.h>
 #include <iostream>
 #include <string>
@@ -64,6 +66,7 @@ Board::Board(GameState *state) : gameState(state), dragging(false), draggedPiece
                                  blackKingPosition({boardPosition.x + 4 * squareSize, boardPosition.y}),
                                  whiteKingPosition({boardPosition.x + 4 * squareSize, boardPosition.y + 7 * squareSize})
 {
+    livePosition = Position::StartPosition();
 }
 
 void Board::DrawScores()
@@ -127,6 +130,21 @@ static int ResolvePromotionColor(const std::vector<Piece> &pieces, const Vector2
     return fallbackColor;
 }
 
+// Side panel slot of the n-th captured piece of a color: white pieces fill rows
+// downward from the top, black ones upward from the bottom
+static Vector2 PanelPixelOf(int color, int slot)
+{
+    const float sidePanelX = 920; // Start X position in side panel
+    const float spacing = 70;     // Space between pieces
+    const int piecesPerRow = 5;   // Pieces per row in side panel
+
+    int row = slot / piecesPerRow;
+    int col = slot % piecesPerRow;
+    float y = (color == 1) ? boardPosition.y + 20 + row * spacing
+                           : boardPosition.y + 7 * squareSize + 20 - row * spacing;
+    return {sidePanelX + spacing * col, y};
+}
+
 Board::~Board()
 {
     std::unordered_set<unsigned int> pieceIds;
@@ -236,8 +254,12 @@ void Board::LoadPromotionTexture()
 void Board::DrawPieces()
 {
     DrawScores();
-    for (const auto &piece : pieces)
+    for (std::size_t i = 0; i < pieces.size(); i++)
     {
+        const Piece &piece = pieces[i];
+        if (dragging && static_cast<int>(i) == draggedPieceIndex)
+            continue;
+
         if (piece.captured)
         {
             // Draw captured pieces at smaller scale in side panel
@@ -251,6 +273,13 @@ void Board::DrawPieces()
             DrawTexture(piece.texture, drawPos.x, drawPos.y, WHITE);
         }
     }
+
+    // Dragged piece on top of everything else
+    if (dragging)
+    {
+        Vector2 drawPos = TransformPosition(pieces[draggedPieceIndex].position);
+        DrawTexture(pieces[draggedPieceIndex].texture, drawPos.x, drawPos.y, WHITE);
+    }
 }
 
 void Board::DrawLastMoveHightlight()
@@ -289,6 +318,34 @@ void Board::DrawLastMoveHightlight()
         hightlightColor);
 }
 
+void Board::DrawMoveArrow(int fromSquare, int toSquare, Color color)
+{
+    // Position squares -> top-left pixel corners (row 0 is rank 8), then through the flip
+    Vector2 fromPos = TransformPosition({boardPosition.x + (fromSquare % 8) * squareSize,
+                                         boardPosition.y + (7 - fromSquare / 8) * squareSize});
+    Vector2 toPos = TransformPosition({boardPosition.x + (toSquare % 8) * squareSize,
+                                       boardPosition.y + (7 - toSquare / 8) * squareSize});
+
+    Vector2 half = {squareSize / 2, squareSize / 2};
+    Vector2 start = Vector2Add(fromPos, half);
+    Vector2 end = Vector2Add(toPos, half);
+
+    Vector2 dir = Vector2Normalize(Vector2Subtract(end, start));
+    Vector2 normal = {-dir.y, dir.x};
+    float headLength = squareSize * 0.35f;
+    float headWidth = squareSize * 0.22f;
+
+    Vector2 shaftEnd = Vector2Subtract(end, Vector2Scale(dir, headLength));
+    DrawLineEx(start, shaftEnd, squareSize * 0.12f, color);
+
+    Vector2 left = Vector2Add(shaftEnd, Vector2Scale(normal, headWidth));
+    Vector2 right = Vector2Subtract(shaftEnd, Vector2Scale(normal, headWidth));
+    // DrawTriangle wants counter-clockwise points; the winding flips with the
+    // arrow direction, so draw both and let the back-facing one be culled
+    DrawTriangle(end, left, right, color);
+    DrawTriangle(end, right, left, color);
+}
+
 void Board::DrawCheckHighlight()
 {
     if (!kingInCheck)
@@ -498,16 +555,14 @@ void Board::DrawPromotionMenu(Vector2 position, int color)
     HandlePawnPromotion(color, position);
 }
 
-void Board::DrawMoveHistory(int reviewIndex)
+void Board::DrawMoveHistory(int reviewIndex, float panelY, float panelHeight)
 {
     if (!showMoveHistory)
         return;
 
-    // Match the full right-side panel area.
+    // Right-side panel column; the full height unless the caller shares it.
     float panelX = 914.0f;
-    float panelY = 55.0f;
     float panelWidth = 380.0f;
-    float panelHeight = 910.0f;
 
     moveHistory.DrawPanel(panelX, panelY, panelWidth, panelHeight, reviewIndex);
 }
@@ -574,6 +629,8 @@ void Board::HandlePawnPromotion(int color, Vector2 position)
                             moveHistory.GetLastMoveMutable().isCheck = opponentInCheck && !Checkmate;
                         }
 
+                        SyncLivePosition(); // The move is complete now that the piece is known
+
                         break;
                     }
                 }
@@ -587,11 +644,6 @@ void Board::HandlePawnPromotion(int color, Vector2 position)
 
 void Board::CapturePiece(int capturedPieceIndex)
 {
-    // Side panel captured pieces layout
-    float sidePanelX = 920; // Start X position in side panel
-    float spacing = 70;     // Space between pieces
-    int piecesPerRow = 5;   // Pieces per row in side panel
-
     int pieceValue = GetPieceValue(pieces[capturedPieceIndex].type);
 
     // Use gameState for score tracking
@@ -600,23 +652,12 @@ void Board::CapturePiece(int capturedPieceIndex)
 
     if (pieces[capturedPieceIndex].color == 1)
     { // White piece captured by black - show in top section of side panel
-        int row = whiteCapturedCount / piecesPerRow;
-        int col = whiteCapturedCount % piecesPerRow;
-
-        pieces[capturedPieceIndex].position.x = sidePanelX + spacing * col;
-        pieces[capturedPieceIndex].position.y = boardPosition.y + 20 + row * spacing; // Top area
-
+        pieces[capturedPieceIndex].position = PanelPixelOf(1, whiteCapturedCount);
         whiteCapturedCount++;
     }
     else
     { // Black piece captured by white - show in bottom section of side panel
-        int row = blackCapturedCount / piecesPerRow;
-        int col = blackCapturedCount % piecesPerRow;
-
-        pieces[capturedPieceIndex].position.x = sidePanelX + spacing * col;
-        // New rows go upward (subtract row * spacing)
-        pieces[capturedPieceIndex].position.y = boardPosition.y + 7 * squareSize + 20 - row * spacing;
-
+        pieces[capturedPieceIndex].position = PanelPixelOf(0, blackCapturedCount);
         blackCapturedCount++;
     }
     pieces[capturedPieceIndex].captured = true;
@@ -875,6 +916,8 @@ bool Board::TryExecuteMove(int pieceIndex, Vector2 from, Vector2 to)
 
     // For recording Uci moves in updatedragging
     uciMoveList.push_back(posToUCI(from) + posToUCI(to));
+    if (!PawnPromo)
+        SyncLivePosition();
 
     // Damn I worked Hard in this function
     // Store the Last move for highlighting
@@ -891,23 +934,179 @@ bool Board::TryExecuteMove(int pieceIndex, Vector2 from, Vector2 to)
     return true;
 }
 
+namespace
+{
+
+Vector2 PixelOf(int8_t square)
+{
+    if (square < 0)
+        return {0.0f, 0.0f};
+    return {boardPosition.x + (square % boardSize) * squareSize, boardPosition.y + (square / boardSize) * squareSize};
+}
+
+// Board square of a pixel position (row * 8 + column), -1 if it is not on one
+int8_t SquareOf(Vector2 pos)
+{
+    int col = static_cast<int>(std::round((pos.x - boardPosition.x) / squareSize));
+    int row = static_cast<int>(std::round((pos.y - boardPosition.y) / squareSize));
+    if (col < 0 || col >= boardSize || row < 0 || row >= boardSize)
+        return -1;
+
+    int8_t square = static_cast<int8_t>(row * boardSize + col);
+    Vector2 snapped = PixelOf(square);
+    if (std::abs(snapped.x - pos.x) >= 1.0f || std::abs(snapped.y - pos.y) >= 1.0f)
+        return -1;
+    return square;
+}
+
+PackedPiece PackPiece(const Piece &piece)
+{
+    PackedPiece packed;
+    packed.square = PackedPiece::PACKED_NONE;
+    packed.code = static_cast<uint8_t>(piece.type & PackedPiece::PACKED_TYPE);
+    if (piece.color == 1)
+        packed.code |= PackedPiece::PACKED_WHITE;
+    if (piece.hasMoved)
+        packed.code |= PackedPiece::PACKED_MOVED;
+    if (piece.captured)
+        packed.code |= PackedPiece::PACKED_CAPTURED;
+
+    if (!piece.captured)
+    {
+        int8_t square = SquareOf(piece.position);
+        if (square >= 0)
+            packed.square = static_cast<uint8_t>(square);
+        return packed;
+    }
+
+    // At most 15 pieces of a color can be captured
+    for (int slot = 0; slot < 16; slot++)
+    {
+        Vector2 pixel = PanelPixelOf(piece.color, slot);
+        if (std::abs(pixel.x - piece.position.x) < 1.0f && std::abs(pixel.y - piece.position.y) < 1.0f)
+        {
+            packed.square = static_cast<uint8_t>(PackedPiece::PACKED_PANEL + slot);
+            break;
+        }
+    }
+    return packed;
+}
+
+} // namespace
+
+void Board::UnpackPiece(const PackedPiece &packed, Piece &piece)
+{
+    int type = packed.code & PackedPiece::PACKED_TYPE;
+    piece.color = (packed.code & PackedPiece::PACKED_WHITE) ? 1 : 0;
+    if (piece.type != type) // Promoted
+    {
+        piece.type = type;
+        piece.texture = promotionTexture[(piece.color == 0) ? (type - 1) : (type - 1 + 6)];
+    }
+    piece.hasMoved = (packed.code & PackedPiece::PACKED_MOVED) != 0;
+    piece.captured = (packed.code & PackedPiece::PACKED_CAPTURED) != 0;
+
+    if (packed.square == PackedPiece::PACKED_NONE)
+        return;
+    if (packed.square >= PackedPiece::PACKED_PANEL)
+        piece.position = PanelPixelOf(piece.color, packed.square - PackedPiece::PACKED_PANEL);
+    else
+        piece.position = PixelOf(static_cast<int8_t>(packed.square));
+}
+
 void Board::SaveBoardSnapshot()
 {
-    BoardSnapshot snap;
-    snap.pieces = pieces;
-    snap.currentPlayer = gameState->getCurrentPlayer();
-    snap.whiteKingPosition = whiteKingPosition;
-    snap.blackKingPosition = blackKingPosition;
-    snap.whiteScore = gameState->getWhiteScore();
-    snap.blackScore = gameState->getBlackScore();
-    snap.whiteCapturedCount = whiteCapturedCount;
-    snap.blackCapturedCount = blackCapturedCount;
-    snap.kingInCheck = kingInCheck;
-    snap.hasLastMove = gameState->getHasLastMove();
-    snap.lastMoveFrom = gameState->getLastMoveFrom();
-    snap.lastMoveTo = gameState->getLastMoveTo();
-    snap.enPassantLastMove = MoveSimulation::lastMove;
-    boardHistory.push_back(snap);
+    PlyRecord ply;
+    ply.firstDelta = static_cast<uint32_t>(pieceDeltas.size());
+
+    // A keyframe every HISTORY_KEYFRAME_INTERVAL plies; deltas for the rest.
+    // Pieces are never added or removed mid-game, so the tip keeps its size.
+    bool keyframe = plyHistory.size() % HISTORY_KEYFRAME_INTERVAL == 0;
+    bool diff = !keyframe && historyTip.size() == pieces.size();
+    historyTip.resize(pieces.size());
+    for (std::size_t i = 0; i < pieces.size(); i++)
+    {
+        PackedPiece now = PackPiece(pieces[i]);
+        if (keyframe)
+        {
+            keyframes.push_back(now);
+        }
+        else if (diff && now != historyTip[i])
+        {
+            PieceDelta delta;
+            delta.index = static_cast<uint8_t>(i);
+            delta.piece = now;
+            pieceDeltas.push_back(delta);
+        }
+        historyTip[i] = now;
+    }
+
+    const Piece &lastPiece = std::get<0>(MoveSimulation::lastMove);
+    ply.currentPlayer = static_cast<int8_t>(gameState->getCurrentPlayer());
+    ply.flags = 0;
+    if (kingInCheck)
+        ply.flags |= PlyRecord::PLY_KING_IN_CHECK;
+    if (gameState->getHasLastMove())
+        ply.flags |= PlyRecord::PLY_HAS_LAST_MOVE;
+    ply.lastMoveFrom = SquareOf(gameState->getLastMoveFrom());
+    ply.lastMoveTo = SquareOf(gameState->getLastMoveTo());
+    ply.enPassantType = static_cast<int8_t>(lastPiece.type);
+    ply.enPassantColor = static_cast<int8_t>(lastPiece.color);
+    ply.enPassantFrom = SquareOf(std::get<1>(MoveSimulation::lastMove));
+    ply.enPassantTo = SquareOf(std::get<2>(MoveSimulation::lastMove));
+    ply.whiteScore = static_cast<int16_t>(gameState->getWhiteScore());
+    ply.blackScore = static_cast<int16_t>(gameState->getBlackScore());
+    plyHistory.push_back(ply);
+}
+
+void Board::RestorePly(int ply)
+{
+    const std::size_t pieceCount = pieces.size();
+    int keyframe = std::min(ply / HISTORY_KEYFRAME_INTERVAL, static_cast<int>(keyframes.size() / pieceCount) - 1);
+    for (std::size_t i = 0; i < pieceCount; i++)
+        UnpackPiece(keyframes[keyframe * pieceCount + i], pieces[i]);
+
+    for (int i = keyframe * HISTORY_KEYFRAME_INTERVAL + 1; i <= ply; i++)
+    {
+        uint32_t end = (i + 1 < static_cast<int>(plyHistory.size())) ? plyHistory[i + 1].firstDelta
+                                                                     : static_cast<uint32_t>(pieceDeltas.size());
+        for (uint32_t d = plyHistory[i].firstDelta; d < end; d++)
+            UnpackPiece(pieceDeltas[d].piece, pieces[pieceDeltas[d].index]);
+    }
+
+    // King squares and capture counts follow from the pieces
+    whiteCapturedCount = 0;
+    blackCapturedCount = 0;
+    for (const Piece &piece : pieces)
+    {
+        if (piece.captured)
+            (piece.color == 1 ? whiteCapturedCount : blackCapturedCount)++;
+        else if (piece.type == KING)
+            (piece.color == 1 ? whiteKingPosition : blackKingPosition) = piece.position;
+    }
+
+    const PlyRecord &record = plyHistory[ply];
+    kingInCheck = (record.flags & PlyRecord::PLY_KING_IN_CHECK) != 0;
+
+    Piece lastPiece;
+    lastPiece.type = record.enPassantType;
+    lastPiece.color = record.enPassantColor;
+    MoveSimulation::lastMove = std::make_tuple(lastPiece, PixelOf(record.enPassantFrom), PixelOf(record.enPassantTo));
+
+    gameState->setCurrentPlayer(record.currentPlayer);
+    gameState->setWhiteScore(record.whiteScore);
+    gameState->setBlackScore(record.blackScore);
+    gameState->setWhiteCapturedCount(whiteCapturedCount);
+    gameState->setBlackCapturedCount(blackCapturedCount);
+
+    if (record.flags & PlyRecord::PLY_HAS_LAST_MOVE)
+    {
+        gameState->setLastMove(PixelOf(record.lastMoveFrom), PixelOf(record.lastMoveTo));
+    }
+    else
+    {
+        gameState->clearLastMove();
+    }
 }
 
 void Board::RestoreBoardSnapshot(const BoardSnapshot &snap)
@@ -966,14 +1165,14 @@ void Board::RestoreLiveSnapshot()
 
 void Board::GoToMove(int moveIndex)
 {
-    if (boardHistory.empty())
+    if (plyHistory.empty())
         return;
     if (moveIndex < 0)
         moveIndex = 0;
-    if (moveIndex >= static_cast<int>(boardHistory.size()))
-        moveIndex = static_cast<int>(boardHistory.size()) - 1;
+    if (moveIndex >= static_cast<int>(plyHistory.size()))
+        moveIndex = static_cast<int>(plyHistory.size()) - 1;
 
-    RestoreBoardSnapshot(boardHistory[moveIndex]);
+    RestorePly(moveIndex);
     reviewMoveIndex = moveIndex;
     isReviewing = true;
 }
@@ -983,7 +1182,7 @@ void Board::GoBackOne()
     if (!isReviewing)
     {
         TakeLiveSnapshot();
-        GoToMove(static_cast<int>(boardHistory.size()) - 2);
+        GoToMove(static_cast<int>(plyHistory.size()) - 2);
     }
     else
     {
@@ -996,7 +1195,7 @@ void Board::GoForwardOne()
     if (!isReviewing)
         return;
 
-    int latestIdx = static_cast<int>(boardHistory.size()) - 1;
+    int latestIdx = static_cast<int>(plyHistory.size()) - 1;
 
     if (reviewMoveIndex >= latestIdx)
     {
@@ -1076,21 +1275,8 @@ void Board::UpdateDragging()
                     ClearSelection();
                 }
 
-                // Moving the dragged piece to the back of the vector so it is drawn last
-                Piece draggedPiece = pieces[i];
-                pieces.erase(pieces.begin() + i);
-                pieces.push_back(draggedPiece);
-                draggedPieceIndex = pieces.size() - 1; // Update the index after moving the piece
-
-                // Update clickSelectedPieceIndex for vector index shift
-                if (clickSelectedPieceIndex == static_cast<int>(i))
-                {
-                    clickSelectedPieceIndex = draggedPieceIndex;
-                }
-                else if (clickSelectedPieceIndex > static_cast<int>(i))
-                {
-                    clickSelectedPieceIndex--;
-                }
+                // The piece stays where it is in the vector - the history deltas
+                // index into it - and DrawPieces draws it last instead
                 break;
             }
         }
@@ -1349,6 +1535,7 @@ bool Board::ApplyEngineMove(const EngineMove &move)
 
     pieces[pieceIndex].position = newPos;
 
+    bool wasPromotion = false;
     if (pieces[pieceIndex].type == PAWN)
     {
         int promotionRank = (pieces[pieceIndex].color == 0) ? 7 : 0;
@@ -1367,6 +1554,7 @@ bool Board::ApplyEngineMove(const EngineMove &move)
                                                               ? (promotedType - 1)
                                                               : (promotedType - 1 + 6)];
             PawnPromo = false;
+            wasPromotion = true;
         }
     }
 
@@ -1430,7 +1618,8 @@ bool Board::ApplyEngineMove(const EngineMove &move)
     MoveRecord record;
 
     record.moveNumber = static_cast<int>(moveHistory.GetMoves().size()) / 2 + 1;
-    record.pieceType = static_cast<PieceType>(pieces[pieceIndex].type);
+    record.pieceType = wasPromotion ? PAWN : static_cast<PieceType>(pieces[pieceIndex].type);
+    record.promotedTo = wasPromotion ? static_cast<PieceType>(pieces[pieceIndex].type) : NONE;
     record.pieceColor = pieces[pieceIndex].color;
     record.from = originalPos;
     record.to = newPos;
@@ -1447,6 +1636,7 @@ bool Board::ApplyEngineMove(const EngineMove &move)
         }
     }
     moveHistory.AddMove(record);
+    SyncLivePosition();
 
     gameState->setLastMove(originalPos, newPos);
     gameState->switchPlayer();
@@ -1456,6 +1646,152 @@ bool Board::ApplyEngineMove(const EngineMove &move)
     return true;
 }
 
+bool Board::ApplyUciMove(const std::string &uci)
+{
+    if (uci.size() < 4)
+        return false;
+
+    // Same conversion as the engine: files a-h are columns, rank 8 is row 0
+    EngineMove move;
+    move.from = {boardPosition.x + (uci[0] - 'a') * squareSize, boardPosition.y + ('8' - uci[1]) * squareSize};
+    move.to = {boardPosition.x + (uci[2] - 'a') * squareSize, boardPosition.y + ('8' - uci[3]) * squareSize};
+    if (uci.size() >= 5)
+    {
+        switch (uci[4])
+        {
+        case 'q': move.promotionPiece = QUEEN; break;
+        case 'r': move.promotionPiece = ROOK; break;
+        case 'b': move.promotionPiece = BISHOP; break;
+        case 'n': move.promotionPiece = KNIGHT; break;
+        default: break;
+        }
+    }
+    move.isValid = true;
+
+    return ApplyEngineMove(move);
+}
+
+bool Board::ReplayMoves(const std::vector<std::string> &uciMoves)
+{
+    Reset();
+    for (const std::string &uci : uciMoves)
+    {
+        if (!ApplyUciMove(uci))
+        {
+            std::cerr << "Board: could not replay " << uci << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void Board::SyncLivePosition()
+{
+    if (positionKeys.empty())
+        positionKeys.push_back(livePosition.Key());
+
+    while (livePositionValid && livePositionPlies < uciMoveList.size())
+    {
+        Move move;
+        if (!livePosition.ParseUCI(uciMoveList[livePositionPlies], move))
+        {
+            std::cerr << "Board: could not replay " << uciMoveList[livePositionPlies]
+                      << ", tablebase adjudication disabled for this game" << std::endl;
+            livePositionValid = false;
+            break;
+        }
+        livePosition.MakeMove(move);
+        livePositionPlies++;
+        positionKeys.push_back(livePosition.Key());
+    }
+
+    CheckDrawRules();
+    CheckTablebaseAdjudication();
+}
+
+void Board::CheckDrawRules()
+{
+    if (!livePositionValid || Checkmate || Stalemate || Resigned || Adjudicated)
+        return;
+
+    GamePhase draw;
+    if (Position::IsThreefoldRepetition(positionKeys.data(), static_cast<int>(positionKeys.size()),
+                                        livePosition.HalfmoveClock()))
+        draw = GamePhase::REPETITION_DRAW;
+    else if (livePosition.IsFiftyMoveDraw())
+        draw = GamePhase::FIFTY_MOVE_DRAW;
+    else if (livePosition.HasInsufficientMaterial())
+        draw = GamePhase::INSUFFICIENT_MATERIAL_DRAW;
+    else
+        return;
+
+    Adjudicated = true;
+    adjudicatedWinner = -1;
+    gameState->setPhase(draw);
+}
+
+void Board::CheckTablebaseAdjudication()
+{
+    if (!livePositionValid || Checkmate || Stalemate || Resigned || Adjudicated)
+        return;
+
+    // KPK is compiled in, so it works even without any table files on disk
+    TablebaseResult result;
+    if (!Kpk::Probe(livePosition, result.wdl) &&
+        (tablebase == nullptr || !tablebase->Probe(livePosition, result)))
+        return;
+
+    if (result.wdl == 0)
+    {
+        Adjudicated = true;
+        adjudicatedWinner = -1;
+        gameState->setPhase(GamePhase::TABLEBASE_DRAW);
+    }
+    else if (adjudicateTablebaseWins)
+    {
+        int mover = livePosition.SideToMove();
+        Adjudicated = true;
+        adjudicatedWinner = (result.wdl > 0) ? mover : 1 - mover;
+        gameState->setPhase(GamePhase::TABLEBASE_WIN);
+    }
+}
+
+// Only a bare king, or king + single minor against a bare king, can never mate
+bool Board::HasMatingMaterial(int color) const
+{
+    if (!livePositionValid)
+        return true;
+
+    const Position &pos = livePosition;
+    int heavy = pos.PieceCount(color, PAWN) + pos.PieceCount(color, ROOK) + pos.PieceCount(color, QUEEN);
+    int minors = pos.PieceCount(color, KNIGHT) + pos.PieceCount(color, BISHOP);
+    if (heavy > 0 || minors >= 2)
+        return true;
+    if (minors == 0)
+        return false;
+
+    // A lone minor can only mate if the other side has pieces to block its own king
+    int other = 1 - color;
+    for (int type = ROOK; type <= PAWN; type++)
+    {
+        if (type != KING && pos.PieceCount(other, type) > 0)
+            return true;
+    }
+    return false;
+}
+
+void Board::AdjudicateTimeout(int flaggedColor)
+{
+    if (Checkmate || Stalemate || Resigned || Adjudicated)
+        return;
+
+    int winner = 1 - flaggedColor;
+    Adjudicated = true;
+    adjudicatedOnTime = true;
+    adjudicatedWinner = HasMatingMaterial(winner) ? winner : -1;
+    gameState->setPhase(GamePhase::TIME_FORFEIT);
+}
+
 void Board::Reset()
 {
     // First unload old pieces texture/ it is inefficient but safe
@@ -1473,6 +1809,9 @@ void Board::Reset()
     draggedPieceIndex = -1;
     Resigned = false;
     resignedPlayer = -1;
+    Adjudicated = false;
+    adjudicatedWinner = -1;
+    adjudicatedOnTime = false;
     showMoveHistory = true;
     promotionPosition = {0, 0};
 
@@ -1497,8 +1836,15 @@ void Board::Reset()
     moveHistory.Clear();
 
     uciMoveList.clear();
-
-    boardHistory.clear();
+    livePosition = Position::StartPosition();
+    livePositionPlies = 0;
+    livePositionValid = true;
+    positionKeys.clear();
+
+    plyHistory.clear();
+    pieceDeltas.clear();
+    keyframes.clear();
+    historyTip.clear();
     hasSavedLiveState = false;
     isReviewing = false;
     reviewMoveIndex = -1;
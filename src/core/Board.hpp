@@ -5,11 +5,14 @@
 #include "GameState.hpp"
 #include "Constants.hpp"
 #include <raylib.h>
+#include <cstdint>
 #include <vector>
 #include <tuple>
 #include "MoveHistory.hpp"
+#include "Position.hpp"
 
 struct EngineMove; // Forward declaration -- full definition in EngineMove.hpp
+class Tablebase;   // Forward declaration -- full definition in Tablebase.hpp
 
 struct BoardSnapshot
 {
@@ -28,6 +31,55 @@ struct BoardSnapshot
     std::tuple<Piece, Vector2, Vector2> enPassantLastMove; 
 };
 
+// Game history is stored as deltas: per ply, the pieces that changed since the
+// ply before plus the small state that goes with it. Every
+// HISTORY_KEYFRAME_INTERVAL plies the whole piece list is kept as a keyframe,
+// so any ply is rebuilt from the keyframe before it in at most that many steps.
+// Squares are row * 8 + column on the unflipped board, -1 = none. Deltas name
+// pieces by their index, so Board::pieces must keep its order for the whole game.
+// Textures are not stored; restored pieces take them from the loaded set.
+
+// A piece in two bytes. Captured pieces are stored by their side panel slot,
+// the pixel position follows from it.
+struct PackedPiece
+{
+    uint8_t square; // Board square, or PACKED_PANEL + slot when captured
+    uint8_t code;   // Type | PACKED_WHITE | PACKED_MOVED | PACKED_CAPTURED
+
+    static constexpr uint8_t PACKED_PANEL = 64;
+    static constexpr uint8_t PACKED_NONE = 0xFF;
+    static constexpr uint8_t PACKED_TYPE = 0x07;
+    static constexpr uint8_t PACKED_WHITE = 0x08;
+    static constexpr uint8_t PACKED_MOVED = 0x10;
+    static constexpr uint8_t PACKED_CAPTURED = 0x20;
+
+    bool operator==(const PackedPiece &other) const { return square == other.square && code == other.code; }
+    bool operator!=(const PackedPiece &other) const { return !(*this == other); }
+};
+
+struct PieceDelta
+{
+    uint8_t index; // Into Board::pieces
+    PackedPiece piece;
+};
+
+struct PlyRecord
+{
+    uint32_t firstDelta; // Deltas run up to the next ply's firstDelta
+    int16_t whiteScore;
+    int16_t blackScore;
+    int8_t currentPlayer;
+    uint8_t flags;       // PLY_KING_IN_CHECK | PLY_HAS_LAST_MOVE
+    int8_t lastMoveFrom;
+    int8_t lastMoveTo;
+    int8_t enPassantType;   // MoveSimulation::lastMove, which en passant checks against
+    int8_t enPassantColor;
+    int8_t enPassantFrom;
+    int8_t enPassantTo;
+
+    static constexpr uint8_t PLY_KING_IN_CHECK = 0x01;
+    static constexpr uint8_t PLY_HAS_LAST_MOVE = 0x02;
+};
 
 class Board
 {
@@ -44,7 +96,11 @@ private:
     Texture2D promotionTexture[12];
     MoveHistory moveHistory; // Stores full game transcript. 
 
-    std::vector<BoardSnapshot> boardHistory; 
+    static constexpr int HISTORY_KEYFRAME_INTERVAL = 64;
+    std::vector<PlyRecord> plyHistory;             // [0] = initial position
+    std::vector<PieceDelta> pieceDeltas;           // Shared by all plies, so no allocation per ply
+    std::vector<PackedPiece> keyframes;            // pieces.size() entries per HISTORY_KEYFRAME_INTERVAL plies
+    std::vector<PackedPiece> historyTip;           // Pieces at the last recorded ply, to diff against
     BoardSnapshot savedLiveSnapshot; // Saved when entering review mode 
     bool hasSavedLiveState = false; 
 
@@ -112,6 +168,21 @@ private:
 
     std::string posToUCI(Vector2 pos) const; // Converts pixel position to UCI square "e4"
 
+    // Same game as a Position, replayed from uciMoveList after every completed move
+    Position livePosition;
+    std::size_t livePositionPlies = 0;
+    bool livePositionValid = true;
+    Tablebase *tablebase = nullptr;
+
+    // livePosition's key after every ply, [0] = start. Repetitions are found
+    // by looking back over the plies since the last capture or pawn move.
+    std::vector<uint64_t> positionKeys;
+
+    void SyncLivePosition();
+    void CheckDrawRules();
+    void CheckTablebaseAdjudication();
+    bool HasMatingMaterial(int color) const;
+
     // Helper function for blur effect
     void DrawBlurredRectangle(float x, float y,float width, float height, Color baseColor, int blurLayers = 8);
 
@@ -121,6 +192,10 @@ public:
     bool Stalemate = false;
     bool Resigned = false;
     int resignedPlayer = -1; // Color that resigned: 0 = black , 1 = white , -1 = nobody
+    bool Adjudicated = false;    // Game ended by the tablebase
+    int adjudicatedWinner = -1;  // 0 = black, 1 = white, -1 = draw
+    bool adjudicateTablebaseWins = true; // Off in engine games so the win has to be played out
+    bool adjudicatedOnTime = false;      // Adjudicated because a clock ran out
 
     bool Cwhite = false;
 
@@ -158,23 +233,40 @@ public:
     void DrawValidMoveHighlights(); // Draw the valid move indicators
     void ClearSelection();          // Clear selected piece and valid moves
     void DrawCheckHighlight();      // Draws a crimson glow under the king when in ckeck 
+    void DrawMoveArrow(int fromSquare, int toSquare, Color color); // Squares a1 = 0 (Position numbering)
+
+    void DrawMoveHistory(int reviewIndex = -1, float panelY = 55.0f, float panelHeight = 910.0f); // renders the side panel 
 
-    void DrawMoveHistory(int reviewIndex = -1); // renders the side panel 
+    // Game analysis results for the move history panel
+    void SetPositionEval(const PositionEval &eval) { moveHistory.SetPositionEval(eval); }
+    void SetAnalysisProgress(int done, int total) { moveHistory.SetAnalysisProgress(done, total); }
     
     bool ApplyEngineMove(const EngineMove& move); // Executes the engine move
+    bool ApplyUciMove(const std::string &uci);    // Same, from a UCI string like "e7e8q"
+    bool ReplayMoves(const std::vector<std::string> &uciMoves); // Reset, then ApplyUciMove each; false if one fails
     std::vector<std::string> uciMoveList;       // all MOves in UCI format: "e2e4", "e7e5"
     
-    void SaveBoardSnapshot(); 
+    void SaveBoardSnapshot(); // Records the current state as the next ply of the history
     void RestoreBoardSnapshot(const BoardSnapshot &snap); 
+    void RestorePly(int ply);  // Nearest keyframe, then the deltas up to ply
+    void UnpackPiece(const PackedPiece &packed, Piece &piece); // Texture from promotionTexture if the type changed
     void TakeLiveSnapshot(); // Save current state for latter restoration
     void RestoreLiveSnapshot(); // Restore the saved live state
-    int GetSnapshotCount() const { return static_cast<int>(boardHistory.size()); }
+    int GetSnapshotCount() const { return static_cast<int>(plyHistory.size()); }
 
     bool IsReviewing() const {return isReviewing;}
     int GetReviewIndex() const {return reviewMoveIndex;}
     int GetCurrentMoveCount() const {return static_cast<int>(uciMoveList.size()); }
     Vector2 GetPlayerTurnPosition() const { return playerturnPosition; }
 
+    void SetTablebase(Tablebase *tb) { tablebase = tb; }
+    const Position &GetLivePosition() const { return livePosition; }
+    std::size_t GetLivePlies() const { return livePositionPlies; } // Finished plies; a promotion counts once its piece is picked
+    uint64_t GetPositionKey(std::size_t plies) const { return positionKeys[plies]; } // Key after that many plies, 0 = start
+
+    // flaggedColor ran out of time: the other side wins if it could still mate
+    void AdjudicateTimeout(int flaggedColor);
+
     void GoToMove(int moveIndex);
     void GoForwardOne(); 
     void GoBackOne(); 
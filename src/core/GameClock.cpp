@@ -0,0 +1,88 @@
+#include "GameClock.hpp"
+#include <algorithm>
+
+void GameClock::Setup(int initialMs, int incrementMs)
+{
+    this->enabled = initialMs > 0;
+    this->initialMs = std::max(0, initialMs);
+    this->incrementMs = std::max(0, incrementMs);
+    Reset();
+}
+
+void GameClock::Reset()
+{
+    remainingMs[0] = remainingMs[1] = initialMs;
+    sideToMove = 1;
+    started = false;
+    running = false;
+}
+
+void GameClock::Restore(int whiteMs, int blackMs, int toMove)
+{
+    if (!enabled)
+        return;
+
+    remainingMs[1] = whiteMs;
+    remainingMs[0] = blackMs;
+    sideToMove = toMove;
+    started = true;
+    running = false;
+}
+
+long long GameClock::RunningElapsedMs() const
+{
+    if (!running)
+        return 0;
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - turnStart).count();
+}
+
+void GameClock::Press(int color)
+{
+    if (!enabled)
+        return;
+
+    // Charge the move that just finished; the free first move gets no increment
+    if (started && color == sideToMove)
+    {
+        remainingMs[color] -= RunningElapsedMs();
+        if (remainingMs[color] > 0)
+            remainingMs[color] += incrementMs;
+    }
+
+    sideToMove = 1 - color;
+    started = true;
+    running = true;
+    turnStart = Clock::now();
+}
+
+void GameClock::SetRunning(bool run)
+{
+    if (!enabled || !started || run == running)
+        return;
+
+    if (run)
+    {
+        turnStart = Clock::now();
+    }
+    else
+    {
+        remainingMs[sideToMove] -= RunningElapsedMs();
+    }
+    running = run;
+}
+
+int GameClock::RemainingMs(int color) const
+{
+    long long left = remainingMs[color];
+    if (color == sideToMove)
+        left -= RunningElapsedMs();
+    return static_cast<int>(std::max(0LL, left));
+}
+
+bool GameClock::Flagged(int &color) const
+{
+    if (!enabled || RemainingMs(sideToMove) > 0)
+        return false;
+    color = sideToMove;
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef GAME_CLOCK_HPP
+#define GAME_CLOCK_HPP
+
+#include <chrono>
+
+// GameClock - chess clock with a base time and a per-move increment for each
+// side. Colours follow the rest of the game: 0 = black, 1 = white.
+// Time is measured with steady_clock, so frame rate and pauses in the render
+// loop do not matter; only the running side's time goes down.
+
+class GameClock
+{
+public:
+    // initialMs <= 0 turns the clock off (untimed game)
+    void Setup(int initialMs, int incrementMs);
+
+    // Back to the starting times, stopped, white to move
+    void Reset();
+
+    // Picks up a saved game: times left and the side to move, stopped until
+    // SetRunning. Call after Setup.
+    void Restore(int whiteMs, int blackMs, int toMove);
+
+    bool Enabled() const { return enabled; }
+    int IncrementMs() const { return incrementMs; }
+    int InitialMs() const { return initialMs; }
+
+    // `color` finished a move: its time is charged, the increment added and
+    // the other side's time starts running. The first press starts the clock.
+    void Press(int color);
+
+    // Stops or resumes the side to move (pause menu, game over). Idempotent,
+    // and a no-op until the first Press, so white's first move is free.
+    void SetRunning(bool run);
+    bool Running() const { return running; }
+
+    int SideToMove() const { return sideToMove; }
+
+    // Time left for `color`, including the move in progress. Never negative.
+    int RemainingMs(int color) const;
+
+    // True once the side to move has run out; sets color to that side
+    bool Flagged(int &color) const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    bool enabled = false;
+    int initialMs = 0;
+    int incrementMs = 0;
+    long long remainingMs[2] = {0, 0}; // Charged time only, not the running move
+    int sideToMove = 1;
+    bool started = false;
+    bool running = false;
+    Clock::time_point turnStart;
+
+    long long RunningElapsedMs() const;
+};
+
+#endif // GAME_CLOCK_HPP
@@ -0,0 +1,221 @@
+#include "GameDatabase.hpp"
+#include "Position.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+
+uint64_t ReadU64(const unsigned char *at)
+{
+    uint64_t value;
+    std::memcpy(&value, at, sizeof(value));
+    return value;
+}
+
+uint32_t ReadU32(const unsigned char *at)
+{
+    uint32_t value;
+    std::memcpy(&value, at, sizeof(value));
+    return value;
+}
+
+// Value of a tag in "[Name \"Value\"]" lines, with \" and \\ unescaped
+std::string FindTag(const std::string &text, const std::string &name)
+{
+    std::string prefix = "[" + name + " \"";
+    std::size_t at = text.find(prefix);
+    while (at != std::string::npos && at != 0 && text[at - 1] != '\n')
+        at = text.find(prefix, at + 1);
+    if (at == std::string::npos)
+        return std::string();
+
+    std::string value;
+    for (std::size_t i = at + prefix.size(); i < text.size() && text[i] != '"'; i++)
+    {
+        if (text[i] == '\\' && i + 1 < text.size())
+            i++;
+        value += text[i];
+    }
+    return value;
+}
+
+} // namespace
+
+double PositionStats::WhiteScore() const
+{
+    uint64_t decided = whiteWins + draws + blackWins;
+    return decided ? 100.0 * (whiteWins + 0.5 * draws) / decided : 0.0;
+}
+
+bool GameDatabase::OpenPart(MappedFile &file, const std::string &path, const char *magic, uint64_t &count,
+                            uint64_t &tableOffset)
+{
+    if (!file.Open(path))
+        return false;
+
+    GameDbHeader header;
+    if (file.Size() < sizeof(header))
+        return false;
+    std::memcpy(&header, file.Data(), sizeof(header));
+    if (std::memcmp(header.magic, magic, 4) != 0 || header.version != GAMEDB_VERSION ||
+        header.tableOffset < sizeof(header) || header.tableOffset > file.Size())
+        return false;
+
+    count = header.count;
+    tableOffset = header.tableOffset;
+    return true;
+}
+
+bool GameDatabase::Open(const std::string &basePath)
+{
+    Close();
+
+    uint64_t headerCount = 0, gamesTable = 0, headersTable = 0, entriesAt = 0, recordsAt = 0;
+    bool valid = OpenPart(games, basePath + ".games", "CGDG", gameCount, gamesTable) &&
+                 OpenPart(headers, basePath + ".headers", "CGDH", headerCount, headersTable) &&
+                 OpenPart(index, basePath + ".index", "CGDI", entryCount, entriesAt) &&
+                 OpenPart(stats, basePath + ".stats", "CGDS", keyCount, recordsAt);
+
+    // Sizes are checked once here, so lookups only need to trust the bucket
+    // table and the entry range of each record
+    valid = valid && headerCount == gameCount && gameCount <= GAMEDB_MAX_GAMES &&
+            (games.Size() - gamesTable) / 8 >= gameCount + 1 &&
+            (headers.Size() - headersTable) / 8 >= gameCount + 1 &&
+            entriesAt == sizeof(GameDbHeader) &&
+            (index.Size() - entriesAt) / GAMEDB_ENTRY_SIZE >= entryCount &&
+            recordsAt == sizeof(GameDbHeader) + 8 * static_cast<uint64_t>(GAMEDB_BUCKETS + 1) &&
+            (stats.Size() - recordsAt) / GAMEDB_STATS_SIZE >= keyCount &&
+            ReadU64(stats.Data() + sizeof(GameDbHeader) + 8 * static_cast<uint64_t>(GAMEDB_BUCKETS)) == keyCount;
+    if (!valid)
+    {
+        std::cerr << "GameDatabase: " << basePath << " is missing, damaged or from another version" << std::endl;
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void GameDatabase::Close()
+{
+    games.Close();
+    headers.Close();
+    index.Close();
+    stats.Close();
+    gameCount = 0;
+    entryCount = 0;
+    keyCount = 0;
+}
+
+void GameDatabase::Lookup(uint64_t key, std::size_t maxIds, PositionStats &out) const
+{
+    out = PositionStats();
+    if (!IsOpen())
+        return;
+
+    // The bucket narrows the search to about keys / 65536; keys are hashes,
+    // so a binary search over that is a handful of cache misses
+    const unsigned char *buckets = stats.Data() + sizeof(GameDbHeader);
+    const unsigned char *records = buckets + 8 * static_cast<uint64_t>(GAMEDB_BUCKETS + 1);
+    uint64_t bucket = key >> 48;
+    uint64_t lo = ReadU64(buckets + 8 * bucket);
+    uint64_t hi = ReadU64(buckets + 8 * (bucket + 1));
+    if (lo > hi || hi > keyCount)
+        return;
+
+    while (lo < hi)
+    {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (ReadU64(records + mid * GAMEDB_STATS_SIZE) < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    const unsigned char *record = records + lo * GAMEDB_STATS_SIZE;
+    if (lo == keyCount || ReadU64(record) != key)
+        return;
+
+    uint64_t first = ReadU64(record + 8);
+    uint64_t games = ReadU32(record + 16);
+    if (first > entryCount || games > entryCount - first)
+        return;
+
+    out.games = games;
+    out.whiteWins = ReadU32(record + 20);
+    out.draws = ReadU32(record + 24);
+    out.blackWins = ReadU32(record + 28);
+
+    // Entries of one key are sorted by game id
+    const unsigned char *entries = index.Data() + sizeof(GameDbHeader);
+    uint64_t listed = std::min<uint64_t>(games, maxIds);
+    out.gameIds.reserve(static_cast<std::size_t>(listed));
+    for (uint64_t i = 0; i < listed; i++)
+        out.gameIds.push_back(ReadU32(entries + (first + i) * GAMEDB_ENTRY_SIZE + 8) >> 2);
+}
+
+bool GameDatabase::Blob(const MappedFile &file, uint64_t count, uint32_t id, const unsigned char *&data,
+                        std::size_t &size)
+{
+    if (id >= count)
+        return false;
+
+    GameDbHeader header;
+    std::memcpy(&header, file.Data(), sizeof(header));
+    const unsigned char *offsets = file.Data() + header.tableOffset;
+    uint64_t begin = ReadU64(offsets + 8 * static_cast<uint64_t>(id));
+    uint64_t end = ReadU64(offsets + 8 * (static_cast<uint64_t>(id) + 1));
+    if (begin > end || end > header.tableOffset)
+        return false;
+
+    data = file.Data() + begin;
+    size = static_cast<std::size_t>(end - begin);
+    return true;
+}
+
+int GameDatabase::Result(uint32_t id) const
+{
+    const unsigned char *data;
+    std::size_t size;
+    if (!Blob(games, gameCount, id, data, size) || size < 2)
+        return GAMEDB_UNKNOWN;
+    return data[0] & 3;
+}
+
+std::string GameDatabase::Headers(uint32_t id) const
+{
+    const unsigned char *data;
+    std::size_t size;
+    if (!Blob(headers, gameCount, id, data, size))
+        return std::string();
+    return std::string(reinterpret_cast<const char *>(data), size);
+}
+
+std::string GameDatabase::Tag(uint32_t id, const std::string &name) const
+{
+    return FindTag(Headers(id), name);
+}
+
+bool GameDatabase::Moves(uint32_t id, std::vector<std::string> &uciMoves) const
+{
+    uciMoves.clear();
+    const unsigned char *data;
+    std::size_t size;
+    if (!Blob(games, gameCount, id, data, size) || size < 2)
+        return false;
+
+    Position pos = Position::StartPosition();
+    if ((data[1] & GAMEDB_FLAG_FEN) && !pos.SetFromFEN(Tag(id, "FEN")))
+        return false;
+
+    MoveList legal;
+    for (std::size_t i = 2; i < size; i++)
+    {
+        pos.GenerateLegalMoves(legal);
+        if (data[i] >= legal.count)
+            return false;
+        uciMoves.push_back(Position::ToUCI(legal.moves[data[i]]));
+        pos.MakeMove(legal.moves[data[i]]);
+    }
+    return true;
+}
@@ -0,0 +1,105 @@
+#ifndef GAME_DATABASE_HPP
+#define GAME_DATABASE_HPP
+
+#include "MappedFile.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// GameDatabase - read side of the game database built by tools/gamedb.
+// All four files are memory-mapped, so opening is cheap and a lookup only
+// touches the pages it reads.
+//
+// base.games    GameDbHeader ("CGDG"), then per game: result, flags and one
+//               byte per ply (the move's index among the legal moves, as in
+//               SavedGame), then count + 1 u64 offsets at tableOffset
+// base.headers  GameDbHeader ("CGDH"), then per game its PGN tag pairs as
+//               text (values escaped as in PGN, control characters as
+//               spaces), then count + 1 u64 offsets at tableOffset
+// base.index    GameDbHeader ("CGDI"), then count 12-byte entries sorted by
+//               key and game id: u64 Polyglot key, u32 game id << 2 | result
+// base.stats    GameDbHeader ("CGDS"), then 65537 u64 bucket starts by the
+//               top 16 bits of the key, then one 32-byte record per distinct
+//               key, sorted: u64 key, u64 its first entry in base.index, u32
+//               games, white wins, draws, black wins
+//
+// Every position a game reached, the start included, is indexed once per
+// game. The totals are summed when the database is built, so a lookup costs
+// the same for the start position as for a position seen in one game.
+
+constexpr uint32_t GAMEDB_VERSION = 3; // 2: Polyglot Random64 keys, 3: base.stats
+constexpr uint32_t GAMEDB_MAX_GAMES = 1u << 30; // Ids share a u32 with the result
+constexpr int GAMEDB_BUCKETS = 1 << 16;
+constexpr std::size_t GAMEDB_ENTRY_SIZE = 12;
+constexpr std::size_t GAMEDB_STATS_SIZE = 32;
+constexpr uint8_t GAMEDB_FLAG_FEN = 1;          // Starts from the FEN tag, not the start position
+
+enum GameDbResult
+{
+    GAMEDB_WHITE_WINS = 0,
+    GAMEDB_DRAW = 1,
+    GAMEDB_BLACK_WINS = 2,
+    GAMEDB_UNKNOWN = 3 // "*" or missing
+};
+
+struct GameDbHeader
+{
+    char magic[4];        // "CGDG", "CGDH", "CGDI" or "CGDS"
+    uint32_t version;     // GAMEDB_VERSION
+    uint64_t count;       // Games, index entries or distinct keys
+    uint64_t tableOffset; // Byte offset of the offsets table, the index entries or the stats records
+};
+
+struct PositionStats
+{
+    uint64_t games = 0;
+    uint64_t whiteWins = 0;
+    uint64_t draws = 0;
+    uint64_t blackWins = 0;
+    std::vector<uint32_t> gameIds; // Ascending, at most the maxIds asked for
+
+    // White's score in percent over the decided and drawn games
+    double WhiteScore() const;
+};
+
+class GameDatabase
+{
+private:
+    MappedFile games;
+    MappedFile headers;
+    MappedFile index;
+    MappedFile stats;
+    uint64_t gameCount = 0;
+    uint64_t entryCount = 0;
+    uint64_t keyCount = 0;
+
+    static bool OpenPart(MappedFile &file, const std::string &path, const char *magic, uint64_t &count,
+                         uint64_t &tableOffset);
+    static bool Blob(const MappedFile &file, uint64_t count, uint32_t id, const unsigned char *&data,
+                     std::size_t &size);
+
+public:
+    // Opens base.games, base.headers, base.index and base.stats; false if any is missing or damaged
+    bool Open(const std::string &basePath);
+    void Close();
+
+    bool IsOpen() const { return index.IsOpen(); }
+    uint64_t GameCount() const { return gameCount; }
+    uint64_t EntryCount() const { return entryCount; }
+    uint64_t KeyCount() const { return keyCount; }
+
+    // Totals over every game that reached the position with this key, and
+    // the ids of the first maxIds of them. O(log keys) plus maxIds entry reads.
+    void Lookup(uint64_t key, std::size_t maxIds, PositionStats &out) const;
+
+    int Result(uint32_t id) const; // GameDbResult
+    std::string Headers(uint32_t id) const;
+
+    // Tag value from Headers(id), or an empty string
+    std::string Tag(uint32_t id, const std::string &name) const;
+
+    // The game's moves in UCI; false if the id is out of range or the moves do not replay
+    bool Moves(uint32_t id, std::vector<std::string> &uciMoves) const;
+};
+
+#endif // GAME_DATABASE_HPP
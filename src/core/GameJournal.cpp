@@ -0,0 +1,287 @@
+#include "GameJournal.hpp"
+#include "Position.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+typedef std::chrono::steady_clock Clock;
+
+const char MAGIC[4] = {'C', 'J', 'N', 'L'};
+const uint16_t VERSION = 1;
+const uint16_t HEADER_SIZE = 24;
+const std::size_t RECORD_SIZE = 32;
+const uint8_t FLAG_VS_ENGINE = 1;
+
+uint32_t Fnv1a(const uint8_t *data, std::size_t size)
+{
+    uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < size; i++)
+    {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void Put(std::vector<uint8_t> &out, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+}
+
+uint64_t Get(const uint8_t *in, int bytes)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++)
+        value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    return value;
+}
+
+// fdatasync still flushes the size change of an append, which reading the record back needs;
+// it only skips metadata such as the modification time
+bool SyncFile(std::FILE *f)
+{
+#if defined(_WIN32)
+    return _commit(_fileno(f)) == 0;
+#elif defined(__APPLE__)
+    return fsync(fileno(f)) == 0;
+#else
+    return fdatasync(fileno(f)) == 0;
+#endif
+}
+
+// "e7" -> 52 (a1 = 0)
+uint8_t SquareOf(const char *uci)
+{
+    return static_cast<uint8_t>((uci[0] - 'a') + 8 * (uci[1] - '1'));
+}
+
+} // namespace
+
+constexpr int GameJournal::SYNC_INTERVAL_MS; // Bound by reference in std::chrono::milliseconds, so C++14 needs the definition
+
+void GameJournal::Open(const std::string &journalPath, const SavedGame &game)
+{
+    Close(true);
+
+    path = journalPath;
+    header.clear();
+    header.insert(header.end(), MAGIC, MAGIC + 4);
+    Put(header, VERSION, 2);
+    Put(header, HEADER_SIZE, 2);
+    Put(header, game.vsEngine ? FLAG_VS_ENGINE : 0, 1);
+    Put(header, static_cast<uint8_t>(game.engineColor), 1);
+    Put(header, static_cast<uint8_t>(game.skillLevel), 1);
+    Put(header, 0, 1);
+    Put(header, static_cast<uint32_t>(game.clockInitialMs), 4);
+    Put(header, static_cast<uint32_t>(game.clockIncrementMs), 4);
+    Put(header, static_cast<uint64_t>(game.savedAt), 8);
+    Put(header, Fnv1a(header.data(), header.size()), 4);
+
+    nextPly = 0;
+    stopping = false;
+    writer = std::thread(&GameJournal::WriterLoop, this);
+}
+
+void GameJournal::Append(const std::string &uci, int whiteMs, int blackMs, uint64_t key)
+{
+    if (!IsOpen() || uci.size() < 4 || uci.size() > 5)
+        return;
+
+    Record record;
+    record.ply = nextPly++;
+    std::memcpy(record.uci, uci.c_str(), uci.size());
+    record.whiteMs = whiteMs;
+    record.blackMs = blackMs;
+    record.key = key;
+
+    // 256 queued plies means the disk has stalled for minutes; wait rather than drop one
+    while (!queue.Push(record))
+        std::this_thread::yield();
+
+    // Taking the lock orders the push before the writer's check of the queue
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+    }
+    wake.notify_one();
+}
+
+void GameJournal::Close(bool keepFile)
+{
+    if (!IsOpen())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    writer.join();
+
+    if (!keepFile)
+        std::remove(path.c_str());
+}
+
+void GameJournal::WriterLoop()
+{
+    std::FILE *f = std::fopen(path.c_str(), "wb");
+    if (f == nullptr || std::fwrite(header.data(), 1, header.size(), f) != header.size() ||
+        std::fflush(f) != 0 || !SyncFile(f))
+    {
+        std::cerr << "GameJournal: Could not create " << path << ", this game is not journaled" << std::endl;
+        if (f != nullptr)
+            std::fclose(f);
+        f = nullptr;
+    }
+
+    std::vector<uint8_t> batch;
+    int unsynced = 0;
+    Clock::time_point oldestUnsynced;
+    for (;;)
+    {
+        {
+            Clock::time_point deadline = unsynced > 0 ? oldestUnsynced + std::chrono::milliseconds(SYNC_INTERVAL_MS)
+                                                      : Clock::now() + std::chrono::milliseconds(SYNC_INTERVAL_MS);
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wake.wait_until(lock, deadline, [this] { return stopping.load() || !queue.Empty(); });
+        }
+
+        // Read before draining: everything pushed before Close() is in the queue by now
+        bool stop = stopping.load();
+
+        batch.clear();
+        Record record;
+        while (queue.Pop(record))
+        {
+            std::size_t at = batch.size();
+            uint8_t from = SquareOf(record.uci);
+            uint8_t to = SquareOf(record.uci + 2);
+            Put(batch, record.ply, 4);
+            Put(batch, from, 1);
+            Put(batch, to, 1);
+            Put(batch, static_cast<uint8_t>(record.uci[4]), 1);
+            Put(batch, 0, 1);
+            Put(batch, static_cast<uint32_t>(record.whiteMs), 4);
+            Put(batch, static_cast<uint32_t>(record.blackMs), 4);
+            Put(batch, record.key, 8);
+            Put(batch, 0, 4);
+            Put(batch, Fnv1a(&batch[at], batch.size() - at), 4);
+        }
+
+        // Handing the batch to the OS already survives a crash of this process;
+        // the sync is what makes it survive a power loss, so it is batched
+        if (f != nullptr && !batch.empty())
+        {
+            if (std::fwrite(batch.data(), 1, batch.size(), f) != batch.size() || std::fflush(f) != 0)
+            {
+                std::cerr << "GameJournal: Could not write " << path << ", journaling stopped" << std::endl;
+                std::fclose(f);
+                f = nullptr;
+            }
+            else
+            {
+                if (unsynced == 0)
+                    oldestUnsynced = Clock::now();
+                unsynced += static_cast<int>(batch.size() / RECORD_SIZE);
+            }
+        }
+
+        if (f != nullptr && unsynced > 0 &&
+            (stop || unsynced >= SYNC_EVERY_RECORDS ||
+             Clock::now() - oldestUnsynced >= std::chrono::milliseconds(SYNC_INTERVAL_MS)))
+        {
+            SyncFile(f);
+            unsynced = 0;
+        }
+
+        if (stop)
+            break;
+    }
+
+    if (f != nullptr)
+        std::fclose(f);
+}
+
+bool GameJournal::Recover(const std::string &journalPath, SavedGame &game)
+{
+    std::FILE *f = std::fopen(journalPath.c_str(), "rb");
+    if (f == nullptr)
+        return false;
+
+    std::vector<uint8_t> data;
+    uint8_t chunk[4096];
+    std::size_t got;
+    while ((got = std::fread(chunk, 1, sizeof(chunk), f)) > 0)
+        data.insert(data.end(), chunk, chunk + got);
+    std::fclose(f);
+
+    if (data.size() < 8 + HEADER_SIZE || std::memcmp(data.data(), MAGIC, 4) != 0)
+    {
+        std::cerr << "GameJournal: " << journalPath << " is not a game journal" << std::endl;
+        return false;
+    }
+    uint16_t version = static_cast<uint16_t>(Get(&data[4], 2));
+    uint16_t headerSize = static_cast<uint16_t>(Get(&data[6], 2));
+    std::size_t recordsAt = 8 + static_cast<std::size_t>(headerSize);
+    if (version > VERSION || headerSize < HEADER_SIZE || recordsAt > data.size() ||
+        Get(&data[recordsAt - 4], 4) != Fnv1a(data.data(), recordsAt - 4))
+    {
+        std::cerr << "GameJournal: " << journalPath << " is damaged or from a newer version" << std::endl;
+        return false;
+    }
+
+    // A crash can tear the last record; everything before the first bad one is kept
+    SavedGame recovered;
+    Position pos = Position::StartPosition();
+    for (std::size_t at = recordsAt; at + RECORD_SIZE <= data.size(); at += RECORD_SIZE)
+    {
+        const uint8_t *record = &data[at];
+        if (Get(record + 28, 4) != Fnv1a(record, 28) || Get(record, 4) != recovered.uciMoves.size())
+            break;
+
+        int from = record[4], to = record[5];
+        if (from > 63 || to > 63)
+            break;
+        std::string uci;
+        uci += static_cast<char>('a' + from % 8);
+        uci += static_cast<char>('1' + from / 8);
+        uci += static_cast<char>('a' + to % 8);
+        uci += static_cast<char>('1' + to / 8);
+        if (record[6] != 0)
+            uci += static_cast<char>(record[6]);
+
+        Move move;
+        if (!pos.ParseUCI(uci, move))
+            break;
+        pos.MakeMove(move);
+        if (pos.Key() != Get(record + 16, 8))
+            break;
+
+        recovered.uciMoves.push_back(uci);
+        recovered.whiteClockMs = static_cast<int>(Get(record + 8, 4));
+        recovered.blackClockMs = static_cast<int>(Get(record + 12, 4));
+    }
+
+    if (recovered.uciMoves.empty())
+        return false;
+
+    const uint8_t *header = &data[8];
+    recovered.vsEngine = (header[0] & FLAG_VS_ENGINE) != 0;
+    recovered.engineColor = header[1] ? 1 : 0;
+    recovered.skillLevel = header[2];
+    recovered.clockInitialMs = static_cast<int>(Get(header + 4, 4));
+    recovered.clockIncrementMs = static_cast<int>(Get(header + 8, 4));
+    recovered.savedAt = static_cast<int64_t>(Get(header + 12, 8));
+    game = recovered;
+    return true;
+}
@@ -0,0 +1,80 @@
+#ifndef GAME_JOURNAL_HPP
+#define GAME_JOURNAL_HPP
+
+#include "SavedGame.hpp"
+#include "SpscQueue.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// GameJournal - append-only log of the game being played, so a crash or power
+// loss costs at most the last second of moves. Open() and Append() only queue
+// work; a writer thread owns the file, appends each ply as a fixed 32-byte
+// record and syncs it to disk in batches. Close() removes the journal of a
+// game that ended normally; one left behind on startup was interrupted.
+//
+// Layout, little-endian: "CJNL", u16 version, u16 header size, header
+// (mode, engine side and strength, clock settings, start time, u32 FNV-1a),
+// then per ply: u32 ply, from, to, promotion char, u8 0, u32 white ms,
+// u32 black ms, u64 Polyglot key after the move, u32 0, u32 FNV-1a.
+
+class GameJournal
+{
+public:
+    GameJournal() = default;
+    ~GameJournal() { Close(true); }
+
+    GameJournal(const GameJournal &) = delete;
+    GameJournal &operator=(const GameJournal &) = delete;
+
+    // Starts a journal at path, replacing any file there. Only the mode and
+    // clock settings of game are used; its moves are appended like any other.
+    void Open(const std::string &path, const SavedGame &game);
+
+    // One more ply: its UCI move, the clocks after it and the position key
+    // after it. Never waits for the disk.
+    void Append(const std::string &uci, int whiteMs, int blackMs, uint64_t key);
+
+    // Writes and syncs what is queued, then stops the writer. The file is
+    // deleted unless keepFile, so only interrupted games leave one.
+    void Close(bool keepFile);
+
+    bool IsOpen() const { return writer.joinable(); }
+
+    // Reads the journal at path into game: its settings, and the moves up to
+    // the first record that is torn, out of order or does not replay to its
+    // key. The clocks are those of the last good record. False if there is no
+    // journal or it holds no moves.
+    static bool Recover(const std::string &path, SavedGame &game);
+
+private:
+    struct Record
+    {
+        uint32_t ply = 0;
+        char uci[6] = {};
+        int whiteMs = 0;
+        int blackMs = 0;
+        uint64_t key = 0;
+    };
+
+    static constexpr int SYNC_EVERY_RECORDS = 16; // Sync after this many unsynced records...
+    static constexpr int SYNC_INTERVAL_MS = 1000; // ...or once the oldest has waited this long
+
+    SpscQueue<Record, 256> queue;
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::atomic<bool> stopping{false};
+    std::thread writer;
+
+    std::string path;
+    std::vector<uint8_t> header; // Encoded by Open(), written by the writer
+    uint32_t nextPly = 0;        // Owned by the producer
+
+    void WriterLoop();
+};
+
+#endif // GAME_JOURNAL_HPP
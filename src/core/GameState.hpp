@@ -15,7 +15,13 @@ enum class GamePhase
     PAUSED,
     CHECKMATE,
     STALEMATE,
-    PROMOTION
+    PROMOTION,
+    TABLEBASE_DRAW,
+    TABLEBASE_WIN,
+    TIME_FORFEIT,
+    REPETITION_DRAW,
+    FIFTY_MOVE_DRAW,
+    INSUFFICIENT_MATERIAL_DRAW
 };
 
 class GameState
@@ -0,0 +1,131 @@
+#include "Kpk.hpp"
+
+using namespace PositionCodes;
+
+namespace
+{
+    constexpr int KPK_WORDS = 2 * 64 * 64 * 24 / 32;
+
+    // One bit per position, 1 = the side with the pawn wins (see tools/kpkgen.cpp)
+    const uint32_t kpkBits[KPK_WORDS] = {
+#include "KpkTable.inc"
+    };
+
+    bool IsKpk(const Position &pos, int &strongSide)
+    {
+        int pawns[2] = {pos.PieceCount(0, PAWN), pos.PieceCount(1, PAWN)};
+        if (pawns[0] + pawns[1] != 1)
+            return false;
+        for (int color = 0; color < 2; color++)
+        {
+            for (int type = ROOK; type <= QUEEN; type++)
+            {
+                if (pos.PieceCount(color, type) != 0)
+                    return false;
+            }
+        }
+        strongSide = pawns[1] ? 1 : 0;
+        return true;
+    }
+
+    bool ProbeBit(const Position &pos, int strongSide)
+    {
+        int pawn = -1;
+        for (int sq = 0; sq < 64; sq++)
+        {
+            if (TypeOf(pos.PieceAt(sq)) == PAWN)
+            {
+                pawn = sq;
+                break;
+            }
+        }
+
+        // Normalise so the pawn is white and on files a-d
+        int strongKing = pos.KingSquare(strongSide);
+        int weakKing = pos.KingSquare(1 - strongSide);
+        if (strongSide == 0)
+        {
+            pawn ^= 56;
+            strongKing ^= 56;
+            weakKing ^= 56;
+        }
+        if (FileOf(pawn) > 3)
+        {
+            pawn ^= 7;
+            strongKing ^= 7;
+            weakKing ^= 7;
+        }
+
+        int pawnIndex = FileOf(pawn) * 6 + (RankOf(pawn) - 1);
+        int index = (pos.SideToMove() == strongSide ? 0 : 1) | (weakKing << 1) | (strongKing << 7) | (pawnIndex << 13);
+        return (kpkBits[index >> 5] >> (index & 31)) & 1;
+    }
+}
+
+bool Kpk::Probe(const Position &pos, int &wdl)
+{
+    int strongSide;
+    if (!IsKpk(pos, strongSide))
+        return false;
+
+    if (!ProbeBit(pos, strongSide))
+        wdl = 0;
+    else
+        wdl = (pos.SideToMove() == strongSide) ? 1 : -1;
+    return true;
+}
+
+bool Kpk::FindWinningPush(const Position &pos, Move &out)
+{
+    int wdl;
+    if (!Probe(pos, wdl) || wdl != 1)
+        return false;
+
+    MoveList moves;
+    pos.GenerateLegalMoves(moves);
+
+    bool found = false;
+    int bestAdvance = 0;
+    for (const Move &m : moves)
+    {
+        if (TypeOf(pos.PieceAt(m.from)) != PAWN)
+            continue;
+
+        Position next = pos;
+        if (m.promotion != 0)
+        {
+            if (m.promotion != QUEEN)
+                continue;
+            next.MakeMove(m);
+
+            // The new queen must survive and must not stalemate
+            MoveList replies;
+            next.GenerateLegalMoves(replies);
+            if (replies.count == 0 && !next.InCheck())
+                continue;
+            bool hangs = false;
+            for (const Move &reply : replies)
+                hangs |= (reply.to == m.to);
+            if (hangs)
+                continue;
+        }
+        else
+        {
+            next.MakeMove(m);
+            int childWdl;
+            if (!Probe(next, childWdl) || childWdl != -1)
+                continue;
+        }
+
+        int advance = m.to > m.from ? m.to - m.from : m.from - m.to;
+        if (m.promotion != 0)
+            advance = 64;
+        if (advance > bestAdvance)
+        {
+            bestAdvance = advance;
+            out = m;
+            found = true;
+        }
+    }
+    return found;
+}
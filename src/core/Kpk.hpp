@@ -0,0 +1,20 @@
+#ifndef KPK_HPP
+#define KPK_HPP
+
+#include "Position.hpp"
+
+// Kpk - king + pawn vs king bitbase, generated by tools/kpkgen at build time
+// and compiled into the binary (24 KB). Lookups are a single bit test.
+
+namespace Kpk
+{
+    // For KPK positions only: sets wdl (+1 side to move wins, 0 draw,
+    // -1 side to move loses) and returns true. False for any other material.
+    bool Probe(const Position &pos, int &wdl);
+
+    // A pawn push (or safe queen promotion) that keeps a won KPK position won.
+    // Anything that needs king manoeuvring is left to the engine.
+    bool FindWinningPush(const Position &pos, Move &out);
+}
+
+#endif // KPK_HPP
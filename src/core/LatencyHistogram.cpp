@@ -0,0 +1,77 @@
+#include "LatencyHistogram.hpp"
+#include <algorithm>
+#include <cmath>
+
+int LatencyHistogram::BucketOf(uint64_t value)
+{
+    if (value < static_cast<uint64_t>(2 * SUB_COUNT))
+        return static_cast<int>(value);
+
+    // Shift the value down until it has SUB_BITS + 1 significant bits
+    int msb = 63;
+    while (!(value >> msb))
+        msb--;
+    int shift = msb - SUB_BITS;
+    if (shift > MAX_SHIFT)
+        return BUCKETS - 1;
+
+    int sub = static_cast<int>(value >> shift) - SUB_COUNT;
+    return 2 * SUB_COUNT + (shift - 1) * SUB_COUNT + sub;
+}
+
+uint64_t LatencyHistogram::BucketTop(int index)
+{
+    if (index < 2 * SUB_COUNT)
+        return static_cast<uint64_t>(index);
+
+    int shift = (index - 2 * SUB_COUNT) / SUB_COUNT + 1;
+    uint64_t sub = static_cast<uint64_t>((index - 2 * SUB_COUNT) % SUB_COUNT + SUB_COUNT);
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t value)
+{
+    buckets[BucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t seen = maxValue.load(std::memory_order_relaxed);
+    while (value > seen && !maxValue.compare_exchange_weak(seen, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+void LatencyHistogram::Reset()
+{
+    for (std::atomic<uint64_t> &bucket : buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    count.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    maxValue.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::Mean() const
+{
+    uint64_t n = Count();
+    return n ? static_cast<double>(sum.load(std::memory_order_relaxed)) / n : 0.0;
+}
+
+uint64_t LatencyHistogram::Percentile(double percentile) const
+{
+    uint64_t n = Count();
+    if (n == 0)
+        return 0;
+
+    // Rank of the wanted value, 1-based; a concurrent Record() can only make the buckets hold more
+    percentile = std::min(100.0, std::max(0.0, percentile));
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(percentile / 100.0 * n)));
+
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++)
+    {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank)
+            return std::min(BucketTop(i), Max());
+    }
+    return Max();
+}
@@ -0,0 +1,45 @@
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <atomic>
+#include <cstdint>
+
+// LatencyHistogram - HdrHistogram-style counts of non-negative integers
+// (microseconds, nodes, ...). Values below 128 are exact; larger ones land in
+// one of 64 buckets per power of two, so any percentile is within about 1.6%.
+// Record() is lock-free, so one thread can record while another reports.
+
+class LatencyHistogram
+{
+public:
+    LatencyHistogram() { Reset(); }
+
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    void Record(uint64_t value);
+    void Reset();
+
+    uint64_t Count() const { return count.load(std::memory_order_relaxed); }
+    uint64_t Max() const { return maxValue.load(std::memory_order_relaxed); }
+    double Mean() const;
+
+    // Highest value equivalent to the one at this percentile (0-100), capped at Max()
+    uint64_t Percentile(double percentile) const;
+
+private:
+    static constexpr int SUB_BITS = 6;                   // 64 buckets per power of two
+    static constexpr int SUB_COUNT = 1 << SUB_BITS;
+    static constexpr int MAX_SHIFT = 30;                 // Up to 2^37, anything larger is clamped
+    static constexpr int BUCKETS = 2 * SUB_COUNT + MAX_SHIFT * SUB_COUNT;
+
+    std::atomic<uint64_t> buckets[BUCKETS];
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> maxValue;
+
+    static int BucketOf(uint64_t value);
+    static uint64_t BucketTop(int index); // Largest value that maps to index
+};
+
+#endif // LATENCY_HISTOGRAM_HPP
@@ -0,0 +1,46 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+// MappedFile - memory mapping of a whole file, read-only by default.
+// The OS pages data in on first touch, so opening a large file is cheap and
+// only the parts that are actually read cost memory. OpenWritable maps a
+// file read-write; changes reach the disk without any explicit writes.
+
+class MappedFile
+{
+private:
+    const unsigned char *data = nullptr;
+    std::size_t size = 0;
+    bool writable = false;
+#ifdef _WIN32
+    void *fileHandle = nullptr;
+    void *mappingHandle = nullptr;
+#endif
+
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool Open(const std::string &path);
+
+    // Read-write mapping of exactly size bytes; the file is created or
+    // resized to match
+    bool OpenWritable(const std::string &path, std::size_t size);
+
+    // Asks the OS to start writing dirty pages back (does not wait)
+    void Flush();
+    void Close();
+
+    bool IsOpen() const { return data != nullptr; }
+    const unsigned char *Data() const { return data; }
+    unsigned char *MutableData() { return writable ? const_cast<unsigned char *>(data) : nullptr; }
+    std::size_t Size() const { return size; }
+};
+
+#endif // MAPPED_FILE_HPP
@@ -1,21 +1,167 @@
 #include "MoveHistory.hpp"
 #include "Constants.hpp"
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
 #include <string>
 
 // These are defined in Board.cpp and declared extern in Constants.hpp
 extern float squareSize;
 extern Vector2 boardPosition;
 
+namespace
+{
+
+// Eval drop for the side that moved, in centipawns
+const int INACCURACY_CP = 60;
+const int MISTAKE_CP = 120;
+const int BLUNDER_CP = 300;
+const int EVAL_CLAMP_CP = 1000; // Past this the game is decided; mates count as this
+
+const char *JudgementSuffix(MoveJudgement judgement)
+{
+    switch (judgement)
+    {
+    case MoveJudgement::INACCURACY:
+        return "?!";
+    case MoveJudgement::MISTAKE:
+        return "?";
+    case MoveJudgement::BLUNDER:
+        return "??";
+    default:
+        return "";
+    }
+}
+
+Color JudgementColor(MoveJudgement judgement)
+{
+    switch (judgement)
+    {
+    case MoveJudgement::INACCURACY:
+        return SKYBLUE;
+    case MoveJudgement::MISTAKE:
+        return ORANGE;
+    default:
+        return RED;
+    }
+}
+
+std::string FormatEval(const PositionEval &eval)
+{
+    char text[32];
+    if (eval.mate)
+        std::snprintf(text, sizeof(text), eval.mateIn == 0 ? "#" : "#%d", eval.mateIn);
+    else
+        std::snprintf(text, sizeof(text), "%+.2f", eval.whiteCp / 100.0);
+    return text;
+}
+
+} // namespace
+
 void MoveHistory::AddMove(const MoveRecord &move)
 {
+    if (lastLineDirty)
+        RefreshLastLine(); // Finish the previous move before it scrolls out of reach
     moves.push_back(move);
+    AppendToLayout(moves.size() - 1);
 }
 
 void MoveHistory::Clear()
 {
     moves.clear();
+    lines.clear();
+    lastLineDirty = false;
     scrollOffsetLines = 0;
+    ClearAnalysis();
+}
+
+// White starts a numbered line; black completes it
+void MoveHistory::AppendToLayout(std::size_t moveIndex)
+{
+    const MoveRecord &move = moves[moveIndex];
+    if (move.pieceColor == 1 || lines.empty() || lines.back().blackIndex >= 0)
+    {
+        PanelLine line;
+        lines.push_back(line);
+    }
+
+    PanelLine &line = lines.back();
+    if (move.pieceColor == 1)
+    {
+        line.white = std::to_string(lines.size()) + ". " + GetAlgebraicNotation(move);
+        line.whiteIndex = static_cast<int>(moveIndex);
+        line.whiteWidth = -1;
+    }
+    else
+    {
+        line.black = GetAlgebraicNotation(move);
+        line.blackIndex = static_cast<int>(moveIndex);
+        line.blackWidth = -1;
+    }
+}
+
+void MoveHistory::RefreshLastLine()
+{
+    lastLineDirty = false;
+    if (lines.empty())
+        return;
+
+    PanelLine &line = lines.back();
+    if (line.whiteIndex >= 0)
+    {
+        line.white = std::to_string(lines.size()) + ". " + GetAlgebraicNotation(moves[line.whiteIndex]);
+        line.whiteWidth = -1;
+    }
+    if (line.blackIndex >= 0)
+    {
+        line.black = GetAlgebraicNotation(moves[line.blackIndex]);
+        line.blackWidth = -1;
+    }
+}
+
+void MoveHistory::SetPositionEval(const PositionEval &eval)
+{
+    if (eval.ply < 0)
+        return;
+    if (static_cast<std::size_t>(eval.ply) >= evals.size())
+        evals.resize(eval.ply + 1);
+    evals[eval.ply] = eval;
+}
+
+void MoveHistory::SetAnalysisProgress(int done, int total)
+{
+    analysisDone = done;
+    analysisTotal = total;
+}
+
+void MoveHistory::ClearAnalysis()
+{
+    evals.clear();
+    analysisDone = 0;
+    analysisTotal = 0;
+}
+
+MoveJudgement MoveHistory::GetJudgement(std::size_t moveIndex) const
+{
+    if (moveIndex >= moves.size() || moveIndex + 1 >= evals.size())
+        return MoveJudgement::NONE;
+
+    const PositionEval &before = evals[moveIndex];
+    const PositionEval &after = evals[moveIndex + 1];
+    if (!before.hasScore || !after.hasScore || before.playedBest)
+        return MoveJudgement::NONE;
+
+    int beforeCp = std::max(-EVAL_CLAMP_CP, std::min(EVAL_CLAMP_CP, before.whiteCp));
+    int afterCp = std::max(-EVAL_CLAMP_CP, std::min(EVAL_CLAMP_CP, after.whiteCp));
+    int drop = moves[moveIndex].pieceColor == 1 ? beforeCp - afterCp : afterCp - beforeCp;
+
+    if (drop >= BLUNDER_CP)
+        return MoveJudgement::BLUNDER;
+    if (drop >= MISTAKE_CP)
+        return MoveJudgement::MISTAKE;
+    if (drop >= INACCURACY_CP)
+        return MoveJudgement::INACCURACY;
+    return MoveJudgement::NONE;
 }
 
 std::string MoveHistory::SquareToAlgebraic(const Vector2 &pos) const
@@ -93,7 +239,7 @@ std::string MoveHistory::GetAlgebraicNotation(const MoveRecord &move) const
 
     if (move.pieceType == PAWN && move.promotedTo != NONE && move.promotedTo != PAWN)
     {
-        notation = "=";
+        notation += "=";
         char promotionLetter = PieceToLetter(move.promotedTo);
         if (promotionLetter != ' ')
         {
@@ -148,7 +294,8 @@ void MoveHistory::DrawPanel(float panelX, float panelY, float panelWidth, float
     const int fontSize = 25;
     const int lineHeight = 34;
     const float contentTop = panelY + 54.0f;
-    const float contentBottom = panelY + panelHeight - 16.0f;
+    const float footerHeight = analysisTotal > 0 ? 2.0f * lineHeight + 8.0f : 0.0f;
+    const float contentBottom = panelY + panelHeight - 16.0f - footerHeight;
     const int maxVisible = std::max(0, static_cast<int>((contentBottom - contentTop) / lineHeight));
     const float innerX = panelX + 12.0f;
     const float blackColumnX = panelX + 150.0f;
@@ -161,7 +308,7 @@ void MoveHistory::DrawPanel(float panelX, float panelY, float panelWidth, float
 
     if (reviewIndex >= 0)
     {
-        int moveIdx = reviewIndex - 1; // boardHistory[0] = initial position, moves offset by 1
+        int moveIdx = reviewIndex - 1; // Ply 0 = initial position, moves offset by 1
         if (moveIdx >= 0)
         {
             highlightLine = moveIdx / 2;
@@ -186,6 +333,29 @@ void MoveHistory::DrawPanel(float panelX, float panelY, float panelWidth, float
     // Panel title
     DrawText("Move History", static_cast<int>(innerX), static_cast<int>(panelY + 10), titleSize, BLACK);
 
+    // Analysis footer: progress, then the eval and best move for the selected ply
+    if (analysisTotal > 0)
+    {
+        const int footerY = static_cast<int>(panelY + panelHeight - 12.0f - footerHeight);
+        DrawLine(static_cast<int>(panelX), footerY, static_cast<int>(panelX + panelWidth), footerY, BLACK);
+
+        std::string status = analysisDone < analysisTotal
+                                 ? "Analyzing " + std::to_string(analysisDone) + "/" + std::to_string(analysisTotal)
+                                 : "Analysis complete";
+        DrawText(status.c_str(), static_cast<int>(innerX), footerY + 8, fontSize, DARKGRAY);
+
+        std::size_t ply = reviewIndex >= 0 ? static_cast<std::size_t>(reviewIndex) : moves.size();
+        std::string detail = "Eval ...";
+        if (ply < evals.size() && evals[ply].hasScore)
+        {
+            detail = "Eval " + FormatEval(evals[ply]);
+            // The best move shown is the one the played move should be compared to
+            if (ply > 0 && !evals[ply - 1].bestMove.empty())
+                detail += "   Best " + evals[ply - 1].bestMove;
+        }
+        DrawText(detail.c_str(), static_cast<int>(innerX), footerY + 8 + lineHeight, fontSize, BLACK);
+    }
+
     if (moves.empty())
     {
         DrawText("No moves yet.",
@@ -196,29 +366,24 @@ void MoveHistory::DrawPanel(float panelX, float panelY, float panelWidth, float
         return;
     }
 
-    std::vector<std::pair<std::string, std::string>> lines;
-    int moveNum = 1;
-    std::string whiteMove;
+    if (lastLineDirty)
+        RefreshLastLine();
 
-    for (std::size_t i = 0; i < moves.size(); i++)
+    // Draws a move and, once analysed, its judgement in the judgement's colour
+    auto drawMove = [&](const std::string &text, int &width, int moveIndex, float x, float y, Color color)
     {
-        if (moves[i].pieceColor == 1) // White
-        {
-            whiteMove = std::to_string(moveNum) + ". " + GetAlgebraicNotation(moves[i]);
-        }
-        else // Black
+        DrawText(text.c_str(), static_cast<int>(x), static_cast<int>(y), fontSize, color);
+
+        MoveJudgement judgement = moveIndex >= 0 ? GetJudgement(static_cast<std::size_t>(moveIndex)) : MoveJudgement::NONE;
+        if (judgement != MoveJudgement::NONE)
         {
-            lines.emplace_back(whiteMove, GetAlgebraicNotation(moves[i]));
-            whiteMove.clear();
-            moveNum++;
+            if (width < 0)
+                width = MeasureText(text.c_str(), fontSize);
+            DrawText(JudgementSuffix(judgement),
+                     static_cast<int>(x) + width + 2,
+                     static_cast<int>(y), fontSize, JudgementColor(judgement));
         }
-    }
-
-    // If White just moved and Black has not yet responded, show the partial line
-    if (!whiteMove.empty())
-    {
-        lines.emplace_back(whiteMove, "");
-    }
+    };
 
     const int maxScroll = std::max(0, static_cast<int>(lines.size()) - maxVisible);
 
@@ -270,17 +435,15 @@ void MoveHistory::DrawPanel(float panelX, float panelY, float panelWidth, float
             blackColor = (static_cast<int>(i) == highlightLine && highlightBlack) ? YELLOW : WHITE;
         }
 
-        DrawText(lines[i].first.c_str(),
-                 static_cast<int>(innerX),
-                 static_cast<int>(panelY + yOffset),
-                 fontSize, whiteColor);
+        PanelLine &line = lines[i];
+        if (!line.white.empty())
+        {
+            drawMove(line.white, line.whiteWidth, line.whiteIndex, innerX, panelY + yOffset, whiteColor);
+        }
 
-        if (!lines[i].second.empty())
+        if (!line.black.empty())
         {
-            DrawText(lines[i].second.c_str(),
-                     static_cast<int>(blackColumnX),
-                     static_cast<int>(panelY + yOffset),
-                     fontSize, blackColor);
+            drawMove(line.black, line.blackWidth, line.blackIndex, blackColumnX, panelY + yOffset, blackColor);
         }
 
         yOffset += lineHeight;
@@ -4,6 +4,7 @@
 #include <vector>
 #include <raylib.h>
 #include "Piece.hpp"
+#include "PositionEval.hpp"
 
 struct MoveRecord
 {
@@ -32,12 +33,38 @@ struct MoveRecord
     PieceType promotedTo = NONE; // NONE unless a pawn promoted this move
 };
 
+enum class MoveJudgement
+{
+    NONE,
+    INACCURACY, // "?!"
+    MISTAKE,    // "?"
+    BLUNDER     // "??"
+};
+
 class MoveHistory
 {
 private:
     std::vector<MoveRecord> moves;
     int scrollOffsetLines = 0;
 
+    // One panel line per full move, built as moves arrive so DrawPanel only
+    // draws the visible lines. Widths are measured on first draw (-1 = not yet).
+    struct PanelLine
+    {
+        std::string white, black;             // "12. Nf3", "Nc6"
+        int whiteIndex = -1, blackIndex = -1; // Into moves, -1 = empty column
+        int whiteWidth = -1, blackWidth = -1;
+    };
+    std::vector<PanelLine> lines;
+    bool lastLineDirty = false; // The last move was changed through GetLastMoveMutable()
+
+    void AppendToLayout(std::size_t moveIndex);
+    void RefreshLastLine();
+
+    std::vector<PositionEval> evals; // Indexed by ply, filled in as analysis arrives
+    int analysisDone = 0;
+    int analysisTotal = 0;           // 0 = no analysis
+
     // Convert a pixel position to algebraic file+rank, e.g. {0, 55} -> "a8"
     std::string SquareToAlgebraic(const Vector2 &pos) const;
 
@@ -57,8 +84,21 @@ public:
     // Read-only access to the raw records (used when buliding MoveRecord in Board.cpp)
     const std::vector<MoveRecord> &GetMoves() const { return moves; }
 
-    // Mutable access to the last move, used for pawn promotion
-    MoveRecord &GetLastMoveMutable() { return moves.back(); }
+    // Mutable access to the last move, used for pawn promotion. Its panel
+    // line is rebuilt on the next draw.
+    MoveRecord &GetLastMoveMutable()
+    {
+        lastLineDirty = true;
+        return moves.back();
+    }
+
+    // Game analysis results, in any order
+    void SetPositionEval(const PositionEval &eval);
+    void SetAnalysisProgress(int done, int total);
+    void ClearAnalysis();
+
+    // Judges moves[moveIndex] by how much it dropped the mover's eval
+    MoveJudgement GetJudgement(std::size_t moveIndex) const;
 
     // Render the panel into the side panel area using Raylib DrawText
     void DrawPanel(float panelX, float panelY, float panelWidth, float panelHeight, int reviewIndex = -1);
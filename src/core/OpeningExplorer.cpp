@@ -0,0 +1,466 @@
+#include "OpeningExplorer.hpp"
+#include "Pgn.hpp"
+#include "SortedRuns.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOGDI
+#define NOGDI
+#endif
+#ifndef NOUSER
+#define NOUSER
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+namespace
+{
+
+const int BUCKETS = 1 << 16;
+const std::size_t ENTRY_SIZE = 24;
+const std::size_t MAX_COUNTED = 1 << 21; // (position, move) pairs held in memory before a spill, about 128 MB
+const long STAMP_BLOCK = 64 * 1024;
+const uint64_t ENTRIES_AT = sizeof(ExplorerTableHeader) + 8 * static_cast<uint64_t>(BUCKETS + 1);
+
+struct MoveKey
+{
+    uint64_t key;
+    uint16_t move;
+
+    bool operator==(const MoveKey &other) const { return key == other.key && move == other.move; }
+    bool operator<(const MoveKey &other) const { return key != other.key ? key < other.key : move < other.move; }
+};
+
+struct MoveKeyHash
+{
+    std::size_t operator()(const MoveKey &k) const
+    {
+        return static_cast<std::size_t>(k.key ^ (static_cast<uint64_t>(k.move) * 0x9E3779B97F4A7C15ULL));
+    }
+};
+
+struct MoveCounts
+{
+    uint32_t games = 0;
+    uint32_t whiteWins = 0;
+    uint32_t draws = 0;
+};
+
+struct CountRecord
+{
+    MoveKey id;
+    MoveCounts counts;
+
+    bool operator<(const CountRecord &other) const { return id < other.id; }
+};
+
+bool SpillCounts(std::unordered_map<MoveKey, MoveCounts, MoveKeyHash> &counts, SortedRuns<CountRecord> &runs)
+{
+    std::vector<CountRecord> records;
+    records.reserve(counts.size());
+    for (const auto &entry : counts)
+        records.push_back({entry.first, entry.second});
+    counts.clear();
+    return runs.Spill(records);
+}
+
+uint64_t ReadU64(const unsigned char *at)
+{
+    uint64_t value;
+    std::memcpy(&value, at, sizeof(value));
+    return value;
+}
+
+uint32_t ReadU32(const unsigned char *at)
+{
+    uint32_t value;
+    std::memcpy(&value, at, sizeof(value));
+    return value;
+}
+
+uint64_t Fnv1a(uint64_t hash, const unsigned char *data, std::size_t size)
+{
+    for (std::size_t i = 0; i < size; i++)
+    {
+        hash ^= data[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+// Size, modification time and a hash of the first and last blocks. An edit
+// that keeps the size and the time, or a copy that keeps the time, still
+// changes the hash unless it only touches the middle of the file.
+bool ReadStamp(const std::string &path, ExplorerTableHeader &stamp)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return false;
+    stamp.sourceSize = static_cast<uint64_t>(st.st_size);
+    stamp.sourceMtime = static_cast<int64_t>(st.st_mtime);
+
+    std::FILE *f = std::fopen(path.c_str(), "rb");
+    if (f == nullptr)
+        return false;
+    std::vector<unsigned char> block(STAMP_BLOCK);
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    std::size_t got = std::fread(block.data(), 1, block.size(), f);
+    hash = Fnv1a(hash, block.data(), got);
+    if (stamp.sourceSize > static_cast<uint64_t>(STAMP_BLOCK) && std::fseek(f, -STAMP_BLOCK, SEEK_END) == 0)
+    {
+        got = std::fread(block.data(), 1, block.size(), f);
+        hash = Fnv1a(hash, block.data(), got);
+    }
+    std::fclose(f);
+    stamp.sourceHash = hash;
+    return true;
+}
+
+} // namespace
+
+double ExplorerMove::Score(int mover) const
+{
+    if (games == 0)
+        return 0.0;
+    uint32_t wins = mover == 1 ? whiteWins : blackWins;
+    return 100.0 * (wins + 0.5 * draws) / games;
+}
+
+OpeningExplorer::OpeningExplorer(const std::string &path)
+    : pgnPath(path), tablePath(path + ".explorer")
+{
+}
+
+OpeningExplorer::~OpeningExplorer()
+{
+    {
+        std::lock_guard<std::mutex> lock(requestMutex);
+        stopping = true;
+    }
+    requestReady.notify_one();
+    if (worker.joinable())
+        worker.join();
+}
+
+void OpeningExplorer::Start()
+{
+    if (state.load() != ExplorerState::IDLE)
+        return;
+    state = ExplorerState::BUILDING;
+    worker = std::thread(&OpeningExplorer::WorkerLoop, this);
+}
+
+const ExplorerResult *OpeningExplorer::Find(const Position &pos)
+{
+    if (resultReady.load(std::memory_order_acquire))
+    {
+        ExplorerResult latest;
+        {
+            std::lock_guard<std::mutex> lock(resultMutex);
+            latest = std::move(result);
+            resultReady = false;
+        }
+
+        if (latest.key == requestedKey)
+            requestPending = false;
+        if (cacheIndex.count(latest.key) == 0)
+        {
+            cache.push_front(std::move(latest));
+            cacheIndex[cache.front().key] = cache.begin();
+            if (cache.size() > CACHE_SIZE)
+            {
+                cacheIndex.erase(cache.back().key);
+                cache.pop_back();
+            }
+        }
+    }
+
+    uint64_t key = pos.Key();
+    auto it = cacheIndex.find(key);
+    if (it != cacheIndex.end())
+    {
+        cache.splice(cache.begin(), cache, it->second);
+        return &cache.front();
+    }
+
+    ExplorerState current = state.load();
+    if ((current == ExplorerState::BUILDING || current == ExplorerState::READY) &&
+        (!requestPending || requestedKey != key))
+    {
+        {
+            std::lock_guard<std::mutex> lock(requestMutex);
+            request = pos;
+            hasRequest = true;
+        }
+        requestReady.notify_one();
+        requestedKey = key;
+        requestPending = true;
+    }
+    return nullptr;
+}
+
+void OpeningExplorer::WorkerLoop()
+{
+    ExplorerTableHeader source;
+    if (!ReadStamp(pgnPath, source))
+    {
+        std::cerr << "OpeningExplorer: No game collection at " << pgnPath << std::endl;
+        state = ExplorerState::UNAVAILABLE;
+        return;
+    }
+
+    if (!OpenTable(source))
+    {
+        if (!BuildTable(source) || !OpenTable(source))
+        {
+            if (!stopping)
+                std::cerr << "OpeningExplorer: Could not build " << tablePath << std::endl;
+            state = ExplorerState::UNAVAILABLE;
+            return;
+        }
+    }
+    state = ExplorerState::READY;
+
+    for (;;)
+    {
+        Position pos;
+        {
+            std::unique_lock<std::mutex> lock(requestMutex);
+            requestReady.wait(lock, [this] { return hasRequest || stopping.load(); });
+            if (stopping)
+                return;
+            pos = request;
+            hasRequest = false;
+        }
+
+        ExplorerResult found;
+        Lookup(pos, found);
+
+        // Replaces a result the UI has not picked up yet; that one answered
+        // an older request
+        {
+            std::lock_guard<std::mutex> lock(resultMutex);
+            result = std::move(found);
+            resultReady = true;
+        }
+    }
+}
+
+bool OpeningExplorer::OpenTable(const ExplorerTableHeader &source)
+{
+    table.Close();
+    if (!table.Open(tablePath))
+        return false;
+
+    ExplorerTableHeader header;
+    bool valid = table.Size() >= ENTRIES_AT;
+    if (valid)
+    {
+        std::memcpy(&header, table.Data(), sizeof(header));
+        valid = std::memcmp(header.magic, "CEXP", 4) == 0 &&
+                header.version == EXPLORER_VERSION &&
+                header.sourceSize == source.sourceSize &&
+                header.sourceMtime == source.sourceMtime &&
+                header.sourceHash == source.sourceHash &&
+                (table.Size() - ENTRIES_AT) / ENTRY_SIZE >= header.count &&
+                ReadU64(table.Data() + sizeof(header) + 8 * static_cast<uint64_t>(BUCKETS)) == header.count;
+    }
+    if (!valid)
+    {
+        table.Close();
+        return false;
+    }
+
+    entryCount = header.count;
+    return true;
+}
+
+bool OpeningExplorer::BuildTable(const ExplorerTableHeader &source)
+{
+    PgnReader reader;
+    if (!reader.Open(pgnPath))
+        return false;
+
+    // Counts are spilled to sorted runs when the map is full, so a large
+    // collection costs disk space rather than memory
+    SortedRuns<CountRecord> runs(tablePath);
+    std::unordered_map<MoveKey, MoveCounts, MoveKeyHash> counts;
+    PgnGame game;
+    while (reader.NextGame(game))
+    {
+        if (stopping)
+            return false;
+
+        int result = game.result == "1-0" ? 1 : game.result == "0-1" ? 0 : game.result == "1/2-1/2" ? -1 : -2;
+        if (result == -2)
+            continue; // Unfinished games have no score to count
+
+        Position pos = Position::StartPosition();
+        std::string fen = game.Tag("FEN");
+        if (!fen.empty() && !pos.SetFromFEN(fen))
+            continue;
+
+        int ply = 0;
+        for (const std::string &san : game.moves)
+        {
+            Move move;
+            if (ply >= EXPLORER_MAX_PLY || !pos.ParseSAN(san.c_str(), move))
+                break;
+
+            MoveCounts &entry = counts[MoveKey{pos.Key(), pos.ToPolyglotMove(move)}];
+            entry.games++;
+            entry.whiteWins += result == 1 ? 1 : 0;
+            entry.draws += result == -1 ? 1 : 0;
+
+            pos.MakeMove(move);
+            ply++;
+        }
+        gamesCounted++;
+
+        if (counts.size() >= MAX_COUNTED && !SpillCounts(counts, runs))
+            return false;
+    }
+    reader.Close();
+    if (!SpillCounts(counts, runs))
+        return false;
+
+    // Written beside the table and renamed over it, so a half-written table is never opened
+    std::string tmpPath = tablePath + ".tmp";
+    std::FILE *out = std::fopen(tmpPath.c_str(), "wb");
+    if (out == nullptr)
+        return false;
+
+    ExplorerTableHeader header = source;
+    std::memcpy(header.magic, "CEXP", 4);
+    header.version = EXPLORER_VERSION;
+    header.count = 0;
+    std::vector<uint64_t> buckets(BUCKETS + 1, 0);
+    bool ok = std::fwrite(&header, sizeof(header), 1, out) == 1 &&
+              std::fwrite(buckets.data(), sizeof(uint64_t), buckets.size(), out) == buckets.size();
+
+    // Equal (key, move) pairs from different runs arrive together and are summed
+    std::vector<unsigned char> chunk;
+    chunk.reserve(ENTRY_SIZE * 4096);
+    CountRecord pending;
+    bool havePending = false;
+    auto writePending = [&]()
+    {
+        unsigned char entry[ENTRY_SIZE] = {};
+        std::memcpy(entry, &pending.id.key, 8);
+        std::memcpy(entry + 8, &pending.id.move, 2);
+        std::memcpy(entry + 12, &pending.counts.games, 4);
+        std::memcpy(entry + 16, &pending.counts.whiteWins, 4);
+        std::memcpy(entry + 20, &pending.counts.draws, 4);
+        chunk.insert(chunk.end(), entry, entry + ENTRY_SIZE);
+        buckets[(pending.id.key >> 48) + 1]++;
+        header.count++;
+
+        if (chunk.size() < chunk.capacity())
+            return true;
+        bool written = std::fwrite(chunk.data(), 1, chunk.size(), out) == chunk.size();
+        chunk.clear();
+        return written;
+    };
+    ok = ok && runs.Merge([&](const CountRecord &r)
+                          {
+                              if (stopping)
+                                  return false;
+                              if (havePending && pending.id == r.id)
+                              {
+                                  pending.counts.games += r.counts.games;
+                                  pending.counts.whiteWins += r.counts.whiteWins;
+                                  pending.counts.draws += r.counts.draws;
+                                  return true;
+                              }
+                              bool written = !havePending || writePending();
+                              pending = r;
+                              havePending = true;
+                              return written;
+                          });
+    ok = ok && (!havePending || writePending());
+    ok = ok && (chunk.empty() || std::fwrite(chunk.data(), 1, chunk.size(), out) == chunk.size());
+
+    // Counts per bucket -> first entry of each bucket; the last one is the total
+    for (std::size_t i = 1; i < buckets.size(); i++)
+        buckets[i] += buckets[i - 1];
+    ok = ok && std::fseek(out, 0, SEEK_SET) == 0 &&
+         std::fwrite(&header, sizeof(header), 1, out) == 1 &&
+         std::fwrite(buckets.data(), sizeof(uint64_t), buckets.size(), out) == buckets.size();
+    ok = (std::fclose(out) == 0) && ok;
+
+#ifdef _WIN32
+    ok = ok && MoveFileExA(tmpPath.c_str(), tablePath.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+    ok = ok && std::rename(tmpPath.c_str(), tablePath.c_str()) == 0;
+#endif
+    if (!ok)
+        std::remove(tmpPath.c_str());
+    return ok;
+}
+
+void OpeningExplorer::Lookup(const Position &pos, ExplorerResult &out) const
+{
+    out = ExplorerResult();
+    out.key = pos.Key();
+    out.sideToMove = pos.SideToMove();
+
+    const unsigned char *buckets = table.Data() + sizeof(ExplorerTableHeader);
+    const unsigned char *entries = table.Data() + ENTRIES_AT;
+    uint64_t bucket = out.key >> 48;
+    uint64_t lo = ReadU64(buckets + 8 * bucket);
+    uint64_t hi = ReadU64(buckets + 8 * (bucket + 1));
+    if (lo > hi || hi > entryCount)
+        return;
+
+    while (lo < hi)
+    {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (ReadU64(entries + mid * ENTRY_SIZE) < out.key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    MoveList legal;
+    pos.GenerateLegalMoves(legal);
+    for (uint64_t i = lo; i < entryCount; i++)
+    {
+        const unsigned char *entry = entries + i * ENTRY_SIZE;
+        if (ReadU64(entry) != out.key)
+            break;
+
+        // A move that is not legal here belongs to another position with the same key
+        uint16_t polyglot;
+        std::memcpy(&polyglot, entry + 8, 2);
+        const Move *move = nullptr;
+        for (int m = 0; m < legal.count && move == nullptr; m++)
+        {
+            if (pos.ToPolyglotMove(legal.moves[m]) == polyglot)
+                move = &legal.moves[m];
+        }
+        if (move == nullptr)
+            continue;
+
+        ExplorerMove explored;
+        explored.san = pos.ToSAN(*move);
+        explored.games = ReadU32(entry + 12);
+        explored.whiteWins = ReadU32(entry + 16);
+        explored.draws = ReadU32(entry + 20);
+        explored.blackWins = explored.games - std::min(explored.games, explored.whiteWins + explored.draws);
+        out.games += explored.games;
+        out.moves.push_back(explored);
+    }
+
+    std::sort(out.moves.begin(), out.moves.end(), [](const ExplorerMove &a, const ExplorerMove &b)
+              { return a.games > b.games; });
+}
@@ -0,0 +1,130 @@
+#ifndef OPENING_EXPLORER_HPP
+#define OPENING_EXPLORER_HPP
+
+#include "MappedFile.hpp"
+#include "Position.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// OpeningExplorer - what was played from a position in a local PGN collection,
+// with how often and how it scored.
+//
+// The first Start() counts every (position, move) of the collection's first
+// EXPLORER_MAX_PLY plies into a move table next to it (pgnPath + ".explorer"),
+// which is reused until the PGN's size, modification time or first and last
+// blocks change. Counting spills to sorted run files when it outgrows its
+// memory budget. Building and lookups run on a worker thread; Find() only
+// reads a small LRU cache and posts a request on a miss, so the render loop
+// never waits for the disk.
+//
+// Table layout (little-endian): ExplorerTableHeader, 65537 u64 bucket starts
+// by the top 16 bits of the key, then entries sorted by key: u64 Polyglot key,
+// u16 Polyglot move, u16 0, u32 games, u32 white wins, u32 draws.
+
+constexpr int EXPLORER_MAX_PLY = 40;
+constexpr uint32_t EXPLORER_VERSION = 3; // 2: Polyglot Random64 keys, 3: source mtime and hash
+
+struct ExplorerTableHeader
+{
+    char magic[4];        // "CEXP"
+    uint32_t version;     // EXPLORER_VERSION
+    uint64_t count;       // Entries
+    uint64_t sourceSize;  // Size of the PGN it was built from
+    int64_t sourceMtime;  // Its modification time, seconds
+    uint64_t sourceHash;  // FNV-1a of its first and last 64 KiB
+};
+
+struct ExplorerMove
+{
+    std::string san;
+    uint32_t games = 0;
+    uint32_t whiteWins = 0;
+    uint32_t draws = 0;
+    uint32_t blackWins = 0;
+
+    // Percent scored by the side that played the move
+    double Score(int mover) const;
+};
+
+struct ExplorerResult
+{
+    uint64_t key = 0;
+    uint64_t games = 0;              // Games that reached the position and went on
+    int sideToMove = 1;
+    std::vector<ExplorerMove> moves; // Most played first
+};
+
+enum class ExplorerState
+{
+    IDLE,        // Start() not called yet
+    BUILDING,    // Counting the collection into the move table
+    READY,
+    UNAVAILABLE  // No collection, or the table could not be built
+};
+
+class OpeningExplorer
+{
+public:
+    explicit OpeningExplorer(const std::string &pgnPath);
+    ~OpeningExplorer();
+
+    OpeningExplorer(const OpeningExplorer &) = delete;
+    OpeningExplorer &operator=(const OpeningExplorer &) = delete;
+
+    // Opens the move table, building it first if it is missing or stale
+    void Start();
+
+    ExplorerState State() const { return state.load(); }
+    uint64_t GamesCounted() const { return gamesCounted.load(); } // Progress while BUILDING
+    const std::string &PgnPath() const { return pgnPath; }
+
+    // UI thread only. The cached result for pos, or nullptr while it is being
+    // looked up. Valid until the next call.
+    const ExplorerResult *Find(const Position &pos);
+
+private:
+    static constexpr std::size_t CACHE_SIZE = 64;
+
+    std::string pgnPath;
+    std::string tablePath;
+    MappedFile table;
+    uint64_t entryCount = 0;
+
+    std::atomic<ExplorerState> state{ExplorerState::IDLE};
+    std::atomic<uint64_t> gamesCounted{0};
+    std::atomic<bool> stopping{false};
+    std::thread worker;
+
+    // Latest request only: positions skipped while scrolling are never looked up
+    std::mutex requestMutex;
+    std::condition_variable requestReady;
+    bool hasRequest = false;
+    Position request;
+
+    // Latest result only, overwritten rather than queued: the worker never
+    // waits for the UI, which only drains it while the panel is drawn.
+    // resultReady lets Find() skip the lock on frames with nothing new.
+    std::mutex resultMutex;
+    std::atomic<bool> resultReady{false};
+    ExplorerResult result;
+
+    // Owned by the UI thread
+    std::list<ExplorerResult> cache; // Most recently used first
+    std::unordered_map<uint64_t, std::list<ExplorerResult>::iterator> cacheIndex;
+    uint64_t requestedKey = 0;
+    bool requestPending = false;
+
+    void WorkerLoop();
+    bool OpenTable(const ExplorerTableHeader &source);
+    bool BuildTable(const ExplorerTableHeader &source);
+    void Lookup(const Position &pos, ExplorerResult &out) const;
+};
+
+#endif // OPENING_EXPLORER_HPP
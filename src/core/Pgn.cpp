@@ -0,0 +1,282 @@
+#include "Pgn.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+void PgnGame::Clear()
+{
+    tags.clear();
+    moves.clear();
+    result.clear();
+}
+
+std::string PgnGame::Tag(const std::string &name) const
+{
+    for (const auto &tag : tags)
+    {
+        if (tag.first == name)
+            return tag.second;
+    }
+    return std::string();
+}
+
+std::string PgnGame::ToString() const
+{
+    std::string out;
+    for (const auto &tag : tags)
+    {
+        out += "[" + tag.first + " \"";
+        for (char c : tag.second)
+        {
+            if (c == '"' || c == '\\')
+                out += '\\';
+            out += c;
+        }
+        out += "\"]\n";
+    }
+    out += "\n";
+
+    // A game from a FEN may start with black and at any move number
+    bool whiteToMove = true;
+    int moveNumber = 1;
+    std::string fen = Tag("FEN");
+    if (!fen.empty())
+    {
+        std::istringstream fields(fen);
+        std::string board, side, castling, ep, halfmove, fullmove;
+        fields >> board >> side >> castling >> ep >> halfmove >> fullmove;
+        whiteToMove = side != "b";
+        if (!fullmove.empty())
+            moveNumber = std::max(1, std::atoi(fullmove.c_str()));
+    }
+
+    std::string line;
+    auto addToken = [&](const std::string &token)
+    {
+        if (!line.empty() && line.size() + 1 + token.size() > 80)
+        {
+            out += line + "\n";
+            line.clear();
+        }
+        if (!line.empty())
+            line += ' ';
+        line += token;
+    };
+
+    for (std::size_t i = 0; i < moves.size(); i++)
+    {
+        if (whiteToMove)
+            addToken(std::to_string(moveNumber) + ". " + moves[i]);
+        else if (i == 0)
+            addToken(std::to_string(moveNumber) + "... " + moves[i]);
+        else
+            addToken(moves[i]);
+
+        if (!whiteToMove)
+            moveNumber++;
+        whiteToMove = !whiteToMove;
+    }
+    addToken(result.empty() ? "*" : result);
+    out += line + "\n";
+    return out;
+}
+
+PgnReader::PgnReader(std::size_t bufferSize)
+    : buffer(bufferSize)
+{
+}
+
+PgnReader::~PgnReader()
+{
+    Close();
+}
+
+bool PgnReader::Open(const std::string &path)
+{
+    Close();
+    file = std::fopen(path.c_str(), "rb");
+    bufferPos = 0;
+    bufferLen = 0;
+    return file != nullptr;
+}
+
+void PgnReader::Close()
+{
+    if (file != nullptr)
+    {
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+int PgnReader::Peek()
+{
+    if (bufferPos == bufferLen)
+    {
+        if (file == nullptr)
+            return EOF;
+        bufferLen = std::fread(buffer.data(), 1, buffer.size(), file);
+        bufferPos = 0;
+        if (bufferLen == 0)
+            return EOF;
+    }
+    return static_cast<unsigned char>(buffer[bufferPos]);
+}
+
+int PgnReader::Get()
+{
+    int c = Peek();
+    if (c != EOF)
+        bufferPos++;
+    return c;
+}
+
+void PgnReader::SkipUntil(char terminator)
+{
+    int c;
+    while ((c = Get()) != EOF && c != terminator)
+    {
+    }
+}
+
+void PgnReader::SkipVariation()
+{
+    // Opening '(' already consumed; variations can nest and contain comments
+    int depth = 1;
+    int c;
+    while (depth > 0 && (c = Get()) != EOF)
+    {
+        if (c == '(')
+            depth++;
+        else if (c == ')')
+            depth--;
+        else if (c == '{')
+            SkipUntil('}');
+        else if (c == ';')
+            SkipUntil('\n');
+    }
+}
+
+void PgnReader::ReadTag(PgnGame &game)
+{
+    // Opening '[' already consumed: [Name "Value"]
+    std::string name;
+    std::string value;
+    int c;
+
+    while ((c = Peek()) != EOF && std::isspace(c))
+        Get();
+    while ((c = Peek()) != EOF && !std::isspace(c) && c != '"' && c != ']')
+        name += static_cast<char>(Get());
+    while ((c = Get()) != EOF && c != '"' && c != ']')
+    {
+    }
+
+    if (c == '"')
+    {
+        while ((c = Get()) != EOF && c != '"')
+        {
+            if (c == '\\')
+                c = Get();
+            if (c != EOF)
+                value += static_cast<char>(c);
+        }
+        SkipUntil(']');
+    }
+
+    game.tags.emplace_back(name, value);
+}
+
+void PgnReader::ReadToken(std::string &token)
+{
+    token.clear();
+    int c;
+    while ((c = Peek()) != EOF && !std::isspace(c) && !std::strchr("{}()[];$", c))
+        token += static_cast<char>(Get());
+}
+
+bool PgnReader::NextGame(PgnGame &game)
+{
+    game.Clear();
+    bool inMoves = false;
+    std::string token;
+
+    while (true)
+    {
+        int c = Peek();
+        if (c == EOF)
+            break;
+
+        if (std::isspace(c))
+        {
+            Get();
+            continue;
+        }
+
+        if (c == '[')
+        {
+            if (inMoves)
+                break; // Next game's tags, this game had no result token
+            Get();
+            ReadTag(game);
+            continue;
+        }
+
+        inMoves = true;
+        Get();
+
+        if (c == '{')
+        {
+            SkipUntil('}');
+            continue;
+        }
+        if (c == ';' || c == '%')
+        {
+            SkipUntil('\n');
+            continue;
+        }
+        if (c == '(')
+        {
+            SkipVariation();
+            continue;
+        }
+        if (c == '$' || c == ')' || c == '}' || c == ']')
+        {
+            while ((c = Peek()) != EOF && std::isdigit(c))
+                Get();
+            continue;
+        }
+
+        bufferPos--; // Put the first character back for ReadToken
+        ReadToken(token);
+
+        if (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*")
+        {
+            game.result = token;
+            return true;
+        }
+
+        // Strip a move number prefix: "12.", "12...", or "12.e4"
+        std::size_t digits = 0;
+        while (digits < token.size() && std::isdigit(static_cast<unsigned char>(token[digits])))
+            digits++;
+        if (digits < token.size() && token[digits] == '.')
+        {
+            while (digits < token.size() && token[digits] == '.')
+                digits++;
+            token.erase(0, digits);
+        }
+
+        if (!token.empty())
+            game.moves.push_back(token);
+    }
+
+    if (game.tags.empty() && game.moves.empty())
+        return false;
+
+    if (game.result.empty())
+        game.result = game.Tag("Result");
+    return true;
+}
@@ -0,0 +1,58 @@
+#ifndef PGN_HPP
+#define PGN_HPP
+
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+// One game as read from a PGN file: tag pairs plus the main line in SAN.
+// Comments, NAGs and variations are skipped by the reader.
+struct PgnGame
+{
+    std::vector<std::pair<std::string, std::string>> tags;
+    std::vector<std::string> moves; // SAN, e.g. {"e4", "e5", "Nf3"}
+    std::string result;             // "1-0", "0-1", "1/2-1/2" or "*"
+
+    void Clear();
+
+    // Value of a tag, or an empty string if the game does not have it
+    std::string Tag(const std::string &name) const;
+
+    // PGN export text: tag pairs, a blank line, then the moves wrapped at 80
+    // columns. Move numbers follow the FEN tag when the game has one.
+    std::string ToString() const;
+};
+
+// PgnReader - streams games out of a PGN file with a fixed read buffer,
+// so archives of any size can be processed without loading them whole.
+class PgnReader
+{
+private:
+    std::FILE *file = nullptr;
+    std::vector<char> buffer;
+    std::size_t bufferPos = 0;
+    std::size_t bufferLen = 0;
+
+    int Get();
+    int Peek();
+    void SkipUntil(char terminator);
+    void SkipVariation();
+    void ReadTag(PgnGame &game);
+    void ReadToken(std::string &token);
+
+public:
+    explicit PgnReader(std::size_t bufferSize = 1 << 20);
+    ~PgnReader();
+
+    PgnReader(const PgnReader &) = delete;
+    PgnReader &operator=(const PgnReader &) = delete;
+
+    bool Open(const std::string &path);
+    void Close();
+
+    // Read the next game. Returns false once the file is exhausted.
+    bool NextGame(PgnGame &game);
+};
+
+#endif // PGN_HPP
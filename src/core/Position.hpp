@@ -0,0 +1,157 @@
+#ifndef POSITION_HPP
+#define POSITION_HPP
+
+#include <cstdint>
+#include <string>
+
+// Position - compact chess position that does not depend on raylib.
+// Board works in pixel coordinates for drawing; Position is what tools,
+// hashing and anything that has to replay thousands of games use instead.
+//
+// Squares are 0-63 with a1 = 0, h1 = 7, a8 = 56, h8 = 63.
+// Piece codes reuse the PieceType numbering (ROOK = 1 ... PAWN = 6) and put
+// the colour in bit 3, so black pieces are 1-6 and white pieces are 9-14.
+// Colours follow the rest of the project: 0 = black, 1 = white.
+
+// Key() of the start position with the standard Polyglot Random64 table
+constexpr uint64_t POLYGLOT_START_KEY = 0x463B96181691FC9CULL;
+
+namespace PositionCodes
+{
+    constexpr int ROOK = 1;
+    constexpr int KNIGHT = 2;
+    constexpr int BISHOP = 3;
+    constexpr int QUEEN = 4;
+    constexpr int KING = 5;
+    constexpr int PAWN = 6;
+
+    constexpr int WHITE_BIT = 8;
+
+    inline int MakeCode(int type, int color) { return type | (color == 1 ? WHITE_BIT : 0); }
+    inline int TypeOf(int code) { return code & 7; }
+    inline int ColorOf(int code) { return (code & WHITE_BIT) ? 1 : 0; }
+
+    inline int FileOf(int sq) { return sq & 7; }
+    inline int RankOf(int sq) { return sq >> 3; }
+    inline int MakeSquare(int file, int rank) { return rank * 8 + file; }
+}
+
+// Castling rights bits
+enum CastlingRight
+{
+    CASTLE_WHITE_KING = 1,
+    CASTLE_WHITE_QUEEN = 2,
+    CASTLE_BLACK_KING = 4,
+    CASTLE_BLACK_QUEEN = 8
+};
+
+enum MoveFlag
+{
+    MOVE_CAPTURE = 1,
+    MOVE_EN_PASSANT = 2,
+    MOVE_CASTLE = 4,
+    MOVE_DOUBLE_PUSH = 8
+};
+
+struct Move
+{
+    uint8_t from = 0;
+    uint8_t to = 0;
+    uint8_t promotion = 0; // PieceType value, 0 = no promotion
+    uint8_t flags = 0;     // MoveFlag bits
+
+    bool operator==(const Move &other) const
+    {
+        return from == other.from && to == other.to && promotion == other.promotion;
+    }
+};
+
+// Fixed-size move list so generation never touches the heap
+struct MoveList
+{
+    Move moves[256];
+    int count = 0;
+
+    void Add(const Move &m) { moves[count++] = m; }
+    const Move *begin() const { return moves; }
+    const Move *end() const { return moves + count; }
+};
+
+class Position
+{
+private:
+    uint8_t board[64];
+    int sideToMove;      // 0 = black, 1 = white
+    int castlingRights;  // CastlingRight bits
+    int epSquare;        // Square a pawn can capture onto en passant, -1 if none
+    int halfmoveClock;   // Plies since the last capture or pawn move
+    int fullmoveNumber;
+    int kingSquare[2];
+    int pieceCount[2][7]; // [color][PieceType]
+    uint64_t key;
+
+    void PutPiece(int sq, int code);
+    void RemovePiece(int sq);
+    void GeneratePseudoMoves(MoveList &list) const;
+    bool OpensLineToKing(const Move &move) const; // Out of check, non-king moves only
+    bool EpAffectsKey() const; // Polyglot only hashes en passant when a capture is possible
+    uint64_t ComputeKey() const;
+
+public:
+    Position();
+
+    static Position StartPosition();
+
+    // FEN import/export. SetFromFEN returns false (and leaves the position
+    // unchanged) if the string cannot be parsed.
+    bool SetFromFEN(const std::string &fen);
+    std::string ToFEN() const;
+
+    // Piece-by-piece setup for generators that enumerate positions.
+    // Castling rights and en passant are cleared.
+    void Clear();
+    void AddPiece(int sq, int code) { PutPiece(sq, code); }
+    void SetSideToMove(int color);
+
+    // Same position with colours swapped and the board mirrored top to bottom
+    Position ColorFlipped() const;
+
+    void GenerateLegalMoves(MoveList &list) const;
+    bool IsLegal(const Move &pseudoLegalMove) const; // Does the move leave our own king safe?
+    void MakeMove(const Move &move);
+
+    bool IsSquareAttacked(int sq, int byColor) const;
+    bool InCheck() const { return IsSquareAttacked(kingSquare[sideToMove], 1 - sideToMove); }
+
+    // Move text conversion. The parse functions only accept legal moves.
+    bool ParseUCI(const std::string &text, Move &out) const;
+    bool ParseSAN(const char *san, Move &out) const;
+    static std::string ToUCI(const Move &move);
+    std::string ToSAN(const Move &move) const; // move must be legal here, e.g. "Nxf3+"
+
+    // Polyglot book move encoding (castling is written as king-takes-rook)
+    uint16_t ToPolyglotMove(const Move &move) const;
+
+    int PieceAt(int sq) const { return board[sq]; }
+    int SideToMove() const { return sideToMove; }
+    int CastlingRights() const { return castlingRights; }
+    int EpSquare() const { return epSquare; }
+    int HalfmoveClock() const { return halfmoveClock; }
+    int FullmoveNumber() const { return fullmoveNumber; }
+    int KingSquare(int color) const { return kingSquare[color]; }
+    int PieceCount(int color, int type) const { return pieceCount[color][type]; }
+
+    // 64-bit hash using the Polyglot key layout, updated incrementally by MakeMove
+    uint64_t Key() const { return key; }
+
+    // Draw rules. Material is judged from the piece counts alone: bare kings,
+    // or a single knight or bishop on the board.
+    bool HasInsufficientMaterial() const;
+    bool IsFiftyMoveDraw() const { return halfmoveClock >= 100; }
+
+    // keys[count - 1] is the current position, earlier entries the plies
+    // before it. Only looks back halfmoveClock plies, same side to move only.
+    static bool IsThreefoldRepetition(const uint64_t *keys, int count, int halfmoveClock);
+};
+
+#endif // POSITION_HPP
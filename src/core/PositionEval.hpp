@@ -0,0 +1,18 @@
+#ifndef POSITION_EVAL_HPP
+#define POSITION_EVAL_HPP
+
+#include <string>
+
+// Engine verdict on the position after `ply` moves (0 = start), from white's view
+struct PositionEval
+{
+    int ply = 0;
+    bool hasScore = false;
+    int whiteCp = 0;         // Centipawns; mates are pushed out to +-10000
+    bool mate = false;
+    int mateIn = 0;          // Moves to mate, > 0 when white mates
+    std::string bestMove;    // Engine's choice here in SAN, empty at the end of the game
+    bool playedBest = false; // The game continued with bestMove
+};
+
+#endif // POSITION_EVAL_HPP
@@ -0,0 +1,202 @@
+#include "SavedGame.hpp"
+#include "Position.hpp"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOGDI
+#define NOGDI
+#endif
+#ifndef NOUSER
+#define NOUSER
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+const char MAGIC[4] = {'C', 'S', 'A', 'V'};
+const uint16_t VERSION = 1;
+const uint16_t HEADER_SIZE = 32;
+const uint8_t FLAG_VS_ENGINE = 1;
+
+uint32_t Fnv1a(const uint8_t *data, std::size_t size)
+{
+    uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < size; i++)
+    {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void Put(std::vector<uint8_t> &out, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+}
+
+uint64_t Get(const uint8_t *in, int bytes)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++)
+        value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    return value;
+}
+
+bool WriteAtomically(const std::string &path, const std::vector<uint8_t> &data)
+{
+    std::string tmpPath = path + ".tmp";
+    std::FILE *f = std::fopen(tmpPath.c_str(), "wb");
+    if (f == nullptr)
+        return false;
+
+    bool ok = std::fwrite(data.data(), 1, data.size(), f) == data.size() && std::fflush(f) == 0;
+#ifdef _WIN32
+    ok = ok && _commit(_fileno(f)) == 0;
+#else
+    ok = ok && fsync(fileno(f)) == 0;
+#endif
+    ok = (std::fclose(f) == 0) && ok;
+
+#ifdef _WIN32
+    ok = ok && MoveFileExA(tmpPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    ok = ok && std::rename(tmpPath.c_str(), path.c_str()) == 0;
+#endif
+    if (!ok)
+        std::remove(tmpPath.c_str());
+    return ok;
+}
+
+} // namespace
+
+bool SavedGame::Save(const std::string &path) const
+{
+    std::vector<uint8_t> out;
+    out.reserve(8 + HEADER_SIZE + uciMoves.size() + 4);
+
+    out.insert(out.end(), MAGIC, MAGIC + 4);
+    Put(out, VERSION, 2);
+    Put(out, HEADER_SIZE, 2);
+
+    Put(out, vsEngine ? FLAG_VS_ENGINE : 0, 1);
+    Put(out, static_cast<uint8_t>(engineColor), 1);
+    Put(out, static_cast<uint8_t>(skillLevel), 1);
+    Put(out, static_cast<uint8_t>(static_cast<int8_t>(resignedPlayer)), 1);
+    Put(out, static_cast<uint32_t>(clockInitialMs), 4);
+    Put(out, static_cast<uint32_t>(clockIncrementMs), 4);
+    Put(out, static_cast<uint32_t>(whiteClockMs), 4);
+    Put(out, static_cast<uint32_t>(blackClockMs), 4);
+    Put(out, static_cast<uint64_t>(savedAt), 8);
+    Put(out, static_cast<uint32_t>(uciMoves.size()), 4);
+
+    // Each move as its index among the legal moves; there are never more than 218
+    Position pos = Position::StartPosition();
+    MoveList legal;
+    for (const std::string &uci : uciMoves)
+    {
+        Move move;
+        if (!pos.ParseUCI(uci, move))
+        {
+            std::cerr << "SavedGame: Illegal move in game: " << uci << std::endl;
+            return false;
+        }
+
+        pos.GenerateLegalMoves(legal);
+        int index = 0;
+        while (!(legal.moves[index] == move))
+            index++;
+        out.push_back(static_cast<uint8_t>(index));
+        pos.MakeMove(move);
+    }
+
+    Put(out, Fnv1a(out.data(), out.size()), 4);
+
+    if (!WriteAtomically(path, out))
+    {
+        std::cerr << "SavedGame: Could not write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool SavedGame::Load(const std::string &path)
+{
+    std::FILE *f = std::fopen(path.c_str(), "rb");
+    if (f == nullptr)
+        return false;
+
+    std::vector<uint8_t> data;
+    uint8_t chunk[4096];
+    std::size_t got;
+    while ((got = std::fread(chunk, 1, sizeof(chunk), f)) > 0)
+        data.insert(data.end(), chunk, chunk + got);
+    std::fclose(f);
+
+    // Newer versions may grow the header; the fields read here stay first
+    if (data.size() < 8 + HEADER_SIZE + 4 || std::memcmp(data.data(), MAGIC, 4) != 0)
+    {
+        std::cerr << "SavedGame: " << path << " is not a saved game" << std::endl;
+        return false;
+    }
+    uint16_t version = static_cast<uint16_t>(Get(&data[4], 2));
+    uint16_t headerSize = static_cast<uint16_t>(Get(&data[6], 2));
+    std::size_t movesAt = 8 + static_cast<std::size_t>(headerSize);
+    std::size_t checksumAt = data.size() - 4;
+    if (version > VERSION || headerSize < HEADER_SIZE || movesAt > checksumAt ||
+        Get(&data[checksumAt], 4) != Fnv1a(data.data(), checksumAt))
+    {
+        std::cerr << "SavedGame: " << path << " is damaged or from a newer version" << std::endl;
+        return false;
+    }
+
+    const uint8_t *header = &data[8];
+    uint32_t plies = static_cast<uint32_t>(Get(header + 28, 4));
+    if (movesAt + plies != checksumAt)
+    {
+        std::cerr << "SavedGame: " << path << " is damaged" << std::endl;
+        return false;
+    }
+
+    std::vector<std::string> moves;
+    moves.reserve(plies);
+    Position pos = Position::StartPosition();
+    MoveList legal;
+    for (uint32_t i = 0; i < plies; i++)
+    {
+        pos.GenerateLegalMoves(legal);
+        int index = data[movesAt + i];
+        if (index >= legal.count)
+        {
+            std::cerr << "SavedGame: " << path << " has an illegal move at ply " << i << std::endl;
+            return false;
+        }
+        moves.push_back(Position::ToUCI(legal.moves[index]));
+        pos.MakeMove(legal.moves[index]);
+    }
+
+    vsEngine = (header[0] & FLAG_VS_ENGINE) != 0;
+    engineColor = header[1] ? 1 : 0;
+    skillLevel = header[2];
+    resignedPlayer = static_cast<int8_t>(header[3]);
+    clockInitialMs = static_cast<int>(Get(header + 4, 4));
+    clockIncrementMs = static_cast<int>(Get(header + 8, 4));
+    whiteClockMs = static_cast<int>(Get(header + 12, 4));
+    blackClockMs = static_cast<int>(Get(header + 16, 4));
+    savedAt = static_cast<int64_t>(Get(header + 20, 8));
+    uciMoves.swap(moves);
+    return true;
+}
@@ -0,0 +1,38 @@
+#ifndef SAVED_GAME_HPP
+#define SAVED_GAME_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// SavedGame - a game in progress as written to disk: a small fixed header
+// (mode, engine side and strength, clocks) and the moves, each stored as its
+// index in Position's legal move list, so one byte per ply. Loading replays
+// the moves, so a file that does not describe a legal game is rejected.
+//
+// Layout, little-endian: "CSAV", u16 version, u16 header size, header,
+// one byte per ply, u32 FNV-1a checksum of everything before it.
+
+struct SavedGame
+{
+    bool vsEngine = false;
+    int engineColor = 0;     // 0 = black, 1 = white
+    int skillLevel = 10;
+    int resignedPlayer = -1; // -1 = nobody
+    int clockInitialMs = 0;  // 0 = untimed
+    int clockIncrementMs = 0;
+    int whiteClockMs = 0;    // Time left when saved
+    int blackClockMs = 0;
+    int64_t savedAt = 0;     // Unix time
+    std::vector<std::string> uciMoves;
+
+    // Written to path + ".tmp", flushed to disk, then renamed over path, so
+    // a crash leaves either the old file or the new one
+    bool Save(const std::string &path) const;
+
+    // False, leaving this untouched, if the file is missing, damaged or from
+    // a newer version, or its moves do not replay
+    bool Load(const std::string &path);
+};
+
+#endif // SAVED_GAME_HPP
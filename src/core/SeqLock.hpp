@@ -0,0 +1,54 @@
+#ifndef SEQ_LOCK_HPP
+#define SEQ_LOCK_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// SeqLock - one writer publishes a small struct, any number of readers take
+// consistent snapshots of it. The writer never waits; a reader that raced a
+// write just tries again. Used for data the render loop shows every frame.
+
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock values are copied with memcpy");
+
+private:
+    std::atomic<uint32_t> sequence{0}; // Odd while a write is in progress
+    T value{};
+
+public:
+    // Writer thread only
+    void Store(const T &newValue)
+    {
+        uint32_t s = sequence.load(std::memory_order_relaxed);
+        sequence.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&value, &newValue, sizeof(T));
+        sequence.store(s + 2, std::memory_order_release);
+    }
+
+    // False if a write was in progress; the caller can retry or keep its old copy
+    bool TryLoad(T &out) const
+    {
+        uint32_t before = sequence.load(std::memory_order_acquire);
+        if (before & 1)
+            return false;
+        std::memcpy(&out, &value, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return sequence.load(std::memory_order_relaxed) == before;
+    }
+
+    T Load() const
+    {
+        T out;
+        while (!TryLoad(out))
+        {
+        }
+        return out;
+    }
+};
+
+#endif // SEQ_LOCK_HPP
@@ -0,0 +1,229 @@
+#ifndef SORTED_RUNS_HPP
+#define SORTED_RUNS_HPP
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// SortedRuns - external sort for builders that produce more records than fit
+// in memory. Batches are sorted and spilled to run files (prefix + ".runN");
+// Merge() streams every record back in order. At most MAX_FAN_IN runs are
+// open at a time: with more, they are first merged into longer runs, so a
+// small memory budget on a huge input never runs into the descriptor limit.
+//
+// Records are written raw, so they must be trivially copyable. Equal records
+// are not combined; Merge() hands them to emit one after the other. Spill()
+// may be called from several threads, Merge() only once everything has been
+// spilled. Run files are removed by Merge() and the destructor.
+
+template <typename Record, typename Less = std::less<Record>>
+class SortedRuns
+{
+    static_assert(std::is_trivially_copyable<Record>::value, "Runs are written as raw bytes");
+
+public:
+    static constexpr std::size_t MAX_FAN_IN = 64;
+
+    explicit SortedRuns(const std::string &pathPrefix) : prefix(pathPrefix) {}
+    ~SortedRuns()
+    {
+        for (const std::string &path : live)
+            std::remove(path.c_str());
+    }
+
+    SortedRuns(const SortedRuns &) = delete;
+    SortedRuns &operator=(const SortedRuns &) = delete;
+
+    // Sorts records and writes them as a new run; records is left empty
+    bool Spill(std::vector<Record> &records)
+    {
+        if (records.empty())
+            return true;
+
+        std::sort(records.begin(), records.end(), Less());
+        std::string path;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            path = NewPath();
+            spilled++;
+        }
+        bool ok = WriteRun(path, records.data(), records.size());
+        records.clear();
+        return ok;
+    }
+
+    std::size_t Spilled() const { return spilled; }
+
+    // Calls emit(record) for every spilled record in sorted order; stops and
+    // returns false as soon as emit does
+    template <typename Emit>
+    bool Merge(Emit emit)
+    {
+        std::vector<std::string> paths = live;
+        bool ok = Reduce(paths) && MergeFiles(paths, emit);
+        for (const std::string &path : live)
+            std::remove(path.c_str());
+        live.clear();
+        return ok;
+    }
+
+private:
+    // Sequential reader over one run file
+    class RunReader
+    {
+    private:
+        std::FILE *file = nullptr;
+        std::vector<Record> buffer;
+        std::size_t pos = 0;
+        std::size_t len = 0;
+
+    public:
+        RunReader() : buffer(4096) {}
+        ~RunReader()
+        {
+            if (file != nullptr)
+                std::fclose(file);
+        }
+
+        bool Open(const std::string &path)
+        {
+            file = std::fopen(path.c_str(), "rb");
+            return file != nullptr;
+        }
+
+        bool Next(Record &record)
+        {
+            if (pos == len)
+            {
+                len = std::fread(buffer.data(), sizeof(Record), buffer.size(), file);
+                pos = 0;
+                if (len == 0)
+                    return false;
+            }
+            record = buffer[pos++];
+            return true;
+        }
+    };
+
+    std::string prefix;
+    std::mutex mutex;
+    std::vector<std::string> live; // Every run file still on disk
+    std::size_t spilled = 0;
+    std::size_t nextRun = 0;
+
+    std::string NewPath()
+    {
+        live.push_back(prefix + ".run" + std::to_string(nextRun++));
+        return live.back();
+    }
+
+    static bool WriteRun(const std::string &path, const Record *records, std::size_t count)
+    {
+        std::FILE *out = std::fopen(path.c_str(), "wb");
+        bool ok = out != nullptr && std::fwrite(records, sizeof(Record), count, out) == count;
+        ok = (out != nullptr && std::fclose(out) == 0) && ok;
+        if (!ok)
+            std::cerr << "SortedRuns: Could not write run file " << path << std::endl;
+        return ok;
+    }
+
+    template <typename Emit>
+    static bool MergeFiles(const std::vector<std::string> &paths, Emit &emit)
+    {
+        std::vector<RunReader> readers(paths.size());
+        for (std::size_t i = 0; i < paths.size(); i++)
+        {
+            if (!readers[i].Open(paths[i]))
+            {
+                std::cerr << "SortedRuns: Could not reopen run file " << paths[i] << std::endl;
+                return false;
+            }
+        }
+
+        using HeapItem = std::pair<Record, std::size_t>;
+        auto greater = [](const HeapItem &a, const HeapItem &b) { return Less()(b.first, a.first); };
+        std::priority_queue<HeapItem, std::vector<HeapItem>, decltype(greater)> heap(greater);
+        for (std::size_t i = 0; i < readers.size(); i++)
+        {
+            Record r;
+            if (readers[i].Next(r))
+                heap.push({r, i});
+        }
+
+        while (!heap.empty())
+        {
+            HeapItem top = heap.top();
+            heap.pop();
+
+            Record next;
+            if (readers[top.second].Next(next))
+                heap.push({next, top.second});
+
+            if (!emit(top.first))
+                return false;
+        }
+        return true;
+    }
+
+    // Merges groups of MAX_FAN_IN runs into longer runs until one merge can take them all
+    bool Reduce(std::vector<std::string> &paths)
+    {
+        while (paths.size() > MAX_FAN_IN)
+        {
+            std::vector<std::string> merged;
+            for (std::size_t first = 0; first < paths.size(); first += MAX_FAN_IN)
+            {
+                std::vector<std::string> group(paths.begin() + first,
+                                               paths.begin() + std::min(first + MAX_FAN_IN, paths.size()));
+                if (group.size() == 1)
+                {
+                    merged.push_back(group.front());
+                    continue;
+                }
+
+                std::string path = NewPath();
+                std::FILE *out = std::fopen(path.c_str(), "wb");
+                std::vector<Record> buffer;
+                buffer.reserve(4096);
+                auto flush = [&]()
+                {
+                    bool written = buffer.empty() ||
+                                   std::fwrite(buffer.data(), sizeof(Record), buffer.size(), out) == buffer.size();
+                    buffer.clear();
+                    return written;
+                };
+                auto append = [&](const Record &r)
+                {
+                    buffer.push_back(r);
+                    return buffer.size() < buffer.capacity() || flush();
+                };
+
+                bool ok = out != nullptr && MergeFiles(group, append) && flush();
+                ok = (out != nullptr && std::fclose(out) == 0) && ok;
+                if (!ok)
+                {
+                    std::cerr << "SortedRuns: Could not write run file " << path << std::endl;
+                    return false;
+                }
+
+                for (const std::string &done : group)
+                {
+                    std::remove(done.c_str());
+                    live.erase(std::find(live.begin(), live.end(), done));
+                }
+                merged.push_back(path);
+            }
+            paths.swap(merged);
+        }
+        return true;
+    }
+};
+
+#endif // SORTED_RUNS_HPP
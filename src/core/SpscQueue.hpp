@@ -0,0 +1,58 @@
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// SpscQueue - fixed-size ring buffer for exactly one producer thread and one
+// consumer thread. Push and Pop never lock or allocate, so the render loop
+// can poll it every frame for free.
+
+template <typename T, std::size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+private:
+    static constexpr std::size_t CACHE_LINE = 64;
+
+    T slots[Capacity];
+
+    // head is written by the consumer, tail by the producer. The padding keeps
+    // them on separate cache lines so the two threads do not fight over one.
+    std::atomic<std::size_t> head{0};
+    char headPadding[CACHE_LINE - sizeof(std::atomic<std::size_t>)];
+    std::atomic<std::size_t> tail{0};
+    char tailPadding[CACHE_LINE - sizeof(std::atomic<std::size_t>)];
+
+public:
+    // Producer only. Returns false if the queue is full.
+    bool Push(T value)
+    {
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == Capacity)
+            return false;
+        slots[t & (Capacity - 1)] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Returns false if the queue is empty.
+    bool Pop(T &out)
+    {
+        std::size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+        out = std::move(slots[h & (Capacity - 1)]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Empty() const
+    {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+};
+
+#endif // SPSC_QUEUE_HPP
@@ -0,0 +1,1476 @@
+#include "Tablebase.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace PositionCodes;
+
+namespace
+{
+    enum ProbeState
+    {
+        PROBE_FAIL = 0,
+        PROBE_OK = 1,
+        PROBE_CHANGE_STM = -1,  // The DTZ file only stores the other side to move
+        PROBE_ZEROING_BEST = 2  // Best move is a capture or pawn move, the stored DTZ does not apply
+    };
+
+    // Per-section flags; all but the last only appear in DTZ files
+    enum PairsFlag
+    {
+        FLAG_STM = 1,         // Side to move stored, 0 = white
+        FLAG_MAPPED = 2,      // Values go through the DTZ map
+        FLAG_WIN_PLIES = 4,   // Wins stored in plies rather than moves
+        FLAG_LOSS_PLIES = 8,
+        FLAG_WIDE = 16,       // 16-bit DTZ map
+        FLAG_SINGLE_VALUE = 128
+    };
+
+    const unsigned char WDL_MAGIC[4] = {0x71, 0xE8, 0x23, 0x5D};
+    const unsigned char DTZ_MAGIC[4] = {0xD7, 0x66, 0x0C, 0xA5};
+
+    // Syzygy numbers pieces P N B R Q K = 1-6 for white and adds 8 for black
+    const int syzygyType[7] = {0, 4, 2, 3, 5, 6, 1}; // Indexed by PositionCodes type
+
+    int SyzygyPiece(int code)
+    {
+        return syzygyType[TypeOf(code)] | (ColorOf(code) == 1 ? 0 : 8);
+    }
+
+    uint16_t ReadLE16(const unsigned char *p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+
+    uint32_t ReadLE32(const unsigned char *p)
+    {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+               (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    uint32_t ReadBE32(const unsigned char *p)
+    {
+        return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+               (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+    }
+
+    uint64_t ReadBE64(const unsigned char *p)
+    {
+        return (static_cast<uint64_t>(ReadBE32(p)) << 32) | ReadBE32(p + 4);
+    }
+
+    // Rank minus file: 0 on the a1-h8 diagonal, negative below it
+    int OffDiagonal(int sq) { return RankOf(sq) - FileOf(sq); }
+
+    int Sign(int value) { return (value > 0) - (value < 0); }
+
+    // Index tables of the Syzygy encoding, the same for every file
+    struct Encoding
+    {
+        int mapPawns[64];       // a2-h7 to 47..0, edge files and low ranks first
+        int mapB1H1H7[64];      // Squares below the a1-h8 diagonal to 0..27
+        int mapA1D1D4[64];      // a1-d1-d4 triangle to 0..9, diagonal last
+        int mapKK[10][64];      // The 462 legal king pairs with the first king in the triangle
+        uint64_t binomial[7][64];
+        int leadPawnIdx[6][64]; // [leading pawns][square of the first one]
+        int leadPawnsSize[6][4]; // [leading pawns][file a-d]
+
+        Encoding()
+        {
+            std::memset(this, 0, sizeof(*this));
+
+            int code = 0;
+            for (int sq = 0; sq < 64; sq++)
+            {
+                if (OffDiagonal(sq) < 0)
+                    mapB1H1H7[sq] = code++;
+            }
+
+            std::vector<int> diagonal;
+            code = 0;
+            for (int sq = 0; sq < 64; sq++)
+            {
+                mapA1D1D4[sq] = -1;
+                if (FileOf(sq) > 3 || RankOf(sq) > 3)
+                    continue;
+                if (OffDiagonal(sq) < 0)
+                    mapA1D1D4[sq] = code++;
+                else if (OffDiagonal(sq) == 0)
+                    diagonal.push_back(sq);
+            }
+            for (int sq : diagonal)
+                mapA1D1D4[sq] = code++;
+
+            // Second king not touching the first; with the first king on the
+            // diagonal, not above it either. Both on the diagonal go last.
+            std::vector<std::pair<int, int>> bothOnDiagonal;
+            code = 0;
+            for (int idx = 0; idx < 10; idx++)
+            {
+                for (int s1 = 0; s1 < 64; s1++)
+                {
+                    if (mapA1D1D4[s1] != idx)
+                        continue;
+                    for (int s2 = 0; s2 < 64; s2++)
+                    {
+                        if (std::abs(FileOf(s1) - FileOf(s2)) <= 1 && std::abs(RankOf(s1) - RankOf(s2)) <= 1)
+                            continue;
+                        if (OffDiagonal(s1) == 0 && OffDiagonal(s2) > 0)
+                            continue;
+                        if (OffDiagonal(s1) == 0 && OffDiagonal(s2) == 0)
+                            bothOnDiagonal.emplace_back(idx, s2);
+                        else
+                            mapKK[idx][s2] = code++;
+                    }
+                }
+            }
+            for (const auto &kk : bothOnDiagonal)
+                mapKK[kk.first][kk.second] = code++;
+
+            for (int n = 0; n < 64; n++)
+            {
+                for (int k = 0; k < 7; k++)
+                    binomial[k][n] = (k == 0) ? 1 : (n == 0 ? 0 : binomial[k - 1][n - 1] + binomial[k][n - 1]);
+            }
+
+            int available = 47;
+            for (int lead = 1; lead <= 5; lead++)
+            {
+                for (int file = 0; file < 4; file++)
+                {
+                    int idx = 0;
+                    for (int rank = 1; rank <= 6; rank++)
+                    {
+                        int sq = MakeSquare(file, rank);
+                        if (lead == 1)
+                        {
+                            mapPawns[sq] = available--;
+                            mapPawns[sq ^ 7] = available--;
+                        }
+                        leadPawnIdx[lead][sq] = idx;
+                        idx += static_cast<int>(binomial[lead - 1][mapPawns[sq]]);
+                    }
+                    leadPawnsSize[lead][file] = idx;
+                }
+            }
+        }
+    };
+
+    const Encoding encoding;
+
+    bool ByMapPawns(int a, int b) { return encoding.mapPawns[a] < encoding.mapPawns[b]; }
+
+    // Decoding data for one side to move (and one leading pawn file) of a file
+    struct PairsData
+    {
+        int flags = 0;
+        int maxSymLen = 0;
+        int minSymLen = 0;          // Single value sections store their value here
+        uint32_t numBlocks = 0;
+        uint64_t blockSize = 0;
+        uint64_t span = 0;          // A sparse index entry every span values
+        const unsigned char *lowestSym = nullptr;   // 16-bit lowest symbol per code length
+        const unsigned char *btree = nullptr;       // 3 bytes per symbol: two 12-bit children
+        const unsigned char *blockLength = nullptr; // 16-bit values per block, minus one
+        uint32_t blockLengthSize = 0;
+        const unsigned char *sparseIndex = nullptr; // 6 bytes per entry: 32-bit block, 16-bit offset
+        uint64_t sparseIndexSize = 0;
+        const unsigned char *data = nullptr;        // Huffman coded blocks
+        std::vector<uint64_t> base64;               // Lowest code of each length, left aligned
+        std::vector<uint8_t> symlen;                // Values a symbol expands to, minus one
+        int pieces[TB_MAX_PIECES] = {};             // Piece order, which also defines the groups
+        uint64_t groupIdx[TB_MAX_PIECES + 1] = {};
+        int groupLen[TB_MAX_PIECES + 1] = {};
+        uint16_t mapIdx[4] = {};                    // DTZ map start for win, loss, cursed win, blessed loss
+    };
+
+    int LeftChild(const PairsData &d, int sym)
+    {
+        const unsigned char *lr = d.btree + 3 * sym;
+        return ((lr[1] & 0xF) << 8) | lr[0];
+    }
+
+    int RightChild(const PairsData &d, int sym)
+    {
+        const unsigned char *lr = d.btree + 3 * sym;
+        return (lr[2] << 4) | (lr[1] >> 4);
+    }
+
+    // Symbols are leaves or pairs of earlier symbols (recursive pairing)
+    uint8_t SetSymlen(PairsData &d, int sym, std::vector<bool> &visited)
+    {
+        visited[sym] = true;
+        int right = RightChild(d, sym);
+        if (right == 0xFFF)
+            return 0;
+
+        int left = LeftChild(d, sym);
+        if (left >= static_cast<int>(d.symlen.size()) || right >= static_cast<int>(d.symlen.size()))
+            return 0;
+        if (!visited[left])
+            d.symlen[left] = SetSymlen(d, left, visited);
+        if (!visited[right])
+            d.symlen[right] = SetSymlen(d, right, visited);
+        return static_cast<uint8_t>(d.symlen[left] + d.symlen[right] + 1);
+    }
+
+    // Value number idx of a section
+    int DecompressPairs(const PairsData &d, uint64_t idx)
+    {
+        if (d.flags & FLAG_SINGLE_VALUE)
+            return d.minSymLen;
+
+        // Sparse index entry k points at value k * span + span / 2; walk from
+        // there to the block that holds idx
+        uint64_t k = idx / d.span;
+        uint32_t block = ReadLE32(d.sparseIndex + 6 * k);
+        int64_t offset = ReadLE16(d.sparseIndex + 6 * k + 4);
+        offset += static_cast<int64_t>(idx % d.span) - static_cast<int64_t>(d.span / 2);
+
+        while (offset < 0)
+            offset += ReadLE16(d.blockLength + 2 * --block) + 1;
+        while (offset > ReadLE16(d.blockLength + 2 * block))
+            offset -= ReadLE16(d.blockLength + 2 * block++) + 1;
+
+        // Canonical Huffman codes: longer codes have lower values, so the
+        // length of the next code is found by comparing against base64
+        const unsigned char *ptr = d.data + block * d.blockSize;
+        uint64_t buf64 = ReadBE64(ptr);
+        ptr += 8;
+        int buf64Size = 64;
+        int sym;
+
+        while (true)
+        {
+            int len = 0;
+            while (buf64 < d.base64[len])
+                len++;
+
+            sym = static_cast<int>((buf64 - d.base64[len]) >> (64 - len - d.minSymLen));
+            sym += ReadLE16(d.lowestSym + 2 * len);
+
+            if (offset < d.symlen[sym] + 1)
+                break;
+
+            offset -= d.symlen[sym] + 1;
+            len += d.minSymLen;
+            buf64 <<= len;
+            buf64Size -= len;
+            if (buf64Size <= 32)
+            {
+                buf64Size += 32;
+                buf64 |= static_cast<uint64_t>(ReadBE32(ptr)) << (64 - buf64Size);
+                ptr += 4;
+            }
+        }
+
+        // The symbol stands for symlen + 1 values; descend to the one at offset
+        while (d.symlen[sym])
+        {
+            int left = LeftChild(d, sym);
+            if (offset < d.symlen[left] + 1)
+            {
+                sym = left;
+            }
+            else
+            {
+                offset -= d.symlen[left] + 1;
+                sym = RightChild(d, sym);
+            }
+        }
+        return LeftChild(d, sym);
+    }
+
+    // Reads the Huffman tables of one section; nullptr if the file ends early
+    const unsigned char *SetSizes(PairsData &d, const unsigned char *data, const unsigned char *end)
+    {
+        if (end - data < 2)
+            return nullptr;
+
+        d.flags = *data++;
+        if (d.flags & FLAG_SINGLE_VALUE)
+        {
+            d.minSymLen = *data++;
+            return data;
+        }
+        if (end - data < 9)
+            return nullptr;
+
+        // groupIdx after the last group is the number of indices
+        uint64_t tableSize = d.groupIdx[std::find(d.groupLen, d.groupLen + TB_MAX_PIECES, 0) - d.groupLen];
+
+        d.blockSize = 1ULL << *data++;
+        d.span = 1ULL << *data++;
+        d.sparseIndexSize = (tableSize + d.span - 1) / d.span;
+        int padding = *data++;
+        d.numBlocks = ReadLE32(data);
+        data += 4;
+        d.blockLengthSize = d.numBlocks + padding;
+        d.maxSymLen = *data++;
+        d.minSymLen = *data++;
+        if (d.minSymLen < 1 || d.maxSymLen < d.minSymLen || d.maxSymLen > 32)
+            return nullptr;
+
+        d.lowestSym = data;
+        d.base64.assign(static_cast<std::size_t>(d.maxSymLen - d.minSymLen + 1), 0);
+        if (end - data < static_cast<std::ptrdiff_t>(2 * d.base64.size() + 2))
+            return nullptr;
+
+        for (int i = static_cast<int>(d.base64.size()) - 2; i >= 0; i--)
+        {
+            d.base64[i] = (d.base64[i + 1] + ReadLE16(d.lowestSym + 2 * i) -
+                           ReadLE16(d.lowestSym + 2 * (i + 1))) / 2;
+        }
+        for (std::size_t i = 0; i < d.base64.size(); i++)
+            d.base64[i] <<= 64 - i - d.minSymLen;
+
+        data += 2 * d.base64.size();
+        d.symlen.assign(ReadLE16(data), 0);
+        data += 2;
+        d.btree = data;
+        if (end - data < static_cast<std::ptrdiff_t>(3 * d.symlen.size()))
+            return nullptr;
+
+        std::vector<bool> visited(d.symlen.size());
+        for (std::size_t sym = 0; sym < d.symlen.size(); sym++)
+        {
+            if (!visited[sym])
+                d.symlen[sym] = SetSymlen(d, static_cast<int>(sym), visited);
+        }
+        return data + 3 * d.symlen.size() + (d.symlen.size() & 1);
+    }
+
+    // Material of one side, strongest piece first, e.g. "KRP"
+    std::string SideString(const Position &pos, int color)
+    {
+        static const int order[5] = {QUEEN, ROOK, BISHOP, KNIGHT, PAWN};
+        static const char letters[5] = {'Q', 'R', 'B', 'N', 'P'};
+
+        std::string s = "K";
+        for (int i = 0; i < 5; i++)
+            s.append(static_cast<std::size_t>(pos.PieceCount(color, order[i])), letters[i]);
+        return s;
+    }
+
+    // File names list the side with more pieces first, or with equal counts
+    // the side whose pieces are stronger going down the list
+    bool ListedFirst(const std::string &a, const std::string &b)
+    {
+        if (a.size() != b.size())
+            return a.size() > b.size();
+
+        static const std::string strength = "PNBRQK";
+        for (std::size_t i = 0; i < a.size(); i++)
+        {
+            if (a[i] != b[i])
+                return strength.find(a[i]) > strength.find(b[i]);
+        }
+        return true;
+    }
+
+    // .ctb layout: a1-d1-d4 triangle, where the white king of a pawnless table is folded to
+    const int triangleSquares[10] = {0, 1, 2, 3, 9, 10, 11, 18, 19, 27};
+
+    struct TriangleIndex
+    {
+        int values[64];
+
+        TriangleIndex()
+        {
+            for (int &v : values)
+                v = -1;
+            for (int i = 0; i < 10; i++)
+                values[triangleSquares[i]] = i;
+        }
+    };
+
+    const TriangleIndex triangleIndex;
+
+    // .ctb order within a side, strongest first
+    const int sideOrder[5] = {QUEEN, ROOK, BISHOP, KNIGHT, PAWN};
+    const char sideLetters[5] = {'Q', 'R', 'B', 'N', 'P'};
+    const int materialValue[7] = {0, 5, 3, 3, 9, 0, 1};
+
+    std::string SideString(const Position &pos, int color, int &value)
+    {
+        std::string s = SideString(pos, color);
+        value = 0;
+        for (int i = 0; i < 5; i++)
+            value += pos.PieceCount(color, sideOrder[i]) * materialValue[sideOrder[i]];
+        return s;
+    }
+
+    bool HasEnPassantCapture(const Position &pos)
+    {
+        if (pos.EpSquare() < 0)
+            return false;
+        MoveList moves;
+        pos.GenerateLegalMoves(moves);
+        for (const Move &m : moves)
+        {
+            if (m.flags & MOVE_EN_PASSANT)
+                return true;
+        }
+        return false;
+    }
+
+    // Only kings, or kings and a single minor piece: mate is impossible
+    bool IsDeadDraw(const Position &pos)
+    {
+        int minors = 0;
+        for (int color = 0; color < 2; color++)
+        {
+            if (pos.PieceCount(color, QUEEN) || pos.PieceCount(color, ROOK) || pos.PieceCount(color, PAWN))
+                return false;
+            minors += pos.PieceCount(color, BISHOP) + pos.PieceCount(color, KNIGHT);
+        }
+        return minors <= 1;
+    }
+
+    // A capture or pawn move resets the count, so its DTZ is known from the WDL score
+    int DtzBeforeZeroing(int wdl)
+    {
+        return wdl == 2 ? 1 : wdl == 1 ? 101 : wdl == -1 ? -101 : wdl == -2 ? -1 : 0;
+    }
+
+    // Higher is better: wins inside the 50-move rule (fastest first), wins it
+    // spoils, draws, losses it may save, then certain losses (longest first)
+    int MoveRank(int dtz, int halfmoveClock)
+    {
+        if (dtz > 0)
+            return (dtz + halfmoveClock <= 100) ? 40000 - dtz : 20000 - dtz;
+        if (dtz < 0)
+            return (-dtz + halfmoveClock <= 100) ? -40000 - dtz : -20000 - dtz;
+        return 0;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// TablebaseLayout
+// ---------------------------------------------------------------------------
+
+bool TablebaseLayout::Init(const std::string &sig)
+{
+    std::size_t split = sig.find('v');
+    if (split == std::string::npos || sig.size() > 15)
+        return false;
+
+    std::string sides[2] = {sig.substr(0, split), sig.substr(split + 1)};
+    int count = 2;
+    int newCodes[TB_CTB_MAX_PIECES] = {MakeCode(KING, 1), MakeCode(KING, 0)};
+    bool pawns = false;
+
+    for (int s = 0; s < 2; s++)
+    {
+        const std::string &side = sides[s];
+        if (side.empty() || side[0] != 'K')
+            return false;
+
+        int lastOrder = 0;
+        for (std::size_t i = 1; i < side.size(); i++)
+        {
+            int order = -1;
+            for (int k = 0; k < 5; k++)
+            {
+                if (side[i] == sideLetters[k])
+                    order = k;
+            }
+            if (order < lastOrder || count >= TB_CTB_MAX_PIECES)
+                return false;
+            lastOrder = order;
+
+            newCodes[count++] = MakeCode(sideOrder[order], s == 0 ? 1 : 0);
+            if (sideOrder[order] == PAWN)
+                pawns = true;
+        }
+    }
+
+    signature = sig;
+    pieceCount = count;
+    hasPawns = pawns;
+    std::memcpy(codes, newCodes, sizeof(codes));
+
+    size = hasPawns ? 32 : 10;
+    for (int i = 1; i < pieceCount; i++)
+        size *= 64;
+    size *= 2; // Side to move
+    return true;
+}
+
+std::string TablebaseLayout::SignatureOf(const Position &pos, bool &flipped)
+{
+    int whiteValue = 0, blackValue = 0;
+    std::string white = SideString(pos, 1, whiteValue);
+    std::string black = SideString(pos, 0, blackValue);
+
+    flipped = (blackValue > whiteValue) || (blackValue == whiteValue && black > white);
+    return flipped ? black + "v" + white : white + "v" + black;
+}
+
+uint64_t TablebaseLayout::Index(const Position &pos) const
+{
+    int squares[TB_CTB_MAX_PIECES];
+    for (int i = 0; i < pieceCount; i++)
+    {
+        int start = (i > 0 && codes[i] == codes[i - 1]) ? squares[i - 1] + 1 : 0;
+        squares[i] = start;
+        for (int sq = start; sq < 64; sq++)
+        {
+            if (pos.PieceAt(sq) == codes[i])
+            {
+                squares[i] = sq;
+                break;
+            }
+        }
+    }
+
+    // Fold the white king with mirror images of the whole board
+    int mirror = 0;
+    if (FileOf(squares[0]) > 3)
+        mirror ^= 7;
+    if (!hasPawns && RankOf(squares[0]) > 3)
+        mirror ^= 56;
+    for (int i = 0; i < pieceCount; i++)
+        squares[i] ^= mirror;
+
+    if (hasPawns)
+        return PackIndex(squares, static_cast<uint64_t>(RankOf(squares[0]) * 4 + FileOf(squares[0])), pos.SideToMove());
+
+    auto swapDiagonal = [&](int *sqs)
+    {
+        for (int i = 0; i < pieceCount; i++)
+            sqs[i] = MakeSquare(RankOf(sqs[i]), FileOf(sqs[i]));
+    };
+
+    if (RankOf(squares[0]) > FileOf(squares[0]))
+        swapDiagonal(squares);
+
+    uint64_t index = PackIndex(squares, static_cast<uint64_t>(triangleIndex.values[squares[0]]), pos.SideToMove());
+
+    // A king on the diagonal leaves two images in the triangle; keep the smaller index
+    if (RankOf(squares[0]) == FileOf(squares[0]))
+    {
+        swapDiagonal(squares);
+        index = std::min(index, PackIndex(squares, static_cast<uint64_t>(triangleIndex.values[squares[0]]), pos.SideToMove()));
+    }
+    return index;
+}
+
+uint64_t TablebaseLayout::PackIndex(int *squares, uint64_t kingIndex, int sideToMove) const
+{
+    // Identical pieces are stored in square order, so each position has one index
+    for (int i = 2; i < pieceCount; i++)
+    {
+        for (int j = i; j > 1 && codes[j] == codes[j - 1] && squares[j] < squares[j - 1]; j--)
+            std::swap(squares[j], squares[j - 1]);
+    }
+
+    uint64_t index = kingIndex;
+    for (int i = 1; i < pieceCount; i++)
+        index = index * 64 + static_cast<uint64_t>(squares[i]);
+
+    return index * 2 + (sideToMove == 1 ? 0 : 1);
+}
+
+bool TablebaseLayout::Decode(uint64_t index, Position &pos) const
+{
+    if (index >= size)
+        return false;
+
+    const uint64_t original = index;
+    int sideToMove = (index & 1) ? 0 : 1;
+    index >>= 1;
+
+    int squares[TB_CTB_MAX_PIECES];
+    for (int i = pieceCount - 1; i >= 1; i--)
+    {
+        squares[i] = static_cast<int>(index % 64);
+        index /= 64;
+    }
+    int kingIndex = static_cast<int>(index);
+    squares[0] = hasPawns ? MakeSquare(kingIndex % 4, kingIndex / 4) : triangleSquares[kingIndex];
+
+    uint64_t occupied = 0;
+    for (int i = 0; i < pieceCount; i++)
+    {
+        uint64_t bit = 1ULL << squares[i];
+        if (occupied & bit)
+            return false;
+        occupied |= bit;
+
+        int rank = RankOf(squares[i]);
+        if (TypeOf(codes[i]) == PAWN && (rank == 0 || rank == 7))
+            return false;
+    }
+
+    pos.Clear();
+    for (int i = 0; i < pieceCount; i++)
+        pos.AddPiece(squares[i], codes[i]);
+    pos.SetSideToMove(sideToMove);
+
+    // Also rejects touching kings
+    if (pos.IsSquareAttacked(pos.KingSquare(1 - sideToMove), sideToMove))
+        return false;
+
+    // Symmetric duplicates of another index are left unused
+    return Index(pos) == original;
+}
+
+// ---------------------------------------------------------------------------
+// Table
+// ---------------------------------------------------------------------------
+
+struct Tablebase::Table
+{
+    MappedFile file;
+    bool dtz = false;
+    std::string firstSide;     // Material listed first in the file name, stored as white
+    int pieceCount = 0;
+    bool hasPawns = false;
+    bool hasUniquePieces = false;
+    bool symmetric = false;    // Same material on both sides: only white to move is stored
+    int pawnCount[2] = {0, 0}; // Leading pawn colour, other colour
+    PairsData items[2][4];     // [side to move][leading pawn file a-d, 0 without pawns]
+    const unsigned char *dtzMap = nullptr;
+
+    PairsData *Get(int stm, int file) { return &items[dtz ? 0 : stm][hasPawns ? file : 0]; }
+
+    bool Init(const std::string &name);
+    bool Setup(const unsigned char *data, const unsigned char *end);
+    void SetGroups(PairsData &d, const int order[2], int file);
+    const unsigned char *SetDtzMap(const unsigned char *data, const unsigned char *end);
+};
+
+bool Tablebase::Table::Init(const std::string &name)
+{
+    std::size_t split = name.find('v');
+    if (split == std::string::npos)
+        return false;
+
+    firstSide = name.substr(0, split);
+    std::string second = name.substr(split + 1);
+    pieceCount = static_cast<int>(name.size()) - 1;
+    symmetric = firstSide == second;
+    hasPawns = name.find('P') != std::string::npos;
+
+    int pawns[2] = {0, 0};
+    for (int side = 0; side < 2; side++)
+    {
+        const std::string &s = side == 0 ? firstSide : second;
+        for (char piece : std::string("QRBNP"))
+        {
+            std::ptrdiff_t count = std::count(s.begin(), s.end(), piece);
+            if (count == 1)
+                hasUniquePieces = true;
+            if (piece == 'P')
+                pawns[side] = static_cast<int>(count);
+        }
+    }
+
+    // The side with fewer pawns leads, as long as it has any
+    bool firstLeads = pawns[1] == 0 || (pawns[0] > 0 && pawns[1] >= pawns[0]);
+    pawnCount[0] = firstLeads ? pawns[0] : pawns[1];
+    pawnCount[1] = firstLeads ? pawns[1] : pawns[0];
+    return pieceCount <= TB_MAX_PIECES;
+}
+
+// Groups are encoded together: the leading three unique pieces (or the two
+// kings, or the leading pawns), then runs of identical pieces. order[] says
+// in which order the groups make up the index.
+void Tablebase::Table::SetGroups(PairsData &d, const int order[2], int file)
+{
+    int n = 0;
+    int firstLen = hasPawns ? 0 : hasUniquePieces ? 3 : 2;
+    d.groupLen[n] = 1;
+    for (int i = 1; i < pieceCount; i++)
+    {
+        if (--firstLen > 0 || d.pieces[i] == d.pieces[i - 1])
+            d.groupLen[n]++;
+        else
+            d.groupLen[++n] = 1;
+    }
+    d.groupLen[++n] = 0;
+
+    bool bothPawns = hasPawns && pawnCount[1] > 0;
+    int next = bothPawns ? 2 : 1;
+    int freeSquares = 64 - d.groupLen[0] - (bothPawns ? d.groupLen[1] : 0);
+    uint64_t idx = 1;
+
+    for (int k = 0; next < n || k == order[0] || k == order[1]; k++)
+    {
+        if (k == order[0])
+        {
+            d.groupIdx[0] = idx;
+            idx *= hasPawns ? encoding.leadPawnsSize[d.groupLen[0]][file] : hasUniquePieces ? 31332 : 462;
+        }
+        else if (k == order[1])
+        {
+            d.groupIdx[1] = idx;
+            idx *= encoding.binomial[d.groupLen[1]][48 - d.groupLen[0]];
+        }
+        else
+        {
+            d.groupIdx[next] = idx;
+            idx *= encoding.binomial[d.groupLen[next]][freeSquares];
+            freeSquares -= d.groupLen[next++];
+        }
+    }
+    d.groupIdx[n] = idx;
+}
+
+// DTZ values are stored as ranks by frequency; the map turns them back
+const unsigned char *Tablebase::Table::SetDtzMap(const unsigned char *data, const unsigned char *end)
+{
+    const unsigned char *base = file.Data();
+    dtzMap = data;
+
+    for (int f = 0; f <= (hasPawns ? 3 : 0); f++)
+    {
+        PairsData &d = *Get(0, f);
+        if (!(d.flags & FLAG_MAPPED))
+            continue;
+
+        if (d.flags & FLAG_WIDE)
+        {
+            data += (data - base) & 1;
+            for (int i = 0; i < 4; i++)
+            {
+                if (end - data < 2)
+                    return nullptr;
+                d.mapIdx[i] = static_cast<uint16_t>((data - dtzMap) / 2 + 1);
+                data += 2 * ReadLE16(data) + 2;
+            }
+        }
+        else
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                if (end - data < 1)
+                    return nullptr;
+                d.mapIdx[i] = static_cast<uint16_t>(data - dtzMap + 1);
+                data += *data + 1;
+            }
+        }
+    }
+    return data + ((data - base) & 1);
+}
+
+bool Tablebase::Table::Setup(const unsigned char *data, const unsigned char *end)
+{
+    const unsigned char *base = file.Data();
+    if (end - data < 1)
+        return false;
+
+    int header = *data++;
+    if (((header & 2) != 0) != hasPawns || ((header & 1) != 0) == symmetric)
+        return false;
+
+    int sides = (!dtz && !symmetric) ? 2 : 1;
+    int files = hasPawns ? 4 : 1;
+    bool bothPawns = hasPawns && pawnCount[1] > 0;
+
+    for (int f = 0; f < files; f++)
+    {
+        if (end - data < 1 + bothPawns + pieceCount)
+            return false;
+
+        int order[2][2] = {{data[0] & 0xF, bothPawns ? data[1] & 0xF : 0xF},
+                           {data[0] >> 4, bothPawns ? data[1] >> 4 : 0xF}};
+        data += 1 + bothPawns;
+
+        for (int k = 0; k < pieceCount; k++, data++)
+        {
+            for (int i = 0; i < sides; i++)
+                Get(i, f)->pieces[k] = i ? *data >> 4 : *data & 0xF;
+        }
+
+        for (int i = 0; i < sides; i++)
+        {
+            PairsData &d = *Get(i, f);
+            SetGroups(d, order[i], f);
+            if (hasPawns && d.groupLen[0] > 5)
+                return false;
+        }
+    }
+    data += (data - base) & 1;
+
+    for (int f = 0; f < files; f++)
+    {
+        for (int i = 0; i < sides; i++)
+        {
+            data = SetSizes(*Get(i, f), data, end);
+            if (data == nullptr)
+                return false;
+        }
+    }
+
+    if (dtz && (data = SetDtzMap(data, end)) == nullptr)
+        return false;
+
+    for (int f = 0; f < files; f++)
+    {
+        for (int i = 0; i < sides; i++)
+        {
+            Get(i, f)->sparseIndex = data;
+            data += 6 * Get(i, f)->sparseIndexSize;
+        }
+    }
+    for (int f = 0; f < files; f++)
+    {
+        for (int i = 0; i < sides; i++)
+        {
+            Get(i, f)->blockLength = data;
+            data += 2 * static_cast<uint64_t>(Get(i, f)->blockLengthSize);
+        }
+    }
+    for (int f = 0; f < files; f++)
+    {
+        for (int i = 0; i < sides; i++)
+        {
+            data += (64 - (data - base) % 64) % 64; // Blocks start on a cache line
+            Get(i, f)->data = data;
+            data += Get(i, f)->numBlocks * Get(i, f)->blockSize;
+        }
+    }
+    return data <= end;
+}
+
+// ---------------------------------------------------------------------------
+// Tablebase
+// ---------------------------------------------------------------------------
+
+Tablebase::Tablebase(const std::string &dir, int pieces)
+    : directory(dir), maxPieces(pieces < TB_MAX_PIECES ? pieces : TB_MAX_PIECES)
+{
+}
+
+Tablebase::~Tablebase() = default;
+
+Tablebase::Table *Tablebase::GetTable(const Position &pos, bool dtz)
+{
+    std::string white = SideString(pos, 1);
+    std::string black = SideString(pos, 0);
+    std::string name = ListedFirst(white, black) ? white + "v" + black : black + "v" + white;
+    std::string fileName = name + (dtz ? ".rtbz" : ".rtbw");
+
+    std::lock_guard<std::mutex> lock(tablesMutex);
+
+    auto it = tables.find(fileName);
+    if (it != tables.end())
+        return it->second.get();
+
+    // First probe of this material: map the file, or remember that it is missing
+    std::unique_ptr<Table> table(new Table());
+    std::string path = directory + "/" + fileName;
+    table->dtz = dtz;
+
+    if (!table->Init(name) || !table->file.Open(path))
+    {
+        tables[fileName] = nullptr;
+        return nullptr;
+    }
+
+    const unsigned char *data = table->file.Data();
+    const unsigned char *end = data + table->file.Size();
+    if (table->file.Size() < 5 || std::memcmp(data, dtz ? DTZ_MAGIC : WDL_MAGIC, 4) != 0 ||
+        !table->Setup(data + 4, end))
+    {
+        std::cerr << "Tablebase: ignoring malformed table " << path << std::endl;
+        tables[fileName] = nullptr;
+        return nullptr;
+    }
+
+    Table *result = table.get();
+    tables[fileName] = std::move(table);
+    return result;
+}
+
+bool Tablebase::CanProbe(const Position &pos) const
+{
+    if (pos.CastlingRights() != 0)
+        return false;
+
+    int pieces = 0;
+    for (int color = 0; color < 2; color++)
+    {
+        for (int type = ROOK; type <= PAWN; type++)
+            pieces += pos.PieceCount(color, type);
+    }
+    return pieces <= maxPieces;
+}
+
+int Tablebase::ProbeTable(const Position &pos, bool dtz, int wdl, int &state)
+{
+    if (!dtz && IsDeadDraw(pos))
+        return 0;
+
+    Table *entry = GetTable(pos, dtz);
+    if (entry == nullptr)
+    {
+        state = PROBE_FAIL;
+        return 0;
+    }
+
+    // Files store the first listed material as white. If black holds it, or
+    // the material is the same on both sides and black is to move, the
+    // position is looked up with colours swapped and the board mirrored.
+    bool flip = entry->symmetric ? pos.SideToMove() == 0 : SideString(pos, 1) != entry->firstSide;
+    int flipColor = flip ? 8 : 0;
+    int flipSquares = flip ? 56 : 0;
+    int stm = (flip ? 1 : 0) ^ (pos.SideToMove() == 0 ? 1 : 0); // 0 = white, as in the files
+
+    int squares[TB_MAX_PIECES];
+    int pieces[TB_MAX_PIECES];
+    int size = 0;
+    int leadPawns = 0;
+    int leadPawnCode = -1;
+    int tbFile = 0;
+
+    // With pawns, the leading pawn (nearest the edge, then lowest) picks
+    // which of the four per-file sections is used
+    if (entry->hasPawns)
+    {
+        leadPawnCode = entry->Get(0, 0)->pieces[0] ^ flipColor;
+        for (int sq = 0; sq < 64; sq++)
+        {
+            if (pos.PieceAt(sq) != 0 && SyzygyPiece(pos.PieceAt(sq)) == leadPawnCode)
+                squares[size++] = sq ^ flipSquares;
+        }
+        leadPawns = size;
+        std::swap(squares[0], *std::max_element(squares, squares + leadPawns, ByMapPawns));
+        tbFile = std::min(FileOf(squares[0]), 7 - FileOf(squares[0]));
+    }
+
+    if (dtz && (entry->Get(stm, tbFile)->flags & FLAG_STM) != stm && !(entry->symmetric && !entry->hasPawns))
+    {
+        state = PROBE_CHANGE_STM;
+        return 0;
+    }
+
+    for (int sq = 0; sq < 64; sq++)
+    {
+        int code = pos.PieceAt(sq);
+        if (code == 0 || SyzygyPiece(code) == leadPawnCode)
+            continue;
+        squares[size] = sq ^ flipSquares;
+        pieces[size++] = SyzygyPiece(code) ^ flipColor;
+    }
+
+    // Put the pieces in the order the file encodes them
+    PairsData *d = entry->Get(stm, tbFile);
+    for (int i = leadPawns; i < size - 1; i++)
+    {
+        for (int j = i + 1; j < size; j++)
+        {
+            if (d->pieces[i] == pieces[j])
+            {
+                std::swap(pieces[i], pieces[j]);
+                std::swap(squares[i], squares[j]);
+                break;
+            }
+        }
+    }
+
+    // Mirror the leading piece onto files a-d
+    if (FileOf(squares[0]) > 3)
+    {
+        for (int i = 0; i < size; i++)
+            squares[i] ^= 7;
+    }
+
+    uint64_t idx;
+    if (entry->hasPawns)
+    {
+        idx = encoding.leadPawnIdx[leadPawns][squares[0]];
+        std::stable_sort(squares + 1, squares + leadPawns, ByMapPawns);
+        for (int i = 1; i < leadPawns; i++)
+            idx += encoding.binomial[i][encoding.mapPawns[squares[i]]];
+    }
+    else
+    {
+        // Without pawns, also mirror onto ranks 1-4 and below the a1-h8 diagonal
+        if (RankOf(squares[0]) > 3)
+        {
+            for (int i = 0; i < size; i++)
+                squares[i] ^= 56;
+        }
+
+        for (int i = 0; i < d->groupLen[0]; i++)
+        {
+            if (OffDiagonal(squares[i]) == 0)
+                continue;
+            if (OffDiagonal(squares[i]) > 0)
+            {
+                for (int j = i; j < size; j++)
+                    squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+            }
+            break;
+        }
+
+        if (entry->hasUniquePieces)
+        {
+            // Three unique pieces together: the first in the triangle, then
+            // cases by how many of them sit on the diagonal
+            int adjust1 = squares[1] > squares[0];
+            int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+
+            if (OffDiagonal(squares[0]))
+                idx = (encoding.mapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+            else if (OffDiagonal(squares[1]))
+                idx = (6 * 63 + RankOf(squares[0]) * 28 + encoding.mapB1H1H7[squares[1]]) * 62 + squares[2] - adjust2;
+            else if (OffDiagonal(squares[2]))
+                idx = 6 * 63 * 62 + 4 * 28 * 62 + RankOf(squares[0]) * 7 * 28 +
+                      (RankOf(squares[1]) - adjust1) * 28 + encoding.mapB1H1H7[squares[2]];
+            else
+                idx = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + RankOf(squares[0]) * 7 * 6 +
+                      (RankOf(squares[1]) - adjust1) * 6 + (RankOf(squares[2]) - adjust2);
+        }
+        else
+        {
+            idx = encoding.mapKK[encoding.mapA1D1D4[squares[0]]][squares[1]];
+        }
+    }
+
+    // Remaining groups: identical pieces in ascending square order, each
+    // square counted among those the earlier groups left free
+    idx *= d->groupIdx[0];
+    int *groupSq = squares + d->groupLen[0];
+    bool remainingPawns = entry->hasPawns && entry->pawnCount[1] > 0;
+
+    for (int next = 1; d->groupLen[next]; next++)
+    {
+        std::stable_sort(groupSq, groupSq + d->groupLen[next]);
+        uint64_t n = 0;
+        for (int i = 0; i < d->groupLen[next]; i++)
+        {
+            int adjust = static_cast<int>(std::count_if(squares, groupSq, [&](int s) { return groupSq[i] > s; }));
+            n += encoding.binomial[i + 1][groupSq[i] - adjust - (remainingPawns ? 8 : 0)];
+        }
+        remainingPawns = false;
+        idx += n * d->groupIdx[next];
+        groupSq += d->groupLen[next];
+    }
+
+    int value = DecompressPairs(*d, idx);
+    if (!dtz)
+        return value - 2;
+
+    // DTZ: undo the frequency map, then convert moves to plies where needed
+    static const int mapSlot[5] = {1, 3, 0, 2, 0}; // By wdl + 2
+    PairsData *first = entry->Get(0, tbFile);
+    if (first->flags & FLAG_MAPPED)
+    {
+        int at = first->mapIdx[mapSlot[wdl + 2]] + value;
+        value = (first->flags & FLAG_WIDE) ? ReadLE16(entry->dtzMap + 2 * at) : entry->dtzMap[at];
+    }
+    if ((wdl == 2 && !(first->flags & FLAG_WIN_PLIES)) || (wdl == -2 && !(first->flags & FLAG_LOSS_PLIES)) ||
+        wdl == 1 || wdl == -1)
+        value *= 2;
+    return value + 1;
+}
+
+// Tables store "don't care" values where a capture is best, so captures (and
+// for DTZ pawn moves) are searched and the best of them beats the stored value
+int Tablebase::SearchCaptures(const Position &pos, bool pawnMoves, int &state)
+{
+    MoveList moves;
+    pos.GenerateLegalMoves(moves);
+
+    int bestValue = -2;
+    int searched = 0;
+    for (const Move &m : moves)
+    {
+        bool capture = (m.flags & (MOVE_CAPTURE | MOVE_EN_PASSANT)) != 0;
+        if (!capture && (!pawnMoves || TypeOf(pos.PieceAt(m.from)) != PAWN))
+            continue;
+
+        searched++;
+        Position child = pos;
+        child.MakeMove(m);
+        int value = -SearchCaptures(child, false, state);
+        if (state == PROBE_FAIL)
+            return 0;
+
+        if (value > bestValue)
+        {
+            bestValue = value;
+            if (value >= 2)
+            {
+                state = PROBE_ZEROING_BEST;
+                return value;
+            }
+        }
+    }
+
+    // With every move searched the stored value is not needed (and could be
+    // wrong, e.g. when en passant is the only move)
+    bool noMoreMoves = searched > 0 && searched == moves.count;
+    int value = bestValue;
+    if (!noMoreMoves)
+    {
+        value = ProbeTable(pos, false, 0, state);
+        if (state == PROBE_FAIL)
+            return 0;
+    }
+
+    if (bestValue >= value)
+    {
+        state = (bestValue > 0 || noMoreMoves) ? PROBE_ZEROING_BEST : PROBE_OK;
+        return bestValue;
+    }
+    state = PROBE_OK;
+    return value;
+}
+
+int Tablebase::ProbeWdl(const Position &pos, int &state)
+{
+    state = PROBE_OK;
+    return SearchCaptures(pos, false, state);
+}
+
+int Tablebase::ProbeDtz(const Position &pos, int &state)
+{
+    state = PROBE_OK;
+    int wdl = SearchCaptures(pos, true, state);
+    if (state == PROBE_FAIL || wdl == 0)
+        return 0;
+    if (state == PROBE_ZEROING_BEST)
+        return DtzBeforeZeroing(wdl);
+
+    int dtz = ProbeTable(pos, true, wdl, state);
+    if (state == PROBE_FAIL)
+        return 0;
+    if (state != PROBE_CHANGE_STM)
+        return (dtz + ((wdl == 1 || wdl == -1) ? 100 : 0)) * Sign(wdl);
+
+    // The file stores the other side to move: go one ply deeper and take the
+    // best move of the right sign
+    MoveList moves;
+    pos.GenerateLegalMoves(moves);
+    int minDtz = 0xFFFF;
+
+    for (const Move &m : moves)
+    {
+        bool zeroing = (m.flags & (MOVE_CAPTURE | MOVE_EN_PASSANT)) != 0 || TypeOf(pos.PieceAt(m.from)) == PAWN;
+        Position child = pos;
+        child.MakeMove(m);
+
+        if (zeroing)
+        {
+            dtz = -DtzBeforeZeroing(SearchCaptures(child, false, state));
+        }
+        else
+        {
+            dtz = -ProbeDtz(child, state);
+        }
+        if (state == PROBE_FAIL)
+            return 0;
+
+        if (dtz == 1 && child.InCheck())
+        {
+            MoveList replies;
+            child.GenerateLegalMoves(replies);
+            if (replies.count == 0)
+                minDtz = 1; // Mate
+        }
+
+        if (!zeroing)
+            dtz += Sign(dtz);
+        if (dtz < minDtz && Sign(dtz) == Sign(wdl))
+            minDtz = dtz;
+    }
+
+    return minDtz == 0xFFFF ? -1 : minDtz;
+}
+
+bool Tablebase::Probe(const Position &pos, TablebaseResult &out)
+{
+    if (!CanProbe(pos))
+        return false;
+
+    probeCount++;
+    int state;
+    int wdl = ProbeWdl(pos, state);
+    if (state == PROBE_FAIL)
+    {
+        if (!ProbeCtbTable(pos, out))
+            return false;
+        hitCount++;
+        return true;
+    }
+    hitCount++;
+
+    // Cursed wins and blessed losses are draws under the 50-move rule
+    out.wdl = (wdl == 2) ? 1 : (wdl == -2 ? -1 : 0);
+    out.dtz = 0;
+    out.dtm = -1;
+
+    // The WDL score assumes a fresh 50-move count; with plies already used
+    // up, the capture or pawn move has to come in time
+    if (out.wdl != 0 && pos.HalfmoveClock() > 0)
+    {
+        int dtz = ProbeDtz(pos, state);
+        if (state != PROBE_FAIL)
+        {
+            out.dtz = dtz;
+            if (std::abs(dtz) + pos.HalfmoveClock() > 100)
+                out.wdl = 0;
+        }
+    }
+    return true;
+}
+
+bool Tablebase::ProbeCtb(const Position &pos, TablebaseResult &out)
+{
+    if (!CanProbe(pos))
+        return false;
+    return ProbeCtbTable(pos, out);
+}
+
+bool Tablebase::ProbeSyzygy(const Position &pos, int &wdl, int *dtz)
+{
+    if (!CanProbe(pos))
+        return false;
+
+    int state;
+    wdl = ProbeWdl(pos, state);
+    if (state == PROBE_FAIL)
+        return false;
+    if (dtz == nullptr)
+        return true;
+
+    *dtz = ProbeDtz(pos, state);
+    return state != PROBE_FAIL;
+}
+
+bool Tablebase::RankRootMoves(const Position &pos, Move &out, TablebaseResult &result)
+{
+    MoveList moves;
+    pos.GenerateLegalMoves(moves);
+    if (moves.count == 0)
+        return false;
+
+    int clock = pos.HalfmoveClock();
+    bool found = false;
+    int bestRank = 0;
+    int bestDtz = 0;
+
+    for (const Move &m : moves)
+    {
+        Position child = pos;
+        child.MakeMove(m);
+
+        // DTZ counted from here: a zeroing move is one ply from its reset,
+        // anything else one ply more than the reply's DTZ
+        int state;
+        int dtz;
+        if (child.HalfmoveClock() == 0)
+        {
+            dtz = DtzBeforeZeroing(-ProbeWdl(child, state));
+        }
+        else
+        {
+            dtz = -ProbeDtz(child, state);
+            dtz += Sign(dtz);
+        }
+        if (state == PROBE_FAIL)
+            return false;
+
+        if (dtz == 2 && child.InCheck())
+        {
+            MoveList replies;
+            child.GenerateLegalMoves(replies);
+            if (replies.count == 0)
+                dtz = 1; // Mate
+        }
+
+        int rank = MoveRank(dtz, clock);
+        if (!found || rank > bestRank)
+        {
+            found = true;
+            bestRank = rank;
+            bestDtz = dtz;
+            out = m;
+        }
+    }
+
+    result.dtz = bestDtz;
+    result.dtm = -1;
+    result.wdl = (bestDtz > 0 && bestDtz + clock <= 100) ? 1 : (bestDtz < 0 && -bestDtz + clock <= 100) ? -1 : 0;
+    return true;
+}
+
+bool Tablebase::BestMove(const Position &pos, Move &out, TablebaseResult *result)
+{
+    if (!CanProbe(pos))
+        return false;
+
+    probeCount++;
+    TablebaseResult best;
+    if (!RankRootMoves(pos, out, best) && !ProbeCtbBySearch(pos, best, &out))
+        return false;
+    hitCount++;
+
+    if (result != nullptr)
+        *result = best;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// .ctb tables
+// ---------------------------------------------------------------------------
+
+Tablebase::CtbTable *Tablebase::GetCtbTable(const std::string &signature)
+{
+    std::lock_guard<std::mutex> lock(tablesMutex);
+
+    auto it = ctbTables.find(signature);
+    if (it != ctbTables.end())
+        return it->second.get();
+
+    // First probe of this material: map the file, or remember that it is missing
+    std::unique_ptr<CtbTable> table(new CtbTable());
+    std::string path = directory + "/" + signature + ".ctb";
+
+    if (!table->layout.Init(signature) || !table->file.Open(path))
+    {
+        ctbTables[signature] = nullptr;
+        return nullptr;
+    }
+
+    TablebaseHeader header;
+    bool valid = table->file.Size() >= sizeof(header);
+    if (valid)
+    {
+        std::memcpy(&header, table->file.Data(), sizeof(header));
+        header.signature[sizeof(header.signature) - 1] = '\0';
+
+        uint64_t fileSize = table->file.Size();
+        uint64_t entries = table->layout.Size();
+        valid = std::memcmp(header.magic, "CTB1", 4) == 0 &&
+                header.version == TB_VERSION &&
+                signature == header.signature &&
+                header.entries == entries &&
+                header.wdlOffset >= sizeof(header) &&
+                header.wdlOffset + (entries + 3) / 4 <= fileSize &&
+                (header.dtmOffset == 0 || header.dtmOffset + entries <= fileSize);
+    }
+
+    if (!valid)
+    {
+        std::cerr << "Tablebase: ignoring malformed table " << path << std::endl;
+        ctbTables[signature] = nullptr;
+        return nullptr;
+    }
+
+    table->wdl = table->file.Data() + header.wdlOffset;
+    table->dtm = header.dtmOffset ? table->file.Data() + header.dtmOffset : nullptr;
+
+    CtbTable *result = table.get();
+    ctbTables[signature] = std::move(table);
+    return result;
+}
+
+bool Tablebase::ProbeCtbTable(const Position &pos, TablebaseResult &out)
+{
+    if (HasEnPassantCapture(pos))
+        return ProbeCtbBySearch(pos, out, nullptr);
+
+    if (IsDeadDraw(pos))
+    {
+        out.wdl = 0;
+        out.dtm = -1;
+        return true;
+    }
+
+    bool flipped = false;
+    CtbTable *table = GetCtbTable(TablebaseLayout::SignatureOf(pos, flipped));
+    if (table == nullptr)
+        return false;
+
+    uint64_t index = table->layout.Index(flipped ? pos.ColorFlipped() : pos);
+    int value = (table->wdl[index >> 2] >> ((index & 3) * 2)) & 3;
+    if (value == TB_INVALID)
+        return false;
+
+    out.wdl = (value == TB_WIN) ? 1 : (value == TB_LOSS ? -1 : 0);
+    out.dtm = (table->dtm != nullptr && out.wdl != 0) ? table->dtm[index] : -1;
+    return true;
+}
+
+bool Tablebase::ProbeCtbBySearch(const Position &pos, TablebaseResult &out, Move *bestMove)
+{
+    MoveList moves;
+    pos.GenerateLegalMoves(moves);
+
+    if (moves.count == 0)
+    {
+        if (bestMove != nullptr)
+            return false;
+        out.wdl = pos.InCheck() ? -1 : 0;
+        out.dtm = pos.InCheck() ? 0 : -1;
+        return true;
+    }
+
+    bool found = false;
+    TablebaseResult best;
+    for (const Move &m : moves)
+    {
+        Position child = pos;
+        child.MakeMove(m);
+
+        TablebaseResult reply;
+        if (!ProbeCtbTable(child, reply))
+            return false;
+
+        TablebaseResult mine;
+        mine.wdl = -reply.wdl;
+        mine.dtm = reply.dtm >= 0 ? reply.dtm + 1 : -1;
+
+        bool better = !found || mine.wdl > best.wdl;
+        if (found && mine.wdl == best.wdl && mine.dtm >= 0)
+        {
+            // Win as fast as possible, lose as slowly as possible
+            if (mine.wdl > 0)
+                better = best.dtm < 0 || mine.dtm < best.dtm;
+            else if (mine.wdl < 0)
+                better = mine.dtm > best.dtm;
+        }
+
+        if (better)
+        {
+            found = true;
+            best = mine;
+            if (bestMove != nullptr)
+                *bestMove = m;
+        }
+    }
+
+    out = best;
+    return true;
+}
+
+TablebaseStats Tablebase::Stats() const
+{
+    TablebaseStats stats;
+    stats.probes = probeCount.load();
+    stats.hits = hitCount.load();
+
+    std::lock_guard<std::mutex> lock(tablesMutex);
+    for (const auto &entry : tables)
+    {
+        if (entry.second != nullptr)
+        {
+            stats.tablesMapped++;
+            stats.bytesMapped += entry.second->file.Size();
+        }
+    }
+    for (const auto &entry : ctbTables)
+    {
+        if (entry.second != nullptr)
+        {
+            stats.tablesMapped++;
+            stats.bytesMapped += entry.second->file.Size();
+        }
+    }
+    return stats;
+}
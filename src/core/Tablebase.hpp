@@ -0,0 +1,185 @@
+#ifndef TABLEBASE_HPP
+#define TABLEBASE_HPP
+
+#include "Position.hpp"
+#include "MappedFile.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Endgame tablebases - perfect play for positions with few pieces left, read
+// from Syzygy files, or from the project's own tables where no Syzygy file
+// covers the material.
+//
+// Every Syzygy material set has two files, named strongest side first:
+// "KRvK.rtbw" holds win/draw/loss (telling wins that the 50-move rule spoils
+// apart from real ones), "KRvK.rtbz" the distance to the next capture or pawn
+// move (DTZ) with best play. A file is memory-mapped the first time a
+// position with that material is probed, so only the tables the game
+// actually reaches cost anything. WDL files are enough for adjudication; DTZ
+// files are only mapped when a move has to be picked.
+//
+// Positions with castling rights are never probed. The Syzygy tables hold no
+// en passant rights and store "don't care" values where a capture decides
+// the game, so every probe also looks at the captures one ply deep, which is
+// how the format is meant to be read.
+//
+// The project's own tables ("KRvK.ctb", built by tools/tbgen.cpp) hold one
+// material signature each, without the 50-move rule:
+//   TablebaseHeader
+//   WDL section: 2 bits per index, 4 indices per byte (TablebaseWdl values)
+//   DTM section: 1 byte per index, plies to mate (optional)
+// En passant is resolved by a one-ply search, so they only hold positions
+// without it.
+
+constexpr int TB_MAX_PIECES = 7;
+constexpr int TB_CTB_MAX_PIECES = 5;
+constexpr uint32_t TB_VERSION = 1;
+
+enum TablebaseWdl
+{
+    TB_DRAW = 0,
+    TB_WIN = 1,     // Side to move wins
+    TB_LOSS = 2,    // Side to move loses
+    TB_INVALID = 3  // Index does not describe a legal position
+};
+
+struct TablebaseHeader
+{
+    char magic[4];       // "CTB1"
+    uint32_t version;    // TB_VERSION
+    char signature[16];  // e.g. "KRvK", NUL padded
+    uint64_t entries;    // Number of indices
+    uint64_t wdlOffset;  // Byte offset of the WDL section
+    uint64_t dtmOffset;  // Byte offset of the DTM section, 0 if absent
+};
+
+// Maps positions with one fixed material signature to .ctb indices and back.
+// Pieces are ordered white king, black king, other white pieces, other black
+// pieces (Q R B N P within a side). The white king is folded into a corner
+// triangle (pawnless) or onto files a-d (with pawns) using board symmetry.
+class TablebaseLayout
+{
+private:
+    std::string signature;
+    int codes[TB_CTB_MAX_PIECES];
+    int pieceCount = 0;
+    bool hasPawns = false;
+    uint64_t size = 0;
+
+    uint64_t PackIndex(int *squares, uint64_t kingIndex, int sideToMove) const;
+
+public:
+    // Accepts signatures like "KQvK" or "KRPvKR". Returns false if malformed.
+    bool Init(const std::string &signature);
+
+    // Canonical signature of a position. flipped is set when black holds the
+    // stronger side, meaning the position must be ColorFlipped() before Index().
+    static std::string SignatureOf(const Position &pos, bool &flipped);
+
+    const std::string &Signature() const { return signature; }
+    int PieceCount() const { return pieceCount; }
+    bool HasPawns() const { return hasPawns; }
+    uint64_t Size() const { return size; }
+
+    // pos must have exactly this material with the strong side as white
+    uint64_t Index(const Position &pos) const;
+
+    // Builds the position stored at an index. Returns false for overlapping
+    // pieces, pawns on the back ranks, touching kings, the side not to move
+    // being in check, or an index that is a symmetric duplicate of another.
+    bool Decode(uint64_t index, Position &pos) const;
+};
+
+struct TablebaseResult
+{
+    int wdl = 0; // +1 side to move wins, 0 draw, -1 side to move loses (50-move rule included)
+    int dtz = 0;  // Plies to the next capture or pawn move with best play, 0 if drawn or not probed
+    int dtm = -1; // Plies to mate from a .ctb table, -1 if unknown or drawn
+};
+
+struct TablebaseStats
+{
+    uint64_t probes = 0;      // Probe() calls that reached the tables
+    uint64_t hits = 0;        // Probes answered
+    int tablesMapped = 0;     // Files currently mapped
+    uint64_t bytesMapped = 0; // Total size of the mapped files
+};
+
+class Tablebase
+{
+private:
+    struct Table; // One mapped .rtbw or .rtbz file, defined in Tablebase.cpp
+
+    struct CtbTable
+    {
+        TablebaseLayout layout;
+        MappedFile file;
+        const unsigned char *wdl = nullptr;
+        const unsigned char *dtm = nullptr;
+    };
+
+    std::string directory;
+    int maxPieces;
+
+    // Keyed by file name; nullptr entries remember files that are missing on disk
+    std::unordered_map<std::string, std::unique_ptr<Table>> tables;
+    std::unordered_map<std::string, std::unique_ptr<CtbTable>> ctbTables;
+    mutable std::mutex tablesMutex;
+
+    std::atomic<uint64_t> probeCount{0};
+    std::atomic<uint64_t> hitCount{0};
+
+    Table *GetTable(const Position &pos, bool dtz);
+
+    // The probe steps of the format. state is one of the ProbeState values in
+    // Tablebase.cpp; WDL scores run from -2 (loss) to +2 (win), with -1 and +1
+    // for the blessed losses and cursed wins the 50-move rule turns into draws.
+    int ProbeTable(const Position &pos, bool dtz, int wdl, int &state);
+    int SearchCaptures(const Position &pos, bool pawnMoves, int &state);
+    int ProbeWdl(const Position &pos, int &state);
+    int ProbeDtz(const Position &pos, int &state);
+    bool RankRootMoves(const Position &pos, Move &out, TablebaseResult &result);
+
+    // The .ctb fallback, for material no Syzygy file covers
+    CtbTable *GetCtbTable(const std::string &signature);
+    bool ProbeCtbTable(const Position &pos, TablebaseResult &out);
+    bool ProbeCtbBySearch(const Position &pos, TablebaseResult &out, Move *bestMove);
+
+public:
+    explicit Tablebase(const std::string &directory = "tablebases", int maxPieces = TB_MAX_PIECES);
+    ~Tablebase();
+
+    Tablebase(const Tablebase &) = delete;
+    Tablebase &operator=(const Tablebase &) = delete;
+
+    // Cheap check done before every probe: few enough pieces and no castling rights
+    bool CanProbe(const Position &pos) const;
+
+    // Win/draw/loss for the side to move. Only the WDL file is needed, except
+    // that a decisive result with a running 50-move count is checked against DTZ.
+    // Falls back to the .ctb table when there is no Syzygy file.
+    bool Probe(const Position &pos, TablebaseResult &out);
+
+    // Win/draw/loss and distance to mate from the .ctb tables only, ignoring
+    // the 50-move rule. tbgen builds each table on top of the smaller ones
+    // through this.
+    bool ProbeCtb(const Position &pos, TablebaseResult &out);
+
+    // The Syzygy values as decoded, without the .ctb fallback or the 50-move
+    // adjustment: wdl from -2 to +2 and dtz in plies. dtz is left out when
+    // nullptr. tbcheck verifies the decoder through this.
+    bool ProbeSyzygy(const Position &pos, int &wdl, int *dtz = nullptr);
+
+    // The move that keeps the best result and zeroes the 50-move count soonest
+    // (or, when losing, holds out longest). With only .ctb tables, the fastest
+    // mate or longest defence. Returns false if any reply is not covered.
+    bool BestMove(const Position &pos, Move &out, TablebaseResult *result = nullptr);
+
+    TablebaseStats Stats() const;
+};
+
+#endif // TABLEBASE_HPP
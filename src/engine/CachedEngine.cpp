@@ -0,0 +1,71 @@
+#include "CachedEngine.hpp"
+#include "../core/Position.hpp"
+
+CachedEngine::CachedEngine(ChessEngine *inner, EngineCache &cache)
+    : inner(inner),
+      cache(cache),
+      skillLevel(20)
+{
+}
+
+CachedEngine::~CachedEngine()
+{
+    shutdown();
+}
+
+void CachedEngine::setDifficulty(int level)
+{
+    skillLevel = level;
+    inner->setDifficulty(level);
+}
+
+SearchResult CachedEngine::search(const SearchRequest &request)
+{
+    SearchResult result;
+
+    // Replaying from the start costs a few microseconds; a history that does
+    // not parse is passed through uncached
+    Position pos = Position::StartPosition();
+    bool known = request.startFen.empty() || pos.SetFromFEN(request.startFen);
+    for (const std::string &uci : request.moveHistory)
+    {
+        Move move;
+        if (!known || !pos.ParseUCI(uci, move))
+        {
+            known = false;
+            break;
+        }
+        pos.MakeMove(move);
+    }
+
+    uint32_t params = EngineCache::ParamsKey(skillLevel, request);
+    Move cachedMove;
+    if (known && cache.Lookup(pos.Key(), params, result) && pos.ParseUCI(result.bestMove, cachedMove))
+    {
+        result.move = EngineMoveFromUCI(result.bestMove);
+        return result;
+    }
+
+    // Miss: run it on the wrapped engine's worker so its own stop handling applies
+    SearchHandle handle = inner->startSearch(request);
+    if (!handle.valid())
+        return SearchResult(); // Someone else is using the engine
+    if (stopRequested())
+        handle.cancel();
+
+    result = handle.wait();
+    if (known && !result.stopped && result.move.isValid)
+        cache.Store(pos.Key(), params, result);
+    return result;
+}
+
+void CachedEngine::reset()
+{
+    cancelMove();
+    inner->reset();
+}
+
+void CachedEngine::shutdown()
+{
+    stopWorker(); // The wrapped engine belongs to someone else; only our thread stops
+}
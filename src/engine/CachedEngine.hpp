@@ -0,0 +1,39 @@
+#ifndef CACHED_ENGINE_HPP
+#define CACHED_ENGINE_HPP
+
+#include "ChessEngine.hpp"
+#include "EngineCache.hpp"
+
+// CachedEngine - puts an EngineCache in front of another engine.
+// Positions seen before (same skill level and limits) are answered from the
+// cache without a search; everything else is passed through and the reply is
+// stored. The wrapped engine is borrowed, not owned, and must outlive this.
+
+class CachedEngine : public ChessEngine
+{
+public:
+    CachedEngine(ChessEngine *inner, EngineCache &cache);
+    ~CachedEngine() override;
+
+    bool init() override { return inner != nullptr; } // The wrapped engine is already running
+    void newGame() override { inner->newGame(); }
+    void setDifficulty(int level) override;
+    void setPondering(bool enabled) override { inner->setPondering(enabled); }
+    SearchResult search(const SearchRequest &request) override;
+    void reset() override;
+    void shutdown() override;
+    std::string getName() const override { return inner->getName(); }
+    EngineStats getStats() const override { return inner->getStats(); }
+    bool getInfo(EngineInfo &out) const override { return inner->getInfo(out); }
+    const SearchTelemetry *getTelemetry() const override { return inner->getTelemetry(); }
+
+protected:
+    void interruptSearch() override { inner->stop(); }
+
+private:
+    ChessEngine *inner;
+    EngineCache &cache;
+    int skillLevel;
+};
+
+#endif // CACHED_ENGINE_HPP
@@ -0,0 +1,189 @@
+#include "ChessEngine.hpp"
+#include <chrono>
+
+bool SearchHandle::ready() const
+{
+    return slot != nullptr && slot->done.load(std::memory_order_acquire);
+}
+
+bool SearchHandle::poll(SearchResult & out) const
+{
+    if (!ready())
+        return false;
+
+    out = slot->result;
+    return true;
+}
+
+SearchResult SearchHandle::wait() const
+{
+    if (slot == nullptr)
+        return SearchResult();
+
+    std::unique_lock<std::mutex> lock(slot->doneMutex);
+    slot->doneSignal.wait(lock, [this] { return slot->done.load(std::memory_order_acquire); });
+    return slot->result;
+}
+
+void SearchHandle::cancel() const
+{
+    if (engine != nullptr && slot != nullptr && !ready())
+        engine->stop();
+}
+
+constexpr int ChessEngine::IDLE_POLL_MS; // Bound by reference in workerLoop, so C++14 needs the definition
+
+ChessEngine::~ChessEngine()
+{
+    stopWorker();
+}
+
+EngineMove ChessEngine::getMove(const std::vector<std::string> & moveHistory)
+{
+    SearchRequest request;
+    request.moveHistory = moveHistory;
+    stopFlag.store(false, std::memory_order_release);
+    return search(request).move;
+}
+
+SearchHandle ChessEngine::startSearch(const SearchRequest & request)
+{
+    SearchHandle handle;
+
+    if (!worker.joinable())
+    {
+        stopping = false;
+        worker = std::thread(&ChessEngine::workerLoop, this);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(workerMutex);
+        if (busy)
+            return handle;
+
+        stopFlag.store(false, std::memory_order_release);
+        handle.slot = std::make_shared<SearchHandle::Slot>();
+        handle.slot->request = request;
+        handle.engine = this;
+        queued = handle.slot;
+        busy = true;
+    }
+    workerWake.notify_one();
+
+    return handle;
+}
+
+void ChessEngine::stop()
+{
+    stopFlag.store(true, std::memory_order_release);
+    interruptSearch();
+}
+
+void ChessEngine::abortSearch()
+{
+    std::unique_lock<std::mutex> lock(workerMutex);
+    if (busy)
+        stop();
+    workerIdle.wait(lock, [this] { return !busy; });
+}
+
+bool ChessEngine::requestMove(const std::vector<std::string> & moveHistory)
+{
+    if (pendingMove.valid())
+        return false;
+
+    SearchRequest request;
+    request.moveHistory = moveHistory;
+    return requestMove(request);
+}
+
+bool ChessEngine::requestMove(const SearchRequest & request)
+{
+    if (pendingMove.valid())
+        return false;
+
+    pendingMove = startSearch(request);
+    return pendingMove.valid();
+}
+
+bool ChessEngine::pollMove(EngineMove & out)
+{
+    SearchResult result;
+    if (!pendingMove.poll(result))
+        return false;
+
+    out = result.move;
+    pendingMove = SearchHandle();
+    return true;
+}
+
+void ChessEngine::cancelMove()
+{
+    if (pendingMove.valid())
+        abortSearch();
+    pendingMove = SearchHandle();
+}
+
+void ChessEngine::stopWorker()
+{
+    if (!worker.joinable())
+        return;
+
+    cancelMove();
+    abortSearch();
+    {
+        std::lock_guard<std::mutex> lock(workerMutex);
+        stopping = true;
+    }
+    workerWake.notify_one();
+    worker.join();
+}
+
+void ChessEngine::workerLoop()
+{
+    bool wantIdle = false;
+    while (true)
+    {
+        std::shared_ptr<SearchHandle::Slot> slot;
+        {
+            std::unique_lock<std::mutex> lock(workerMutex);
+            auto woken = [this] { return stopping || queued != nullptr; };
+            if (wantIdle)
+            {
+                if (!workerWake.wait_for(lock, std::chrono::milliseconds(IDLE_POLL_MS), woken))
+                {
+                    lock.unlock();
+                    wantIdle = onIdle();
+                    continue;
+                }
+            }
+            else
+            {
+                workerWake.wait(lock, woken);
+            }
+            if (stopping)
+                return;
+            slot = std::move(queued);
+            queued = nullptr;
+        }
+
+        // The slow part - runs without holding anything the UI thread needs
+        slot->result = search(slot->request);
+
+        // Idle before the result is published, so whoever wakes up on it can
+        // start the next search straight away
+        {
+            std::lock_guard<std::mutex> lock(workerMutex);
+            busy = false;
+        }
+        workerIdle.notify_all();
+
+        {
+            std::lock_guard<std::mutex> lock(slot->doneMutex);
+            slot->done.store(true, std::memory_order_release);
+        }
+        slot->doneSignal.notify_all();
+
+        wantIdle = onIdle();
+    }
+}
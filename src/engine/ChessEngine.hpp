@@ -2,16 +2,82 @@
 #define CHESS_ENGINE_HPP
 
 #include "EngineMove.hpp"
+#include "SearchRequest.hpp"
+#include "EngineInfo.hpp"
+#include "SearchTelemetry.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string> 
+#include <thread>
 #include <vector> 
 
+class ChessEngine;
+
+// EngineStats - I/O counters, printed when an engine is shut down
+struct EngineStats
+{
+    uint64_t linesRead = 0;
+    uint64_t bytesRead = 0;
+    uint64_t readCalls = 0;  // read() / ReadFile()
+    uint64_t pollCalls = 0;  // poll() / PeekNamedPipe()
+    uint64_t writeCalls = 0; // write() / WriteFile()
+    uint64_t ponderHits = 0;   // Searches that continued a ponder on the move actually played
+    uint64_t ponderMisses = 0; // Ponders thrown away because another move came
+};
+
+// SearchHandle - future-style handle for a search running on the engine's
+// worker thread. Copies share the same search. The worker writes the result
+// into the shared slot and then sets its done flag; ready() and poll() only
+// read that flag, so the render loop can check it every frame.
+
+class SearchHandle{
+
+    public:
+
+        SearchHandle() = default;
+
+        bool valid() const { return slot != nullptr; }
+
+        // True once the result is available
+        bool ready() const;
+
+        // Non-blocking: copies the result out once ready() is true
+        bool poll(SearchResult & out) const;
+
+        // Blocks until the search is done
+        SearchResult wait() const;
+
+        // Stops the search early; the result still arrives (with stopped set)
+        void cancel() const;
+
+    private:
+
+        friend class ChessEngine;
+
+        struct Slot
+        {
+            SearchRequest request;
+            SearchResult result;
+            std::atomic<bool> done{false};
+            std::mutex doneMutex;
+            std::condition_variable doneSignal;
+        };
+
+        std::shared_ptr<Slot> slot;
+        ChessEngine *engine = nullptr;
+
+};
+
 // ChessEngine - abstract interface for any chess engine. 
 
 class ChessEngine{
 
     public: 
 
-        virtual ~ChessEngine() = default; // Virtual destructor -required for correct cleanup 
+        virtual ~ChessEngine(); // Virtual destructor -required for correct cleanup 
 
         // Start up the engine (e.g. spawn a process, load a model).
         // Returns true on success, false if the engine could not be started. 
@@ -26,9 +92,9 @@ class ChessEngine{
         // - Random bot: unused
         virtual void setDifficulty(int level) = 0;
 
-        // Ask the engine for its best move given the current position. 
-        // moveHistory: the complete move list in UCI format, e.g. {"e2e4", "e7e5"}
-        virtual EngineMove getMove(const std::vector<std::string> & moveHistory) = 0; 
+        // Run one search and block until the engine answers. Called on the
+        // worker thread by startSearch(); use it directly only from tools.
+        virtual SearchResult search(const SearchRequest & request) = 0;
 
         // Reset to the state after init() + newGame() - called on Restart. 
         virtual void reset() = 0; 
@@ -39,6 +105,86 @@ class ChessEngine{
         // Engine name for UI display. 
         virtual std::string getName() const = 0; 
 
+        // Think on the opponent's time between searches. A no-op for engines
+        // that can not ponder. Safe to call every frame.
+        virtual void setPondering(bool enabled) { (void)enabled; }
+
+        // I/O counters; engines that do not talk over a pipe can leave them at zero
+        virtual EngineStats getStats() const { return EngineStats(); }
+
+        // Latest search info (score, depth, PV). Safe to call every frame from
+        // the UI thread while a search runs. False if there is nothing to show.
+        virtual bool getInfo(EngineInfo & out) const { (void)out; return false; }
+
+        // Latency histograms of past searches, or nullptr if the engine keeps none
+        virtual const SearchTelemetry * getTelemetry() const { return nullptr; }
+
+        // Blocking shortcut: best move for moveHistory (UCI moves, e.g. {"e2e4", "e7e5"})
+        // with the engine's default limits.
+        EngineMove getMove(const std::vector<std::string> & moveHistory);
+
+        // Non-blocking: hands the search to the worker thread. Returns an
+        // invalid handle if a previous search has not finished yet.
+        SearchHandle startSearch(const SearchRequest & request);
+
+        // Ask the queued or running search to finish now. Does not wait; the
+        // result still arrives with stopped set. Harmless when nothing is running.
+        void stop();
+
+        // stop() and wait for the worker to go idle
+        void abortSearch();
+
+        // Single-search convenience used by the game loop: requestMove starts a
+        // default search, pollMove is called each frame until the move is ready.
+        // The SearchRequest overload carries limits, e.g. clock times.
+        bool requestMove(const std::vector<std::string> & moveHistory);
+        bool requestMove(const SearchRequest & request);
+        bool pollMove(EngineMove & out);
+
+        // True from requestMove until pollMove has handed back the result
+        bool isThinking() const { return pendingMove.valid(); }
+
+        // Aborts the requestMove search and throws its result away
+        void cancelMove();
+
+    protected:
+
+        // Engine side of stop(): end the running search early. Called from the
+        // UI thread while search() is blocked on the worker.
+        virtual void interruptSearch() = 0;
+
+        // True once stop() was called for the current search. search() checks it
+        // after starting, in case the stop arrived before there was anything to stop.
+        bool stopRequested() const { return stopFlag.load(std::memory_order_acquire); }
+
+        // Background work between searches (e.g. reading ponder output). Runs on
+        // the worker after every search and then every IDLE_POLL_MS while it
+        // keeps returning true.
+        virtual bool onIdle() { return false; }
+        static constexpr int IDLE_POLL_MS = 20;
+
+        // Joins the worker thread. Derived classes must call this before their
+        // own state goes away (shutdown() is the natural place), because the
+        // worker calls back into search().
+        void stopWorker();
+
+    private:
+
+        // One search at a time, so the hand-off to the worker is a single
+        // slot under workerMutex rather than a queue
+        std::thread worker;
+        std::mutex workerMutex;
+        std::condition_variable workerWake; // New request or stop
+        std::condition_variable workerIdle; // Search finished
+        std::shared_ptr<SearchHandle::Slot> queued; // Guarded by workerMutex, taken by the worker
+        bool stopping = false;              // Guarded by workerMutex
+        bool busy = false;                  // Guarded by workerMutex, queued or running
+        std::atomic<bool> stopFlag{false};
+
+        SearchHandle pendingMove;           // UI thread only
+
+        void workerLoop();
+
 };
 
-#endif
\ No newline at end of file
+#endif
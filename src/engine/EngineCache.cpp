@@ -0,0 +1,235 @@
+#include "EngineCache.hpp"
+#include "../core/Piece.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+
+const char CACHE_MAGIC[8] = {'C', 'H', 'E', 'S', 'S', 'E', 'C', '1'};
+const uint32_t CACHE_VERSION = 2; // 2: Polyglot Random64 keys
+
+const uint8_t FLAG_HAS_SCORE = 1;
+const uint8_t FLAG_MATE = 2;
+
+uint16_t EncodeMove(const std::string &uci)
+{
+    if (uci.size() < 4)
+        return 0;
+
+    int from = (uci[1] - '1') * 8 + (uci[0] - 'a');
+    int to = (uci[3] - '1') * 8 + (uci[2] - 'a');
+    if (from < 0 || from > 63 || to < 0 || to > 63)
+        return 0;
+
+    int promotion = 0;
+    if (uci.size() >= 5)
+    {
+        switch (uci[4])
+        {
+            case 'q': promotion = QUEEN; break;
+            case 'r': promotion = ROOK; break;
+            case 'b': promotion = BISHOP; break;
+            case 'n': promotion = KNIGHT; break;
+            default: break;
+        }
+    }
+    return static_cast<uint16_t>(from | (to << 6) | (promotion << 12));
+}
+
+std::string DecodeMove(uint16_t move)
+{
+    if (move == 0)
+        return std::string();
+
+    int from = move & 63, to = (move >> 6) & 63, promotion = move >> 12;
+    std::string uci;
+    uci += static_cast<char>('a' + (from & 7));
+    uci += static_cast<char>('1' + (from >> 3));
+    uci += static_cast<char>('a' + (to & 7));
+    uci += static_cast<char>('1' + (to >> 3));
+    switch (promotion)
+    {
+        case QUEEN: uci += 'q'; break;
+        case ROOK: uci += 'r'; break;
+        case BISHOP: uci += 'b'; break;
+        case KNIGHT: uci += 'n'; break;
+        default: break;
+    }
+    return uci;
+}
+
+uint32_t Mix(uint32_t h, uint64_t value)
+{
+    // FNV-1a over the 8 bytes of value
+    for (int i = 0; i < 8; i++)
+    {
+        h ^= static_cast<uint32_t>((value >> (i * 8)) & 0xFF);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+} // namespace
+
+EngineCache::EngineCache(const std::string &path, uint32_t capacity)
+{
+    setCount = std::max<uint32_t>(1, capacity / WAYS);
+    uint32_t recordCount = setCount * WAYS;
+    std::size_t bytes = sizeof(Header) + static_cast<std::size_t>(recordCount) * sizeof(Record);
+
+    unsigned char *base = nullptr;
+    if (!path.empty() && file.OpenWritable(path, bytes))
+    {
+        base = file.MutableData();
+    }
+    else
+    {
+        if (!path.empty())
+            std::cerr << "EngineCache: Can not map " << path << ", caching in memory only." << std::endl;
+        memoryOnly.assign(bytes, 0);
+        base = memoryOnly.data();
+    }
+
+    header = reinterpret_cast<Header *>(base);
+    records = reinterpret_cast<Record *>(base + sizeof(Header));
+
+    // A new file, another version or another size starts empty
+    bool compatible = std::memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 &&
+                      header->version == CACHE_VERSION &&
+                      header->recordSize == sizeof(Record) &&
+                      header->capacity == recordCount;
+    if (!compatible)
+    {
+        std::memset(base, 0, bytes);
+        std::memcpy(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        header->version = CACHE_VERSION;
+        header->recordSize = sizeof(Record);
+        header->capacity = recordCount;
+        header->tick = 0;
+        header->entries = 0;
+    }
+}
+
+EngineCache::~EngineCache()
+{
+    file.Flush();
+}
+
+uint32_t EngineCache::ParamsKey(int skillLevel, const SearchRequest &request)
+{
+    uint32_t h = 2166136261u;
+    h = Mix(h, static_cast<uint64_t>(skillLevel));
+    h = Mix(h, static_cast<uint64_t>(request.movetimeMs));
+    h = Mix(h, static_cast<uint64_t>(request.depth));
+    h = Mix(h, request.nodes);
+    h = Mix(h, static_cast<uint64_t>(request.multipv));
+
+    // Clock searches never repeat their exact times; bucket the soft limit
+    // by powers of two so similar budgets share replies
+    int bucket = 0;
+    for (int soft = request.softLimitMs; soft > 0; soft >>= 1)
+        bucket++;
+    h = Mix(h, static_cast<uint64_t>(bucket));
+    return h;
+}
+
+EngineCache::Record *EngineCache::Set(uint64_t positionKey, uint32_t paramsKey)
+{
+    uint64_t mixed = positionKey ^ (static_cast<uint64_t>(paramsKey) * 0x9E3779B97F4A7C15ull);
+    return records + (mixed % setCount) * WAYS;
+}
+
+uint32_t EngineCache::NextTick()
+{
+    // Halve every age before the counter wraps; the LRU order stays the same
+    if (header->tick == UINT32_MAX)
+    {
+        Record *end = records + static_cast<std::size_t>(setCount) * WAYS;
+        for (Record *r = records; r != end; r++)
+        {
+            if (r->lastUsed != 0)
+                r->lastUsed = std::max<uint32_t>(1, r->lastUsed >> 1);
+        }
+        header->tick >>= 1;
+    }
+    return ++header->tick;
+}
+
+bool EngineCache::Lookup(uint64_t positionKey, uint32_t paramsKey, SearchResult &out)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    lookups++;
+
+    Record *set = Set(positionKey, paramsKey);
+    for (uint32_t way = 0; way < WAYS; way++)
+    {
+        Record &r = set[way];
+        if (r.lastUsed == 0 || r.positionKey != positionKey || r.paramsKey != paramsKey)
+            continue;
+
+        r.lastUsed = NextTick();
+        hits++;
+
+        out.bestMove = DecodeMove(r.bestMove);
+        out.ponderMove = DecodeMove(r.ponderMove);
+        out.stopped = false;
+        out.hasScore = (r.flags & FLAG_HAS_SCORE) != 0;
+        out.mate = (r.flags & FLAG_MATE) != 0;
+        out.score = r.score;
+        out.depth = r.depth;
+        return true;
+    }
+    return false;
+}
+
+void EngineCache::Store(uint64_t positionKey, uint32_t paramsKey, const SearchResult &result)
+{
+    uint16_t bestMove = EncodeMove(result.bestMove);
+    if (bestMove == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    stores++;
+
+    // Same key again, else an empty way, else the least recently used one
+    Record *set = Set(positionKey, paramsKey);
+    Record *victim = &set[0];
+    for (uint32_t way = 0; way < WAYS; way++)
+    {
+        Record &r = set[way];
+        if (r.lastUsed != 0 && r.positionKey == positionKey && r.paramsKey == paramsKey)
+        {
+            victim = &r;
+            break;
+        }
+        if (r.lastUsed < victim->lastUsed)
+            victim = &r;
+    }
+
+    if (victim->lastUsed == 0)
+        header->entries++;
+
+    victim->positionKey = positionKey;
+    victim->paramsKey = paramsKey;
+    victim->bestMove = bestMove;
+    victim->ponderMove = EncodeMove(result.ponderMove);
+    victim->score = static_cast<int16_t>(std::max(-32000, std::min(32000, result.score)));
+    victim->flags = static_cast<uint8_t>((result.hasScore ? FLAG_HAS_SCORE : 0) | (result.mate ? FLAG_MATE : 0));
+    victim->depth = static_cast<uint8_t>(std::min(255, std::max(0, result.depth)));
+    victim->lastUsed = NextTick();
+}
+
+EngineCacheStats EngineCache::Stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    EngineCacheStats stats;
+    stats.lookups = lookups;
+    stats.hits = hits;
+    stats.stores = stores;
+    stats.entries = header->entries;
+    stats.capacity = static_cast<uint64_t>(setCount) * WAYS;
+    stats.persistent = file.IsOpen();
+    return stats;
+}
@@ -0,0 +1,91 @@
+#ifndef ENGINE_CACHE_HPP
+#define ENGINE_CACHE_HPP
+
+#include "SearchRequest.hpp"
+#include "../core/MappedFile.hpp"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// EngineCache - remembers engine replies by (position key, skill + limits).
+//
+// Records are fixed-size and live in a memory-mapped file, so the cache
+// survives restarts without a load or save step. The table is 8-way set
+// associative: a position can only go in one set, and a full set evicts its
+// least recently used way. Without a writable file it runs in memory only.
+
+struct EngineCacheStats
+{
+    uint64_t lookups = 0;
+    uint64_t hits = 0;
+    uint64_t stores = 0;
+    uint64_t entries = 0;  // Occupied records
+    uint64_t capacity = 0;
+    bool persistent = false; // Backed by the file
+
+    double HitRate() const { return lookups ? static_cast<double>(hits) / lookups : 0.0; }
+};
+
+class EngineCache
+{
+public:
+    // capacity is rounded down to a whole number of sets
+    EngineCache(const std::string &path, uint32_t capacity = 65536);
+    ~EngineCache();
+
+    EngineCache(const EngineCache &) = delete;
+    EngineCache &operator=(const EngineCache &) = delete;
+
+    // Key for everything besides the position that changes the reply
+    static uint32_t ParamsKey(int skillLevel, const SearchRequest &request);
+
+    // Fills bestMove, ponderMove and the score fields of out on a hit
+    bool Lookup(uint64_t positionKey, uint32_t paramsKey, SearchResult &out);
+    void Store(uint64_t positionKey, uint32_t paramsKey, const SearchResult &result);
+
+    EngineCacheStats Stats() const;
+
+private:
+    static constexpr uint32_t WAYS = 8;
+
+    // 24 bytes on disk, native byte order
+    struct Record
+    {
+        uint64_t positionKey;
+        uint32_t paramsKey;
+        uint32_t lastUsed;   // LRU tick, 0 = empty
+        uint16_t bestMove;   // from | to << 6 | promotion << 12, squares a1 = 0
+        uint16_t ponderMove; // 0 = none
+        int16_t score;
+        uint8_t flags;
+        uint8_t depth;
+    };
+    static_assert(sizeof(Record) == 24, "cache records are a fixed on-disk size");
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        uint32_t capacity;
+        uint32_t tick;
+        uint64_t entries;
+    };
+
+    mutable std::mutex mutex;
+    MappedFile file;
+    std::vector<unsigned char> memoryOnly; // Used when the file can not be mapped
+    Header *header = nullptr;
+    Record *records = nullptr;
+    uint32_t setCount = 0;
+
+    uint64_t lookups = 0;
+    uint64_t hits = 0;
+    uint64_t stores = 0;
+
+    Record *Set(uint64_t positionKey, uint32_t paramsKey);
+    uint32_t NextTick();
+};
+
+#endif // ENGINE_CACHE_HPP
@@ -0,0 +1,147 @@
+#include "EngineInfo.hpp"
+#include <cstring>
+
+namespace
+{
+    // Walks space-separated tokens in place - no copies, no allocation
+    struct Tokenizer
+    {
+        const char *pos;
+        const char *end;
+
+        bool Next(const char *&token, std::size_t &length)
+        {
+            while (pos < end && *pos == ' ')
+                pos++;
+            if (pos >= end)
+                return false;
+            token = pos;
+            while (pos < end && *pos != ' ')
+                pos++;
+            length = static_cast<std::size_t>(pos - token);
+            return true;
+        }
+    };
+
+    bool Is(const char *token, std::size_t length, const char *word)
+    {
+        return std::strlen(word) == length && std::memcmp(token, word, length) == 0;
+    }
+
+    bool ToInt(const char *token, std::size_t length, int64_t &out)
+    {
+        if (length == 0)
+            return false;
+        std::size_t i = 0;
+        bool negative = token[0] == '-';
+        if (negative || token[0] == '+')
+            i = 1;
+        if (i == length)
+            return false;
+
+        int64_t value = 0;
+        for (; i < length; i++)
+        {
+            if (token[i] < '0' || token[i] > '9')
+                return false;
+            value = value * 10 + (token[i] - '0');
+        }
+        out = negative ? -value : value;
+        return true;
+    }
+
+    bool ToMove(const char *token, std::size_t length, EngineInfoMove &out)
+    {
+        if (length < 4 || length > 5 ||
+            token[0] < 'a' || token[0] > 'h' || token[1] < '1' || token[1] > '8' ||
+            token[2] < 'a' || token[2] > 'h' || token[3] < '1' || token[3] > '8')
+            return false;
+
+        out.from = static_cast<uint8_t>((token[1] - '1') * 8 + (token[0] - 'a'));
+        out.to = static_cast<uint8_t>((token[3] - '1') * 8 + (token[2] - 'a'));
+        out.promotion = 0;
+        if (length == 5)
+        {
+            switch (token[4])
+            {
+                case 'q': out.promotion = 4; break; // QUEEN
+                case 'r': out.promotion = 1; break; // ROOK
+                case 'b': out.promotion = 3; break; // BISHOP
+                case 'n': out.promotion = 2; break; // KNIGHT
+                default: return false;
+            }
+        }
+        return true;
+    }
+}
+
+bool ParseInfoLine(const char *text, std::size_t length, EngineInfo &info)
+{
+    Tokenizer tokens{text, text + length};
+    const char *token;
+    std::size_t tokenLength;
+
+    if (!tokens.Next(token, tokenLength) || !Is(token, tokenLength, "info"))
+        return false;
+
+    bool sawScore = false;
+    int64_t value;
+
+    // Reads the value after a keyword into an integer field
+    auto number = [&](int64_t &out) -> bool
+    {
+        const char *v;
+        std::size_t vLength;
+        return tokens.Next(v, vLength) && ToInt(v, vLength, out);
+    };
+
+    while (tokens.Next(token, tokenLength))
+    {
+        if (Is(token, tokenLength, "depth") && number(value))
+            info.depth = static_cast<int>(value);
+        else if (Is(token, tokenLength, "seldepth") && number(value))
+            info.seldepth = static_cast<int>(value);
+        else if (Is(token, tokenLength, "multipv") && number(value))
+            info.multipv = static_cast<int>(value);
+        else if (Is(token, tokenLength, "nodes") && number(value))
+            info.nodes = static_cast<uint64_t>(value);
+        else if (Is(token, tokenLength, "nps") && number(value))
+            info.nps = static_cast<uint64_t>(value);
+        else if (Is(token, tokenLength, "hashfull") && number(value))
+            info.hashfull = static_cast<int>(value);
+        else if (Is(token, tokenLength, "time") && number(value))
+            info.timeMs = static_cast<int>(value);
+        else if (Is(token, tokenLength, "score"))
+        {
+            const char *kind;
+            std::size_t kindLength;
+            if (tokens.Next(kind, kindLength) && number(value))
+            {
+                if (Is(kind, kindLength, "cp") || Is(kind, kindLength, "mate"))
+                {
+                    info.mate = Is(kind, kindLength, "mate");
+                    info.score = static_cast<int>(value);
+                    info.hasScore = true;
+                    sawScore = true;
+                }
+            }
+        }
+        else if (Is(token, tokenLength, "pv"))
+        {
+            // The PV runs to the end of the line
+            info.pvLength = 0;
+            while (tokens.Next(token, tokenLength) && info.pvLength < ENGINE_INFO_MAX_PV)
+            {
+                if (!ToMove(token, tokenLength, info.pv[info.pvLength]))
+                    break;
+                info.pvLength++;
+            }
+            break;
+        }
+        else if (Is(token, tokenLength, "string"))
+        {
+            break; // Free text to the end of the line
+        }
+    }
+    return sawScore;
+}
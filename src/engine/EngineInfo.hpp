@@ -0,0 +1,49 @@
+#ifndef ENGINE_INFO_HPP
+#define ENGINE_INFO_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// EngineInfo - latest "info" snapshot of a running search, for the eval bar
+// and PV arrows. Plain fixed-size data so it can be published through a
+// SeqLock and parsed without touching the heap.
+
+constexpr int ENGINE_INFO_MAX_PV = 16;
+
+struct EngineInfoMove
+{
+    uint8_t from;      // Square, a1 = 0 (same numbering as Position)
+    uint8_t to;
+    uint8_t promotion; // PieceType value, 0 = none
+};
+
+struct EngineInfo
+{
+    bool hasScore = false;
+    bool mate = false;        // score is moves to mate instead of centipawns
+    int score = 0;            // From the side to move; negative mate = getting mated
+    bool whiteToMove = true;  // Side to move in the searched position
+    int depth = 0;
+    int seldepth = 0;
+    int multipv = 1;
+    int hashfull = 0;         // Per mille
+    int timeMs = 0;
+    uint64_t nodes = 0;
+    uint64_t nps = 0;
+
+    int pvLength = 0;
+    EngineInfoMove pv[ENGINE_INFO_MAX_PV];
+
+    // Score from white's point of view (centipawns; mates become +-100000)
+    int WhiteScore() const
+    {
+        int s = mate ? (score > 0 ? 100000 - score : -100000 - score) : score;
+        return whiteToMove ? s : -s;
+    }
+};
+
+// Parses one "info ..." line (no newline). Fields the line does not mention
+// are left alone. Returns true if the line carried a score.
+bool ParseInfoLine(const char *text, std::size_t length, EngineInfo &info);
+
+#endif
@@ -0,0 +1,46 @@
+#include "EngineMove.hpp"
+#include "../core/Piece.hpp"
+
+extern float squareSize;
+extern Vector2 boardPosition;
+
+// EngineMoveFromUCI() - convert "e2e4" to pixel positions
+
+EngineMove EngineMoveFromUCI(const std::string& uciStr)
+{
+    EngineMove em; 
+
+    if (uciStr.size() < 4) return em; // Invalid string 
+
+    // UCI file letters: 'a' = col 0, 'b' = col 1, 
+    // UCI rank digits: '8' = row 0 (top), '1' = row 7 (bottom)
+    int fromCol = uciStr[0] - 'a'; // 0-7
+    int fromRow = '8' - uciStr[1]; // 0-7 (e.g. '2' -> row 6)
+
+    int toCol = uciStr[2] - 'a'; 
+    int toRow = '8' - uciStr[3]; 
+    
+    // Convert board coords -> pixel positions (same layout as piece positions in Board) 
+    em.from.x = boardPosition.x + fromCol * squareSize;
+    em.from.y = boardPosition.y + fromRow * squareSize; 
+    em.to.x = boardPosition.x + toCol * squareSize; 
+    em.to.y = boardPosition.y + toRow * squareSize; 
+
+    // Optional promotion piece (5th character: 'q', 'r', 'b', 'n') 
+    if(uciStr.size() >=5) 
+    {
+        switch (uciStr[4]) 
+        {
+            case'q':
+                em.promotionPiece = QUEEN;
+                break; 
+            case 'r': em.promotionPiece = ROOK; break; 
+            case 'b': em.promotionPiece = BISHOP; break; 
+            case 'n': em.promotionPiece = KNIGHT; break; 
+            default: em.promotionPiece = 0; break; 
+        }
+    }
+
+    em.isValid = true; 
+    return em; 
+}
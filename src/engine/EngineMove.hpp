@@ -2,6 +2,7 @@
 #define ENGINE_MOVE_HPP
 
 #include <raylib.h>
+#include <string>
 
 // EngineMove - a move returned by any chess engine implementation. 
 
@@ -21,4 +22,8 @@ struct EngineMove
     {}
 };
 
+// "e2e4" / "e7e8q" -> board pixel positions. isValid is false for anything
+// shorter than a move.
+EngineMove EngineMoveFromUCI(const std::string &uciStr);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,223 @@
+#include "EnginePool.hpp"
+#include <algorithm>
+
+EngineLease::EngineLease(EngineLease &&other) noexcept
+    : pool(other.pool), slot(other.slot), engine(other.engine)
+{
+    other.pool = nullptr;
+    other.slot = -1;
+    other.engine = nullptr;
+}
+
+EngineLease &EngineLease::operator=(EngineLease &&other) noexcept
+{
+    if (this != &other)
+    {
+        Release();
+        pool = other.pool;
+        slot = other.slot;
+        engine = other.engine;
+        other.pool = nullptr;
+        other.slot = -1;
+        other.engine = nullptr;
+    }
+    return *this;
+}
+
+void EngineLease::Release()
+{
+    if (pool != nullptr && engine != nullptr)
+        pool->Return(slot);
+    pool = nullptr;
+    slot = -1;
+    engine = nullptr;
+}
+
+EnginePool::EnginePool(int size)
+    : slots(static_cast<std::size_t>(std::max(1, size)))
+{
+}
+
+EnginePool::~EnginePool()
+{
+    for (Slot &slot : slots)
+    {
+        if (slot.startup.valid())
+            slot.startup.wait();
+    }
+    for (Slot &slot : slots)
+    {
+        if (slot.engine != nullptr)
+            slot.engine->shutdown();
+    }
+}
+
+void EnginePool::StartSlot(int index)
+{
+    Slot &slot = slots[index];
+    slot.engine.reset(new StockfishEngine());
+    slot.state = SLOT_STARTING;
+    slot.optionsKnown = false;
+
+    StockfishEngine *engine = slot.engine.get();
+    slot.startup = std::async(std::launch::async, [this, index, engine]()
+    {
+        bool ok = engine->init();
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            slots[index].state = ok ? SLOT_FREE : SLOT_FAILED;
+        }
+        slotChanged.notify_all();
+    });
+}
+
+void EnginePool::Start()
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+    if (started)
+        return;
+
+    started = true;
+    startedAt = Clock::now();
+    for (std::size_t i = 0; i < slots.size(); i++)
+        StartSlot(static_cast<int>(i));
+}
+
+void EnginePool::ApplyOptions(Slot &slot, const EngineOptions &options)
+{
+    StockfishEngine &engine = *slot.engine;
+
+    if (!slot.optionsKnown || slot.applied.threads != options.threads)
+        engine.setOption("Threads", std::to_string(options.threads));
+    if (!slot.optionsKnown || slot.applied.hashMb != options.hashMb)
+        engine.setOption("Hash", std::to_string(options.hashMb)); // Reallocates - only when it changes
+    if (!slot.optionsKnown || slot.applied.skillLevel != options.skillLevel)
+        engine.setDifficulty(options.skillLevel);
+
+    slot.applied = options;
+    slot.optionsKnown = true;
+}
+
+EngineLease EnginePool::Acquire(const EngineOptions &options, int timeoutMs)
+{
+    Start();
+
+    Clock::time_point requested = Clock::now();
+    Clock::time_point deadline = requested + std::chrono::milliseconds(std::max(0, timeoutMs));
+
+    std::unique_lock<std::mutex> lock(poolMutex);
+    bool waited = false;
+    bool retried = false;
+    int chosen = -1;
+
+    while (true)
+    {
+        bool anyAlive = false;
+        for (std::size_t i = 0; i < slots.size(); i++)
+        {
+            if (slots[i].state == SLOT_FREE && chosen < 0)
+                chosen = static_cast<int>(i);
+            if (slots[i].state != SLOT_FAILED)
+                anyAlive = true;
+        }
+        if (chosen >= 0)
+            break;
+
+        // Every process failed to start: try once more, then give up
+        if (!anyAlive)
+        {
+            if (retried)
+                return EngineLease();
+            retried = true;
+            for (std::size_t i = 0; i < slots.size(); i++)
+            {
+                if (slots[i].startup.valid())
+                    slots[i].startup.wait(); // Already finished - it set SLOT_FAILED
+                StartSlot(static_cast<int>(i));
+            }
+        }
+
+        waited = true;
+        if (timeoutMs < 0)
+            slotChanged.wait(lock);
+        else if (slotChanged.wait_until(lock, deadline) == std::cv_status::timeout)
+        {
+            // One last look - the notify may have raced the timeout
+            for (std::size_t i = 0; i < slots.size() && chosen < 0; i++)
+            {
+                if (slots[i].state == SLOT_FREE)
+                    chosen = static_cast<int>(i);
+            }
+            if (chosen < 0)
+                return EngineLease();
+            break;
+        }
+    }
+
+    Slot &slot = slots[chosen];
+    slot.state = SLOT_LEASED;
+    slot.leasedAt = Clock::now();
+
+    double waitMs = std::chrono::duration<double, std::milli>(slot.leasedAt - requested).count();
+    acquireCount++;
+    if (waited)
+        waitCount++;
+    totalWaitMs += waitMs;
+    maxWaitMs = std::max(maxWaitMs, waitMs);
+    lock.unlock();
+
+    // The slot is ours now - talk to the process without holding the pool lock
+    ApplyOptions(slot, options);
+
+    EngineLease lease;
+    lease.pool = this;
+    lease.slot = chosen;
+    lease.engine = slot.engine.get();
+    return lease;
+}
+
+void EnginePool::Return(int index)
+{
+    Slot &slot = slots[index];
+    slot.engine->reset(); // Cancels any search and sends ucinewgame
+
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        leasedMs += std::chrono::duration<double, std::milli>(Clock::now() - slot.leasedAt).count();
+        slot.state = SLOT_FREE;
+    }
+    slotChanged.notify_all();
+}
+
+EnginePoolStats EnginePool::Stats() const
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+
+    EnginePoolStats stats;
+    stats.size = static_cast<int>(slots.size());
+    stats.acquires = acquireCount;
+    stats.waits = waitCount;
+    stats.totalWaitMs = totalWaitMs;
+    stats.maxWaitMs = maxWaitMs;
+
+    Clock::time_point now = Clock::now();
+    double busyMs = leasedMs;
+    for (const Slot &slot : slots)
+    {
+        if (slot.state == SLOT_FREE || slot.state == SLOT_LEASED)
+            stats.running++;
+        if (slot.state == SLOT_LEASED)
+        {
+            stats.leased++;
+            busyMs += std::chrono::duration<double, std::milli>(now - slot.leasedAt).count();
+        }
+    }
+
+    if (started && stats.running > 0)
+    {
+        double uptimeMs = std::chrono::duration<double, std::milli>(now - startedAt).count();
+        if (uptimeMs > 0)
+            stats.utilization = std::min(1.0, busyMs / (uptimeMs * stats.running));
+    }
+    return stats;
+}
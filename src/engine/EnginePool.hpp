@@ -0,0 +1,128 @@
+#ifndef ENGINE_POOL_HPP
+#define ENGINE_POOL_HPP
+
+#include "StockfishEngine.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// EnginePool - keeps a fixed number of warmed-up Stockfish processes and
+// lends them out, one per game or analysis job. Processes start in the
+// background when the pool starts; a lease hands one out with the requested
+// options applied and gives it back (after ucinewgame) when released.
+
+// Per-lease UCI options. Only values that differ from what the process
+// already has are sent, so reusing a process with the same options is free.
+struct EngineOptions
+{
+    int skillLevel = 20; // 1-20
+    int threads = 1;
+    int hashMb = 16;
+};
+
+struct EnginePoolStats
+{
+    int size = 0;             // Processes the pool was asked for
+    int running = 0;          // Started successfully
+    int leased = 0;           // Currently lent out
+    uint64_t acquires = 0;    // Leases handed out
+    uint64_t waits = 0;       // Acquires that found no free process
+    double totalWaitMs = 0;   // Time callers spent waiting for a process
+    double maxWaitMs = 0;
+    double utilization = 0;   // Leased process-time / running process-time since Start()
+};
+
+class EnginePool;
+
+// Move-only handle to a leased engine. Releases itself when destroyed.
+class EngineLease
+{
+public:
+    EngineLease() = default;
+    EngineLease(EngineLease &&other) noexcept;
+    EngineLease &operator=(EngineLease &&other) noexcept;
+    EngineLease(const EngineLease &) = delete;
+    EngineLease &operator=(const EngineLease &) = delete;
+    ~EngineLease() { Release(); }
+
+    StockfishEngine *get() const { return engine; }
+    StockfishEngine *operator->() const { return engine; }
+    explicit operator bool() const { return engine != nullptr; }
+
+    // Sends ucinewgame and hands the process back to the pool
+    void Release();
+
+private:
+    friend class EnginePool;
+
+    EnginePool *pool = nullptr;
+    int slot = -1;
+    StockfishEngine *engine = nullptr;
+};
+
+class EnginePool
+{
+public:
+    explicit EnginePool(int size = 1);
+    ~EnginePool();
+
+    EnginePool(const EnginePool &) = delete;
+    EnginePool &operator=(const EnginePool &) = delete;
+
+    // Launches every process on a background thread and returns immediately
+    void Start();
+
+    // Waits up to timeoutMs (< 0 = no limit) for a free process. The lease is
+    // empty if none became free in time or no process could be started.
+    EngineLease Acquire(const EngineOptions &options, int timeoutMs = -1);
+
+    EnginePoolStats Stats() const;
+
+    int Size() const { return static_cast<int>(slots.size()); }
+
+private:
+    friend class EngineLease;
+
+    using Clock = std::chrono::steady_clock;
+
+    enum SlotState
+    {
+        SLOT_IDLE,     // Not started yet
+        SLOT_STARTING,
+        SLOT_FREE,
+        SLOT_LEASED,
+        SLOT_FAILED
+    };
+
+    struct Slot
+    {
+        std::unique_ptr<StockfishEngine> engine;
+        SlotState state = SLOT_IDLE;
+        EngineOptions applied;        // What the process currently has
+        bool optionsKnown = false;    // False until the first lease sets them
+        Clock::time_point leasedAt;
+        std::future<void> startup;
+    };
+
+    std::vector<Slot> slots;
+    mutable std::mutex poolMutex;
+    std::condition_variable slotChanged;
+
+    Clock::time_point startedAt;
+    bool started = false;
+    uint64_t acquireCount = 0;
+    uint64_t waitCount = 0;
+    double totalWaitMs = 0;
+    double maxWaitMs = 0;
+    double leasedMs = 0;             // Finished leases
+
+    void StartSlot(int index);       // Caller holds poolMutex
+    void ApplyOptions(Slot &slot, const EngineOptions &options);
+    void Return(int index);
+};
+
+#endif
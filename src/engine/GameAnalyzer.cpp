@@ -0,0 +1,192 @@
+#include "GameAnalyzer.hpp"
+#include "../core/Position.hpp"
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+
+const int MATE_CP = 10000;
+const int ACQUIRE_POLL_MS = 250; // How often a worker waiting for a process checks for cancel
+const int ACQUIRE_GIVE_UP = 20;  // Empty acquires in a row, with no process running, before giving up
+
+} // namespace
+
+GameAnalyzer::GameAnalyzer(EnginePool &pool)
+    : pool(pool)
+{
+}
+
+GameAnalyzer::~GameAnalyzer()
+{
+    Cancel();
+}
+
+bool GameAnalyzer::Start(const std::vector<std::string> &uciMoves, int movetime, const EngineOptions &engineOptions)
+{
+    Cancel();
+
+    // Workers replay prefixes of this list, so refuse one that does not replay
+    Position pos = Position::StartPosition();
+    for (const std::string &uci : uciMoves)
+    {
+        Move move;
+        if (!pos.ParseUCI(uci, move))
+        {
+            std::cerr << "GameAnalyzer: Illegal move in game: " << uci << std::endl;
+            return false;
+        }
+        pos.MakeMove(move);
+    }
+
+    moves = uciMoves;
+    movetimeMs = movetime;
+    options = engineOptions;
+    total = static_cast<int>(moves.size()) + 1;
+    nextPly = 0;
+    done = 0;
+    cancelled = false;
+
+    int workerCount = std::max(1, std::min(pool.Size(), total));
+    searches.assign(workerCount, SearchHandle());
+    activeWorkers = workerCount;
+    for (int i = 0; i < workerCount; i++)
+        workers.emplace_back(&GameAnalyzer::WorkerLoop, this, i);
+    return true;
+}
+
+void GameAnalyzer::Cancel()
+{
+    cancelled = true;
+    {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        for (const SearchHandle &handle : searches)
+        {
+            if (handle.valid())
+                handle.cancel();
+        }
+    }
+
+    for (std::thread &worker : workers)
+    {
+        if (worker.joinable())
+            worker.join();
+    }
+    workers.clear();
+
+    std::lock_guard<std::mutex> lock(resultMutex);
+    pending.clear();
+    searches.clear();
+}
+
+void GameAnalyzer::TakeResults(std::vector<PositionEval> &out)
+{
+    std::lock_guard<std::mutex> lock(resultMutex);
+    out.insert(out.end(), pending.begin(), pending.end());
+    pending.clear();
+}
+
+void GameAnalyzer::WorkerLoop(int index)
+{
+    EngineLease lease;
+    int emptyAcquires = 0;
+    while (!cancelled && nextPly.load() < total)
+    {
+        // Other workers may hold every process; wait in slices so cancel stays quick
+        if (!lease)
+        {
+            lease = pool.Acquire(options, ACQUIRE_POLL_MS);
+            if (!lease && pool.Stats().running == 0 && ++emptyAcquires >= ACQUIRE_GIVE_UP)
+            {
+                std::cerr << "GameAnalyzer: No engine process could be started." << std::endl;
+                break;
+            }
+            continue;
+        }
+
+        int ply = nextPly.fetch_add(1);
+        if (ply >= total)
+            break;
+
+        PositionEval eval = Evaluate(*lease.get(), ply, index);
+        if (cancelled)
+            break;
+
+        std::lock_guard<std::mutex> lock(resultMutex);
+        pending.push_back(eval);
+        done++;
+    }
+
+    activeWorkers--;
+}
+
+PositionEval GameAnalyzer::Evaluate(StockfishEngine &engine, int ply, int index)
+{
+    PositionEval eval;
+    eval.ply = ply;
+
+    Position pos = Position::StartPosition();
+    for (int i = 0; i < ply; i++)
+    {
+        Move move;
+        pos.ParseUCI(moves[i], move); // Checked in Start()
+        pos.MakeMove(move);
+    }
+
+    const int sign = pos.SideToMove() == 1 ? 1 : -1;
+
+    // The game ended here; no need to ask the engine
+    MoveList legal;
+    pos.GenerateLegalMoves(legal);
+    if (legal.count == 0)
+    {
+        eval.hasScore = true;
+        eval.mate = pos.InCheck();
+        eval.whiteCp = eval.mate ? -sign * MATE_CP : 0;
+        return eval;
+    }
+
+    SearchRequest request;
+    request.moveHistory.assign(moves.begin(), moves.begin() + ply);
+    request.movetimeMs = movetimeMs;
+
+    SearchHandle handle = engine.startSearch(request);
+    if (!handle.valid())
+        return eval;
+    {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        searches[index] = handle;
+        if (cancelled)
+            handle.cancel();
+    }
+
+    SearchResult result = handle.wait();
+    {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        searches[index] = SearchHandle();
+    }
+
+    // Scores come from the side to move; store them from white's
+    if (result.hasScore)
+    {
+        eval.hasScore = true;
+        eval.mate = result.mate;
+        if (result.mate)
+        {
+            eval.mateIn = sign * result.score;
+            eval.whiteCp = sign * (result.score > 0 ? MATE_CP : -MATE_CP);
+        }
+        else
+        {
+            eval.whiteCp = sign * result.score;
+        }
+    }
+
+    Move best;
+    if (pos.ParseUCI(result.bestMove, best))
+    {
+        eval.bestMove = pos.ToSAN(best);
+        eval.playedBest = ply < static_cast<int>(moves.size()) && moves[ply] == result.bestMove;
+    }
+    return eval;
+}
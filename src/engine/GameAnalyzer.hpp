@@ -0,0 +1,63 @@
+#ifndef GAME_ANALYZER_HPP
+#define GAME_ANALYZER_HPP
+
+#include "EnginePool.hpp"
+#include "../core/PositionEval.hpp"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// GameAnalyzer - scores every position of a finished game in parallel.
+//
+// One worker thread per pool process leases an engine and keeps taking the
+// next unanalysed ply until none are left, so a game takes roughly
+// movetime * plies / processes. Results are handed back in completion order
+// through TakeResults(), meant to be drained once per frame by the UI.
+
+class GameAnalyzer
+{
+public:
+    explicit GameAnalyzer(EnginePool &pool);
+    ~GameAnalyzer();
+
+    GameAnalyzer(const GameAnalyzer &) = delete;
+    GameAnalyzer &operator=(const GameAnalyzer &) = delete;
+
+    // Cancels any previous run. Returns false if the move list does not replay.
+    bool Start(const std::vector<std::string> &uciMoves, int movetimeMs, const EngineOptions &options);
+
+    // Stops the running searches and joins the workers; pending results are dropped
+    void Cancel();
+
+    bool Running() const { return activeWorkers.load() > 0; }
+    int Done() const { return done.load(); }
+    int Total() const { return total; } // Positions, i.e. plies + 1
+
+    // Moves finished results into out (appending)
+    void TakeResults(std::vector<PositionEval> &out);
+
+private:
+    EnginePool &pool;
+    std::vector<std::thread> workers;
+
+    std::vector<std::string> moves;
+    int movetimeMs = 0;
+    EngineOptions options;
+    int total = 0;
+
+    std::atomic<int> nextPly{0};
+    std::atomic<int> done{0};
+    std::atomic<int> activeWorkers{0};
+    std::atomic<bool> cancelled{false};
+
+    std::mutex resultMutex;
+    std::vector<PositionEval> pending;
+    std::vector<SearchHandle> searches; // In flight per worker, so Cancel() can stop them
+
+    void WorkerLoop(int index);
+    PositionEval Evaluate(StockfishEngine &engine, int ply, int index);
+};
+
+#endif // GAME_ANALYZER_HPP
@@ -0,0 +1,179 @@
+#include "PipeReader.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOGDI
+#define NOGDI
+#endif
+#ifndef NOUSER
+#define NOUSER
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+void PipeReader::Attach(PipeHandle h)
+{
+    handle = h;
+    attached = true;
+    head = tail = 0;
+}
+
+void PipeReader::Detach()
+{
+    attached = false;
+    head = tail = 0;
+}
+
+// Moves the next complete line out of the ring. With force set, whatever is
+// buffered counts as a line (used when a line is longer than the buffer).
+bool PipeReader::TakeLine(std::string &line, bool force)
+{
+    std::size_t start = head & (CAPACITY - 1);
+    std::size_t used = tail - head;
+    std::size_t firstLength = std::min(used, CAPACITY - start);
+
+    // The buffered data is at most two runs: up to the end of the array, then from its start
+    std::size_t lineLength = used;
+    bool found = false;
+    if (const char *nl = static_cast<const char *>(std::memchr(buffer + start, '\n', firstLength)))
+    {
+        lineLength = static_cast<std::size_t>(nl - (buffer + start));
+        found = true;
+    }
+    else if (const char *nl = static_cast<const char *>(std::memchr(buffer, '\n', used - firstLength)))
+    {
+        lineLength = firstLength + static_cast<std::size_t>(nl - buffer);
+        found = true;
+    }
+
+    if (!found && !force)
+        return false;
+
+    line.clear();
+    if (lineLength <= firstLength)
+    {
+        line.append(buffer + start, lineLength);
+    }
+    else
+    {
+        line.append(buffer + start, firstLength);
+        line.append(buffer, lineLength - firstLength);
+    }
+    if (!line.empty() && line.back() == '\r')
+        line.pop_back();
+
+    head += lineLength + (found ? 1 : 0);
+    linesRead.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+PipeReader::Status PipeReader::Fill(int timeoutMs)
+{
+    if (!attached)
+        return CLOSED;
+
+    // Read into the free run that starts at tail
+    std::size_t start = tail & (CAPACITY - 1);
+    std::size_t space = std::min(CAPACITY - (tail - head), CAPACITY - start);
+
+#ifdef _WIN32
+    HANDLE h = static_cast<HANDLE>(handle);
+    DWORD available = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (true)
+    {
+        pollCalls.fetch_add(1, std::memory_order_relaxed);
+        if (!PeekNamedPipe(h, NULL, 0, NULL, &available, NULL))
+            return CLOSED;
+        if (available > 0)
+            break;
+        if (timeoutMs >= 0 && std::chrono::steady_clock::now() >= deadline)
+            return TIMEOUT;
+        Sleep(1);
+    }
+
+    DWORD got = 0;
+    readCalls.fetch_add(1, std::memory_order_relaxed);
+    DWORD toRead = static_cast<DWORD>(std::min<std::size_t>(space, available));
+    if (!ReadFile(h, buffer + start, toRead, &got, NULL) || got == 0)
+        return CLOSED;
+#else
+    // With no timeout a plain blocking read does the waiting, one syscall instead of two
+    if (timeoutMs >= 0)
+    {
+        pollfd pfd;
+        pfd.fd = handle;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        int ready;
+        do
+        {
+            pollCalls.fetch_add(1, std::memory_order_relaxed);
+            ready = poll(&pfd, 1, timeoutMs);
+        } while (ready < 0 && errno == EINTR);
+
+        if (ready == 0)
+            return TIMEOUT;
+        if (ready < 0)
+            return CLOSED;
+    }
+
+    ssize_t got;
+    do
+    {
+        readCalls.fetch_add(1, std::memory_order_relaxed);
+        got = read(handle, buffer + start, space);
+    } while (got < 0 && errno == EINTR);
+
+    if (got <= 0)
+        return CLOSED;
+#endif
+
+    tail += static_cast<std::size_t>(got);
+    bytesRead.fetch_add(static_cast<uint64_t>(got), std::memory_order_relaxed);
+    return LINE;
+}
+
+PipeReader::Status PipeReader::ReadLine(std::string &line, int timeoutMs)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+    while (!TakeLine(line, false))
+    {
+        if (tail - head == CAPACITY)
+        {
+            TakeLine(line, true); // A single line filled the whole buffer
+            return LINE;
+        }
+
+        int remaining = timeoutMs;
+        if (timeoutMs >= 0)
+        {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            remaining = std::max(0, static_cast<int>(left.count()));
+        }
+
+        Status status = Fill(remaining);
+        if (status == CLOSED && tail != head)
+        {
+            TakeLine(line, true); // Last line without a newline
+            return LINE;
+        }
+        if (status != LINE)
+            return status;
+    }
+    return LINE;
+}
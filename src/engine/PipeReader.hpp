@@ -0,0 +1,63 @@
+#ifndef PIPE_READER_HPP
+#define PIPE_READER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// PipeReader - line reader for an engine's stdout pipe.
+//
+// Drains the pipe with large reads into a ring buffer and splits lines in
+// user space, so a burst of "info" lines costs one read instead of one per
+// character. Waiting is done with poll() (PeekNamedPipe on Windows) and a
+// timeout, so a hung or crashed engine can no longer block forever.
+
+#ifdef _WIN32
+typedef void *PipeHandle; // HANDLE
+#else
+typedef int PipeHandle;   // File descriptor
+#endif
+
+class PipeReader
+{
+public:
+    enum Status
+    {
+        LINE,    // line holds the next line (without "\r\n")
+        TIMEOUT, // Nothing complete arrived in time
+        CLOSED   // The other end is gone
+    };
+
+    void Attach(PipeHandle handle);
+    void Detach();
+
+    // timeoutMs < 0 waits as long as it takes
+    Status ReadLine(std::string &line, int timeoutMs);
+
+    // Syscall counters for EngineStats
+    uint64_t ReadCalls() const { return readCalls.load(std::memory_order_relaxed); }
+    uint64_t PollCalls() const { return pollCalls.load(std::memory_order_relaxed); }
+    uint64_t BytesRead() const { return bytesRead.load(std::memory_order_relaxed); }
+    uint64_t LinesRead() const { return linesRead.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr std::size_t CAPACITY = 1 << 16; // Power of two
+
+    PipeHandle handle;
+    bool attached = false;
+
+    char buffer[CAPACITY];
+    std::size_t head = 0; // Total bytes consumed
+    std::size_t tail = 0; // Total bytes stored
+
+    std::atomic<uint64_t> readCalls{0};
+    std::atomic<uint64_t> pollCalls{0};
+    std::atomic<uint64_t> bytesRead{0};
+    std::atomic<uint64_t> linesRead{0};
+
+    bool TakeLine(std::string &line, bool force);
+    Status Fill(int timeoutMs);
+};
+
+#endif
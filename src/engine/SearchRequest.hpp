@@ -0,0 +1,56 @@
+#ifndef SEARCH_REQUEST_HPP
+#define SEARCH_REQUEST_HPP
+
+#include "EngineMove.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// SearchRequest - what to search and how long for.
+// Zero / negative limits are "not set". With no limit at all the engine
+// falls back to its own default move time.
+
+struct SearchRequest
+{
+    std::string startFen;                 // Position the moves start from; empty = standard start
+    std::vector<std::string> moveHistory; // UCI moves from there
+
+    int movetimeMs = 0;   // Fixed time for this move
+    int depth = 0;        // Plies
+    uint64_t nodes = 0;   // Node budget
+    int wtimeMs = -1;     // Clock times for engines that manage their own time
+    int btimeMs = -1;
+    int wincMs = 0;
+    int bincMs = 0;
+    int multipv = 1;      // Number of principal variations to report
+
+    // Set by TimeManager for clock games. After softLimitMs the search stops as
+    // soon as the best move is stable; at hardLimitMs it stops regardless.
+    int softLimitMs = 0;
+    int hardLimitMs = 0;
+
+    bool HasLimits() const
+    {
+        return movetimeMs > 0 || depth > 0 || nodes > 0 || wtimeMs >= 0 || btimeMs >= 0 ||
+               hardLimitMs > 0;
+    }
+};
+
+// SearchResult - what came back. stopped is true when the search was cut
+// short by stop(); the move is still the best one found so far.
+
+struct SearchResult
+{
+    EngineMove move;        // move.isValid is false if the engine had no move
+    std::string bestMove;   // UCI text, e.g. "e7e8q"
+    std::string ponderMove; // Expected reply, empty if the engine gave none
+    bool stopped = false;
+
+    // Last main-line score of the search, from the side to move
+    bool hasScore = false;
+    bool mate = false;      // score is moves to mate
+    int score = 0;
+    int depth = 0;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#include "SearchTelemetry.hpp"
+#include <cstdio>
+#include <string>
+
+namespace
+{
+
+// Microseconds as "850 us" or "12.3 ms"
+std::string FormatMicros(uint64_t us)
+{
+    char text[32];
+    if (us < 10000)
+        std::snprintf(text, sizeof(text), "%llu us", static_cast<unsigned long long>(us));
+    else
+        std::snprintf(text, sizeof(text), "%.1f ms", us / 1000.0);
+    return text;
+}
+
+std::string FormatCount(uint64_t value)
+{
+    char text[32];
+    if (value < 100000)
+        std::snprintf(text, sizeof(text), "%llu", static_cast<unsigned long long>(value));
+    else if (value < 100000000)
+        std::snprintf(text, sizeof(text), "%.1fk", value / 1e3);
+    else
+        std::snprintf(text, sizeof(text), "%.1fM", value / 1e6);
+    return text;
+}
+
+void PrintRow(std::ostream &out, const char *name, const LatencyHistogram &h, bool micros)
+{
+    if (h.Count() == 0)
+        return;
+
+    auto format = micros ? FormatMicros : FormatCount;
+    char row[160];
+    std::snprintf(row, sizeof(row), "  %-11s n=%-6llu p50 %-10s p99 %-10s max %s\n", name,
+                  static_cast<unsigned long long>(h.Count()), format(h.Percentile(50)).c_str(),
+                  format(h.Percentile(99)).c_str(), format(h.Max()).c_str());
+    out << row;
+}
+
+} // namespace
+
+void SearchTelemetry::Print(std::ostream &out) const
+{
+    out << "Engine search telemetry (" << total.Count() << " searches):\n";
+    PrintRow(out, "build", build, true);
+    PrintRow(out, "write", write, true);
+    PrintRow(out, "first info", firstInfo, true);
+    PrintRow(out, "bestmove", bestMove, true);
+    PrintRow(out, "parse", parse, true);
+    PrintRow(out, "total", total, true);
+    PrintRow(out, "depth", depth, false);
+    PrintRow(out, "nodes", nodes, false);
+    PrintRow(out, "nps", nps, false);
+    out.flush();
+}
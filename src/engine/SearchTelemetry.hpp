@@ -0,0 +1,29 @@
+#ifndef SEARCH_TELEMETRY_HPP
+#define SEARCH_TELEMETRY_HPP
+
+#include "../core/LatencyHistogram.hpp"
+#include <ostream>
+
+// SearchTelemetry - where the time of an engine turn goes, and what the
+// search reached. Times are in microseconds. Recorded by the engine's worker
+// thread; Print() can run on any thread at any time.
+
+struct SearchTelemetry
+{
+    LatencyHistogram build;     // Position and go commands put together
+    LatencyHistogram write;     // Sending them (or ponderhit) down the pipe
+    LatencyHistogram firstInfo; // go sent -> first info line
+    LatencyHistogram bestMove;  // go / ponderhit sent -> bestmove line
+    LatencyHistogram parse;     // bestmove line -> result
+    LatencyHistogram total;     // The whole search() call
+
+    // From the last info line of each search
+    LatencyHistogram depth;
+    LatencyHistogram nodes;
+    LatencyHistogram nps;
+
+    // p50 / p99 / max per histogram, one line each
+    void Print(std::ostream &out) const;
+};
+
+#endif // SEARCH_TELEMETRY_HPP
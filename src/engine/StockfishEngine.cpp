@@ -1,10 +1,32 @@
 #include "StockfishEngine.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 
+namespace
+{
 
-extern float squareSize;
-extern Vector2 boardPosition;
+uint64_t MicrosSince(std::chrono::steady_clock::time_point start)
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                     std::chrono::steady_clock::now() - start).count());
+}
 
-StockfishEngine::StockfishEngine()
+} // namespace
+
+std::string StockfishEngine::DefaultPath()
+{
+    const char *path = std::getenv("CHESS_ENGINE_PATH");
+    if (path != nullptr && path[0] != '\0')
+        return path;
+#ifdef _WIN32
+    return "stockfish.exe";
+#else
+    return "stockfish";
+#endif
+}
+
+StockfishEngine::StockfishEngine(const std::string &path)
 #ifdef _WIN32
     : hProcess(INVALID_HANDLE_VALUE),
       hChildStdinRead(INVALID_HANDLE_VALUE),
@@ -18,9 +40,25 @@ StockfishEngine::StockfishEngine()
       hChildStdoutRead(-1),
       hChildStdoutWrite(-1),
 #endif
+      enginePath(path),
       skillLevel(10),
-      moveTimeMs(300)
+      moveTimeMs(300),
+      multiPv(1),
+      searching(false),
+      writeCalls(0),
+      collectInfo(false),
+      awaitingFirstInfo(false),
+      pvBest(),
+      pvDepth(0),
+      pvStableDepths(0),
+      ponderEnabled(false),
+      ponderActive(false),
+      ponderStopSent(false),
+      ponderWhite(true),
+      ponderHits(0),
+      ponderMisses(0)
 {
+    resetReplay();
 }
 
 StockfishEngine::~StockfishEngine()
@@ -75,10 +113,13 @@ bool StockfishEngine::init()
     PROCESS_INFORMATION pi;
     ZeroMemory(&pi, sizeof(pi));
 
-    char exeName[] = "stockfish.exe";
-    if (!CreateProcessA(NULL, exeName, NULL, NULL, TRUE, 0, NULL, NULL, &si, &pi))
+    // CreateProcessA may write into the command line, so it needs its own buffer
+    std::string quoted = "\"" + enginePath + "\"";
+    std::vector<char> commandLine(quoted.begin(), quoted.end());
+    commandLine.push_back('\0');
+    if (!CreateProcessA(NULL, commandLine.data(), NULL, NULL, TRUE, 0, NULL, NULL, &si, &pi))
     {
-        std::cerr << "StockfishEngine: Failed to launch stockfish.exe. "
+        std::cerr << "StockfishEngine: Failed to launch " << enginePath << ". "
                   << "Is it in the project root directory? Error:"
                   << GetLastError() << std::endl;
 
@@ -102,6 +143,9 @@ bool StockfishEngine::init()
     CloseHandle(pi.hThread); 
 
 #else
+    // A crashed engine must show up as a failed write, not kill the game with SIGPIPE
+    signal(SIGPIPE, SIG_IGN);
+
     int stdinPipe[2];
     int stdoutPipe[2];
 
@@ -118,6 +162,7 @@ bool StockfishEngine::init()
         return false;
     }
 
+    const char *exePath = enginePath.c_str(); // No allocation after fork
     pid_t pid = fork();
     if (pid == -1)
     {
@@ -136,7 +181,7 @@ bool StockfishEngine::init()
         close(stdinPipe[0]); close(stdinPipe[1]);
         close(stdoutPipe[0]); close(stdoutPipe[1]);
 
-        execlp("stockfish", "stockfish", nullptr);
+        execlp(exePath, exePath, nullptr);
         _exit(127);
     }
 
@@ -152,11 +197,24 @@ bool StockfishEngine::init()
     std::cout << "StockfishEngine: Forked child pid " << pid << std::endl;
 #endif
 
+    stdoutReader.Attach(hChildStdoutRead);
+
+    std::string line;
     sendCommand("uci\n");
-    readUntil("uciok");
+    if (!readUntil("uciok", line, HANDSHAKE_TIMEOUT_MS))
+    {
+        std::cerr << "StockfishEngine: No uciok from the engine." << std::endl;
+        shutdown();
+        return false;
+    }
 
     sendCommand("isready\n"); 
-    readUntil("readyok"); // Block until engine is fully loaded 
+    if (!readUntil("readyok", line, HANDSHAKE_TIMEOUT_MS)) // Block until engine is fully loaded 
+    {
+        std::cerr << "StockfishEngine: No readyok from the engine." << std::endl;
+        shutdown();
+        return false;
+    }
 
     std::cout << "StockfishEngine: Ready." << std::endl; 
 
@@ -166,6 +224,7 @@ bool StockfishEngine::init()
 
 bool StockfishEngine::sendCommand(const std::string& cmd) 
 {
+    writeCalls.fetch_add(1, std::memory_order_relaxed);
 #ifdef _WIN32
     DWORD written = 0;
     BOOL ok = WriteFile(hChildStdinWrite, cmd.c_str(), static_cast<DWORD>(cmd.size()),
@@ -179,58 +238,139 @@ bool StockfishEngine::sendCommand(const std::string& cmd)
 #endif
 }
 
-std::string StockfishEngine::readLine()
+// Reads lines until one starts with keyword. False if the engine went quiet
+// for timeoutMs (< 0 = no limit) or closed its end of the pipe.
+bool StockfishEngine::readUntil(const std::string& keyword, std::string& line, int timeoutMs)
 {
-    std::string line; 
-    char c = '\0';
-
-#ifdef _WIN32
-    DWORD bytesRead = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
 
-    while (true) 
+    while (true)
     {
-        if (!ReadFile(hChildStdoutRead, &c, 1, &bytesRead, NULL) || bytesRead == 0)
-            break;
-        if (c == '\n')
-            break;
-        if (c != '\r')
-            line += c;
+        int remaining = timeoutMs;
+        if (timeoutMs >= 0)
+        {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            remaining = std::max(0, static_cast<int>(left.count()));
+        }
+
+        if (stdoutReader.ReadLine(line, remaining) != PipeReader::LINE)
+            return false;
+        if (collectInfo && line.compare(0, 5, "info ") == 0)
+            handleInfoLine(line);
+        if (line.compare(0, keyword.size(), keyword) == 0) // Line starts with keyword
+            return true;
     }
-#else
-    while (true)
+}
+
+// Keeps the main line (multipv 1) and publishes it whenever it carries a score
+void StockfishEngine::handleInfoLine(const std::string& line)
+{
+    EngineInfo parsed = searchInfo;
+    parsed.multipv = 1;
+    if (awaitingFirstInfo)
     {
-        ssize_t bytesRead = read(hChildStdoutRead, &c, 1);
-        if (bytesRead <= 0)
-            break;
-        if (c == '\n')
-            break;
-        if (c != '\r')
-            line += c;
+        telemetry.firstInfo.Record(MicrosSince(goSentAt));
+        awaitingFirstInfo = false;
     }
-#endif
 
-    return line; 
-}
+    if (!ParseInfoLine(line.data(), line.size(), parsed) || parsed.multipv != 1)
+        return;
 
-std::string StockfishEngine::readUntil(const std::string& keyword) {
+    searchInfo = parsed;
+    infoSlot.Store(searchInfo);
 
-    std::string line; 
+    if (parsed.pvLength > 0 && parsed.depth > pvDepth)
+    {
+        const EngineInfoMove &best = parsed.pv[0];
+        bool same = pvDepth > 0 && best.from == pvBest.from && best.to == pvBest.to &&
+                    best.promotion == pvBest.promotion;
+        pvStableDepths = same ? pvStableDepths + 1 : 0;
+        pvBest = best;
+        pvDepth = parsed.depth;
+    }
+}
+
+// Reads until bestmove while the time manager's limits run. Stops the search
+// at hardMs, at softMs once the best move has held for two depths, or at half
+// of softMs when it has not changed for eight (an obvious recapture).
+// False if the pipe closed or the engine ignored stop.
+bool StockfishEngine::readBestMoveTimed(int softMs, int hardMs, std::string& line)
+{
+    auto start = std::chrono::steady_clock::now();
+    int stopSentAt = -1;
 
     while (true)
     {
-        line = readLine(); 
-        if (line.substr(0, keyword.size()) == keyword) // Line starts with keyword
-            break;
+        int elapsed = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                           std::chrono::steady_clock::now() - start).count());
+
+        if (stopSentAt < 0 && (elapsed >= hardMs ||
+                               (elapsed >= softMs && pvStableDepths >= 2) ||
+                               (elapsed >= softMs / 2 && pvStableDepths >= 8)))
+        {
+            std::lock_guard<std::mutex> lock(searchMutex);
+            sendCommand("stop\n");
+            stopSentAt = elapsed;
+        }
+
+        // Sleep until the next limit; info lines wake us up earlier anyway
+        int waitMs;
+        if (stopSentAt >= 0)
+        {
+            waitMs = stopSentAt + BESTMOVE_GRACE_MS - elapsed;
+            if (waitMs <= 0)
+                return false;
+        }
+        else if (elapsed < softMs / 2)
+            waitMs = softMs / 2 - elapsed;
+        else if (elapsed < softMs)
+            waitMs = softMs - elapsed;
+        else
+            waitMs = hardMs - elapsed;
+
+        PipeReader::Status status = stdoutReader.ReadLine(line, std::max(1, waitMs));
+        if (status == PipeReader::CLOSED)
+            return false;
+        if (status == PipeReader::TIMEOUT)
+            continue;
+        if (line.compare(0, 5, "info ") == 0)
+            handleInfoLine(line);
+        if (line.compare(0, 8, "bestmove") == 0)
+            return true;
     }
-    return line; 
+}
+
+bool StockfishEngine::getInfo(EngineInfo& out) const
+{
+    out = infoSlot.Load();
+    return out.hasScore;
+}
+
+EngineStats StockfishEngine::getStats() const
+{
+    EngineStats stats;
+    stats.linesRead = stdoutReader.LinesRead();
+    stats.bytesRead = stdoutReader.BytesRead();
+    stats.readCalls = stdoutReader.ReadCalls();
+    stats.pollCalls = stdoutReader.PollCalls();
+    stats.writeCalls = writeCalls.load(std::memory_order_relaxed);
+    stats.ponderHits = ponderHits.load(std::memory_order_relaxed);
+    stats.ponderMisses = ponderMisses.load(std::memory_order_relaxed);
+    return stats;
 }
 
 
 void StockfishEngine::newGame()
 {
+    std::lock_guard<std::mutex> pipeLock(pipeMutex);
+    finishPonder();
+    resetReplay();
+    infoSlot.Store(EngineInfo()); // Clears the eval bar
     sendCommand("ucinewgame\n");
     sendCommand("isready\n");
-    readUntil("readyok");
+    std::string line;
+    if (!readUntil("readyok", line, HANDSHAKE_TIMEOUT_MS))
+        std::cerr << "StockfishEngine: No readyok after ucinewgame." << std::endl;
 }
 
 void StockfishEngine::setDifficulty(int level)
@@ -239,91 +379,390 @@ void StockfishEngine::setDifficulty(int level)
     if(level > 20) level = 20; 
     skillLevel = level; 
 
+    std::lock_guard<std::mutex> pipeLock(pipeMutex);
+    finishPonder(); // Options can only change while the engine is idle
+
     // Stockfish Skill Level: 0 (weak) to 20 (full strength)
     sendCommand("setoption name Skill Level value " + std::to_string(skillLevel) + "\n");
 }
 
-// getmove() : build position, ask for best move, parse response 
-EngineMove StockfishEngine::getMove(const std::vector<std::string>& moveHistory)
+void StockfishEngine::setOption(const std::string& name, const std::string& value)
+{
+    std::lock_guard<std::mutex> pipeLock(pipeMutex);
+    finishPonder();
+    sendCommand("setoption name " + name + " value " + value + "\n");
+}
+
+std::string StockfishEngine::buildGoCommand(const SearchRequest& request, bool ponder) const
+{
+    std::string goCmd = "go";
+    if (ponder) goCmd += " ponder";
+    if (request.wtimeMs >= 0) goCmd += " wtime " + std::to_string(request.wtimeMs);
+    if (request.btimeMs >= 0) goCmd += " btime " + std::to_string(request.btimeMs);
+    if (request.wincMs > 0) goCmd += " winc " + std::to_string(request.wincMs);
+    if (request.bincMs > 0) goCmd += " binc " + std::to_string(request.bincMs);
+    if (request.depth > 0) goCmd += " depth " + std::to_string(request.depth);
+    if (request.nodes > 0) goCmd += " nodes " + std::to_string(request.nodes);
+    if (request.movetimeMs > 0) goCmd += " movetime " + std::to_string(request.movetimeMs);
+    if (!request.HasLimits()) goCmd += " movetime " + std::to_string(moveTimeMs); // Default: think for moveTimeMs
+    goCmd += "\n";
+    return goCmd;
+}
+
+// search() : build position, send limits, parse response 
+SearchResult StockfishEngine::search(const SearchRequest& request)
 {
-    std::string posCmd = "position startpos";
-    if (!moveHistory.empty())
+    auto searchStart = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> pipeLock(pipeMutex);
+    SearchResult result;
+
+    // A ponder on exactly this position, started with the limits the engine
+    // has now, just carries on as the real search
+    bool ponderHit = ponderActive.load() && !ponderStopSent && request.moveHistory == ponderHistory &&
+                     request.startFen == ponderStartFen && ponderLimitsMatch(request);
+    if (ponderActive.load() && !ponderHit)
+    {
+        finishPonder();
+        ponderMisses.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (!ponderHit && request.multipv != multiPv && request.multipv >= 1)
     {
-        posCmd += " moves";
-        for(const auto& m : moveHistory)
-            posCmd += " " + m; 
+        multiPv = request.multipv;
+        sendCommand("setoption name MultiPV value " + std::to_string(multiPv) + "\n");
     }
-    posCmd += "\n"; 
-    sendCommand(posCmd); 
 
-    // Ask engine to think for moveTimeMs milliseconds 
-    sendCommand("go movetime " + std::to_string(moveTimeMs) + "\n"); 
+    if (ponderHit)
+    {
+        ponderHits.fetch_add(1, std::memory_order_relaxed);
+        ponderActive = false;
+
+        std::lock_guard<std::mutex> lock(searchMutex);
+        auto writeStart = std::chrono::steady_clock::now();
+        sendCommand("ponderhit\n"); // The go limits now count, from when the ponder started
+        goSentAt = std::chrono::steady_clock::now();
+        telemetry.write.Record(MicrosSince(writeStart));
+        searching = true;
+        if (stopRequested())
+            sendCommand("stop\n");
+    }
+    else
+    {
+        auto buildStart = std::chrono::steady_clock::now();
+        const std::string& positionCmd = buildPositionCommand(request.startFen, request.moveHistory);
+        std::string goCmd = buildGoCommand(request, false);
+        telemetry.build.Record(MicrosSince(buildStart));
+
+        auto writeStart = std::chrono::steady_clock::now();
+        sendCommand(positionCmd);
+
+        std::lock_guard<std::mutex> lock(searchMutex);
+        sendCommand(goCmd);
+        goSentAt = std::chrono::steady_clock::now();
+        telemetry.write.Record(MicrosSince(writeStart));
+        awaitingFirstInfo = true;
+        searching = true;
+        if (stopRequested()) // stop() arrived before the search started
+            sendCommand("stop\n");
+    }
 
-    // Read Lines until we get one starting with "bestmove"
-    std::string line = readUntil("bestmove");
+    // Read Lines until we get one starting with "bestmove". A fixed movetime
+    // gets a deadline; depth/node searches only stop on a dead pipe, and
+    // clock searches stop where the time manager says.
+    int timeoutMs = -1;
+    if (request.movetimeMs > 0)
+        timeoutMs = request.movetimeMs + BESTMOVE_GRACE_MS;
+    else if (!request.HasLimits())
+        timeoutMs = moveTimeMs + BESTMOVE_GRACE_MS;
+
+    if (!ponderHit) // A hit keeps the info it already has for this position
+    {
+        searchInfo = EngineInfo();
+        searchInfo.whiteToMove = replayPosition.SideToMove() == 1;
+        pvDepth = 0;
+        pvStableDepths = 0;
+    }
+    collectInfo = true;
+
+    std::string& line = lineBuffer;
+    bool answered;
+    if (request.hardLimitMs > 0)
+        answered = readBestMoveTimed(request.softLimitMs, request.hardLimitMs, line);
+    else
+        answered = readUntil("bestmove", line, timeoutMs);
+    if (!answered && timeoutMs >= 0)
+    {
+        std::cerr << "StockfishEngine: No bestmove in time, sending stop." << std::endl;
+        {
+            std::lock_guard<std::mutex> lock(searchMutex);
+            sendCommand("stop\n");
+        }
+        answered = readUntil("bestmove", line, BESTMOVE_GRACE_MS);
+    }
+    collectInfo = false;
+    awaitingFirstInfo = false;
+    auto answeredAt = std::chrono::steady_clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(searchMutex);
+        searching = false;
+    }
+    result.stopped = stopRequested();
+
+    if (!answered)
+    {
+        std::cerr << "StockfishEngine: Engine stopped responding." << std::endl;
+        return result; // move.isValid = false
+    }
+    telemetry.bestMove.Record(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(answeredAt - goSentAt).count()));
 
     if(line.find("bestmove (none)") != std::string::npos || line.size() < 9) // "bestmove" = 9 chars minimum
     {
-        return EngineMove(); // isValid = false
+        return result; // move.isValid = false
     }
 
-    // Extract just the move string (4-5 chars), ignore "ponder ..." tail 
-    std::string moveStr = line.substr(9); // Skip "bestmove "
-    std::size_t spacePos = moveStr.find(' '); 
-    if (spacePos != std::string::npos)
-        moveStr = moveStr.substr(0, spacePos); 
+    // "bestmove e2e4 ponder e7e5" - keep both moves
+    std::istringstream tokens(line.substr(9)); // Skip "bestmove "
+    std::string ponderKeyword;
+    tokens >> result.bestMove >> ponderKeyword >> result.ponderMove;
+    if (ponderKeyword != "ponder")
+        result.ponderMove.clear();
+
+    result.move = EngineMoveFromUCI(result.bestMove);
+    result.hasScore = searchInfo.hasScore;
+    result.mate = searchInfo.mate;
+    result.score = searchInfo.score;
+    result.depth = searchInfo.depth;
+
+    telemetry.parse.Record(MicrosSince(answeredAt));
+    telemetry.total.Record(MicrosSince(searchStart));
+    telemetry.depth.Record(static_cast<uint64_t>(std::max(0, searchInfo.depth)));
+    if (searchInfo.nodes > 0)
+        telemetry.nodes.Record(searchInfo.nodes);
+    if (searchInfo.nps > 0)
+        telemetry.nps.Record(searchInfo.nps);
+
+    if (ponderEnabled.load() && !result.stopped && !result.ponderMove.empty())
+        startPonder(request, result, static_cast<int>(MicrosSince(searchStart) / 1000));
+    return result; 
+}
 
-    return uciToEngineMove(moveStr); 
+// Searches the position after our move and the reply the engine expects,
+// while the opponent thinks. The next search() turns it into the real search
+// with ponderhit, or stops it if another move was played.
+void StockfishEngine::startPonder(const SearchRequest& request, const SearchResult& result, int elapsedMs)
+{
+    ponderStartFen = request.startFen;
+    ponderHistory = request.moveHistory;
+    ponderHistory.push_back(result.bestMove);
+    ponderHistory.push_back(result.ponderMove);
+
+    // Building the command replays the two predicted plies. They are rolled
+    // back afterwards, so that after a miss the next search() still extends
+    // the replay instead of starting over from the first move.
+    Position replayBefore = replayPosition;
+    std::size_t movesBefore = replayedMoves.size();
+    std::size_t anchorPlyBefore = anchorPly;
+    std::string anchorFenBefore = anchorFen;
+
+    sendCommand(buildPositionCommand(ponderStartFen, ponderHistory));
+    ponderWhite = replayPosition.SideToMove() == 1;
+
+    if (replayedMoves.size() >= movesBefore)
+    {
+        replayedMoves.resize(movesBefore);
+        replayPosition = replayBefore;
+        anchorPly = anchorPlyBefore;
+        anchorFen = anchorFenBefore;
+    }
+
+    // ponderhit sends no limits, so go ponder carries the clocks the engine
+    // will have on its next move: its own minus this search, plus the
+    // increment. Its clock does not run while the opponent thinks.
+    ponderLimits = request;
+    int &ownMs = ponderWhite ? ponderLimits.wtimeMs : ponderLimits.btimeMs;
+    if (ownMs >= 0)
+        ownMs = std::max(1, ownMs - elapsedMs) + (ponderWhite ? ponderLimits.wincMs : ponderLimits.bincMs);
+    sendCommand(buildGoCommand(ponderLimits, true));
+    ponderActive = true;
+    ponderStopSent = false;
+
+    searchInfo = EngineInfo();
+    searchInfo.whiteToMove = ponderWhite;
+    pvDepth = 0;
+    pvStableDepths = 0;
+    collectInfo = true;
 }
 
-//uciToEngineMove() -convert "e2e4" to pixel positions
+// True if the engine can keep the limits it got with go ponder for this
+// request. Its own clock may come in a little lower than estimated (the game
+// also counts the frames before the move is shown); any more and the engine
+// would plan with time it does not have, so the ponder counts as a miss and
+// the position is searched again with the fresh clocks.
+bool StockfishEngine::ponderLimitsMatch(const SearchRequest& request) const
+{
+    int ownMs = ponderWhite ? request.wtimeMs : request.btimeMs;
+    int sentMs = ponderWhite ? ponderLimits.wtimeMs : ponderLimits.btimeMs;
+    return request.wincMs == ponderLimits.wincMs && request.bincMs == ponderLimits.bincMs &&
+           request.movetimeMs == ponderLimits.movetimeMs && request.depth == ponderLimits.depth &&
+           request.nodes == ponderLimits.nodes && (ownMs < 0) == (sentMs < 0) &&
+           ownMs >= sentMs - PONDER_CLOCK_SLACK_MS;
+}
 
-EngineMove StockfishEngine::uciToEngineMove(const std::string& uciStr) const
+// Ends a ponder and reads away its bestmove. Caller holds pipeMutex.
+void StockfishEngine::finishPonder()
 {
-    EngineMove em; 
+    if (!ponderActive.load())
+        return;
+
+    if (!ponderStopSent)
+        sendCommand("stop\n");
 
-    if (uciStr.size() < 4) return em; // Invalid string 
+    std::string line;
+    if (!readUntil("bestmove", line, BESTMOVE_GRACE_MS))
+        std::cerr << "StockfishEngine: No bestmove after stopping the ponder." << std::endl;
+    ponderActive = false;
+    collectInfo = false;
+}
 
-    // UCI file letters: 'a' = col 0, 'b' = col 1, 
-    // UCI rank digits: '8' = row 0 (top), '1' = row 7 (bottom)
-    int fromCol = uciStr[0] - 'a'; // 0-7
-    int fromRow = '8' - uciStr[1]; // 0-7 (e.g. '2' -> row 6)
+// Worker thread between searches: keeps ponder output flowing (and the eval
+// bar current) so the engine never blocks on a full pipe
+bool StockfishEngine::onIdle()
+{
+    if (!ponderActive.load())
+        return false;
 
-    int toCol = uciStr[2] - 'a'; 
-    int toRow = '8' - uciStr[3]; 
-    
-    // Convert board coords -> pixel positions (same layout as piece positions in Board) 
-    em.from.x = boardPosition.x + fromCol * squareSize;
-    em.from.y = boardPosition.y + fromRow * squareSize; 
-    em.to.x = boardPosition.x + toCol * squareSize; 
-    em.to.y = boardPosition.y + toRow * squareSize; 
+    std::unique_lock<std::mutex> pipeLock(pipeMutex, std::try_to_lock);
+    if (!pipeLock.owns_lock())
+        return true; // newGame() or setOption() is about to finish the ponder
+
+    if (!ponderEnabled.load() && !ponderStopSent)
+    {
+        sendCommand("stop\n");
+        ponderStopSent = true;
+    }
+
+    std::string& line = lineBuffer;
+    while (ponderActive.load())
+    {
+        PipeReader::Status status = stdoutReader.ReadLine(line, 0);
+        if (status == PipeReader::TIMEOUT)
+            break;
+        if (status == PipeReader::CLOSED || line.compare(0, 8, "bestmove") == 0)
+        {
+            ponderActive = false; // Only after stop; a ponder never ends on its own
+            collectInfo = false;
+            break;
+        }
+        if (line.compare(0, 5, "info ") == 0)
+            handleInfoLine(line);
+    }
+    return ponderActive.load();
+}
+
+void StockfishEngine::setPondering(bool enabled)
+{
+    ponderEnabled = enabled; // A running ponder is stopped by onIdle()
+}
+
+// False (and back at the standard start) if startFen does not parse
+bool StockfishEngine::resetReplay(const std::string& startFen)
+{
+    replayPosition = Position::StartPosition();
+    bool parsed = startFen.empty() || replayPosition.SetFromFEN(startFen);
+    replayStartFen = parsed ? startFen : std::string();
+    replayedMoves.clear();
+    anchorPly = 0;
+    anchorFen = replayPosition.ToFEN();
+    return parsed;
+}
 
-    // Optional promotion piece (5th character: 'q', 'r', 'b', 'n') 
-    if(uciStr.size() >=5) 
+// Brings replayPosition up to moveHistory, replaying only the new moves when
+// the history extends what was seen last time. False if a move does not parse.
+bool StockfishEngine::syncReplay(const std::string& startFen, const std::vector<std::string>& moveHistory)
+{
+    bool extendsReplay = startFen == replayStartFen && moveHistory.size() >= replayedMoves.size() &&
+                         std::equal(replayedMoves.begin(), replayedMoves.end(), moveHistory.begin());
+    if (!extendsReplay && !resetReplay(startFen))
+        return false;
+
+    for (std::size_t i = replayedMoves.size(); i < moveHistory.size(); i++)
     {
-        switch (uciStr[4]) 
+        Move move;
+        if (!replayPosition.ParseUCI(moveHistory[i], move))
+        {
+            resetReplay();
+            return false;
+        }
+        replayPosition.MakeMove(move);
+        replayedMoves.push_back(moveHistory[i]);
+
+        // Captures and pawn moves reset the halfmove clock - nothing before them can repeat
+        if (replayPosition.HalfmoveClock() == 0)
         {
-            case'q':
-                em.promotionPiece = QUEEN;
-                break; 
-            case 'r': em.promotionPiece = ROOK; break; 
-            case 'b': em.promotionPiece = BISHOP; break; 
-            case 'n': em.promotionPiece = KNIGHT; break; 
-            default: em.promotionPiece = 0; break; 
+            anchorPly = i + 1;
+            anchorFen = replayPosition.ToFEN();
         }
     }
+    return true;
+}
 
-    em.isValid = true; 
-    return em; 
+// "position fen <anchor> moves <since anchor>" - its length is bounded by the
+// 50-move rule rather than growing with the game
+const std::string& StockfishEngine::buildPositionCommand(const std::string& startFen, const std::vector<std::string>& moveHistory)
+{
+    commandBuffer.clear();
+
+    std::size_t first = 0;
+    if (syncReplay(startFen, moveHistory))
+    {
+        commandBuffer += "position fen ";
+        commandBuffer += anchorFen;
+        first = anchorPly;
+    }
+    else if (startFen.empty())
+    {
+        commandBuffer += "position startpos"; // Let the engine judge moves we could not parse
+    }
+    else
+    {
+        commandBuffer += "position fen ";
+        commandBuffer += startFen;
+    }
+
+    if (first < moveHistory.size())
+    {
+        commandBuffer += " moves";
+        for (std::size_t i = first; i < moveHistory.size(); i++)
+        {
+            commandBuffer += ' ';
+            commandBuffer += moveHistory[i];
+        }
+    }
+    commandBuffer += '\n';
+    return commandBuffer;
+}
+
+// interruptSearch() : called from the UI thread by stop() 
+void StockfishEngine::interruptSearch()
+{
+    std::lock_guard<std::mutex> lock(searchMutex);
+    if (searching)
+        sendCommand("stop\n");
 }
 
 void StockfishEngine::reset()
 {
+    cancelMove(); // Let a search still running on the worker finish first
     newGame(); // UCI "ucinewgame" resets internal state
 }
 
 void StockfishEngine::shutdown()
 {
+    stopWorker(); // The worker talks to the pipes we are about to close
+    stdoutReader.Detach();
+
 #ifdef _WIN32
     if (hChildStdinWrite != INVALID_HANDLE_VALUE)
     {
@@ -2,11 +2,17 @@
 #define STOCKFISH_ENGINE_HPP
 
 #include "ChessEngine.hpp"
+#include "PipeReader.hpp"
+#include "SearchTelemetry.hpp"
+#include "../core/Position.hpp"
+#include "../core/SeqLock.hpp"
 #include "../core/Constants.hpp"
 #include "../core/Piece.hpp"
+#include <chrono>
 #include <iostream>
 #include <sstream>
 #include <cmath>
+#include <mutex>
 
 #ifdef _WIN32
 #ifndef WIN32_LEAN_AND_MEAN
@@ -45,25 +51,106 @@ private:
     int hChildStdoutWrite;
 #endif
 
+    std::string enginePath; // Executable to launch; a bare name is looked up on PATH
+
     int skillLevel;
     int moveTimeMs;
+    int multiPv;
+
+    // stop() comes from the UI thread while search() waits for "bestmove" on
+    // the worker. The mutex makes sure "stop" is only written after "go".
+    std::mutex searchMutex;
+    bool searching;
+
+    // Engine output goes through a buffered reader; every call has a timeout
+    PipeReader stdoutReader;
+    std::atomic<uint64_t> writeCalls;
+
+    static constexpr int HANDSHAKE_TIMEOUT_MS = 10000; // uciok / readyok
+    static constexpr int BESTMOVE_GRACE_MS = 5000;     // Slack on top of movetime
+    static constexpr int PONDER_CLOCK_SLACK_MS = 100;  // Own clock may be this much below the ponder's at ponderhit
+
+    // The game replayed move by move, so the position command can start from
+    // the last capture or pawn move instead of from startpos. Nothing before
+    // that point can repeat, so the engine still sees every repetition.
+    Position replayPosition;
+    std::string replayStartFen; // Empty = standard start position
+    std::vector<std::string> replayedMoves;
+    std::size_t anchorPly;     // Moves before this are folded into anchorFen
+    std::string anchorFen;
+    std::string commandBuffer; // Reused for every position command
+
+    bool resetReplay(const std::string &startFen = std::string());
+    bool syncReplay(const std::string &startFen, const std::vector<std::string> &moveHistory);
+    const std::string &buildPositionCommand(const std::string &startFen, const std::vector<std::string> &moveHistory);
+
+    // Info lines seen while waiting for bestmove are parsed into searchInfo
+    // (worker thread) and published through infoSlot for the render loop
+    SeqLock<EngineInfo> infoSlot;
+    EngineInfo searchInfo;
+    bool collectInfo;
+    std::string lineBuffer; // Reused for every line read during a search
+
+    void handleInfoLine(const std::string &line);
+
+    // Per-search timings; goSentAt is when go (or ponderhit) was written
+    SearchTelemetry telemetry;
+    std::chrono::steady_clock::time_point goSentAt;
+    bool awaitingFirstInfo;
+
+    // Best-move stability for clock searches: how many depths in a row the
+    // first PV move has stayed the same
+    EngineInfoMove pvBest;
+    int pvDepth;
+    int pvStableDepths;
+
+    bool readBestMoveTimed(int softMs, int hardMs, std::string &line);
+
+    // Pondering: after each search the engine keeps thinking on the reply it
+    // expects. Everything that reads engine output holds pipeMutex - search()
+    // and onIdle() on the worker, newGame() and the option setters elsewhere.
+    std::mutex pipeMutex;
+    std::atomic<bool> ponderEnabled;
+    std::atomic<bool> ponderActive;
+    bool ponderStopSent;                   // Guarded by pipeMutex
+    std::string ponderStartFen;             // Position being pondered
+    std::vector<std::string> ponderHistory;
+    SearchRequest ponderLimits;             // Limits sent with go ponder
+    bool ponderWhite;                       // Side the engine plays in the ponder
+    std::atomic<uint64_t> ponderHits;
+    std::atomic<uint64_t> ponderMisses;
+
+    std::string buildGoCommand(const SearchRequest &request, bool ponder) const;
+    void startPonder(const SearchRequest &request, const SearchResult &result, int elapsedMs);
+    bool ponderLimitsMatch(const SearchRequest &request) const;
+    void finishPonder();
 
     bool sendCommand(const std::string &cmd);
-    std::string readLine();
-    std::string readUntil(const std::string &keyword);
-    EngineMove uciToEngineMove(const std::string &uciStr) const;
+    bool readUntil(const std::string &keyword, std::string &line, int timeoutMs);
 
 public:
-    StockfishEngine();
+    explicit StockfishEngine(const std::string &path = DefaultPath());
     ~StockfishEngine() override;
 
+    // CHESS_ENGINE_PATH if set (any UCI engine, e.g. tools/mockuci), else Stockfish
+    static std::string DefaultPath();
+
     bool init() override;
     void newGame() override;
     void setDifficulty(int level) override;
-    EngineMove getMove(const std::vector<std::string> &moveHistory) override;
+    void setOption(const std::string &name, const std::string &value); // UCI setoption; ends a ponder first
+    void setPondering(bool enabled) override;
+    SearchResult search(const SearchRequest &request) override;
     void reset() override;
     void shutdown() override;
     std::string getName() const override { return "Stockfish"; }
+    EngineStats getStats() const override;
+    bool getInfo(EngineInfo &out) const override;
+    const SearchTelemetry *getTelemetry() const override { return &telemetry; }
+
+protected:
+    void interruptSearch() override;
+    bool onIdle() override;
 };
 
 #endif
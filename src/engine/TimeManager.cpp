@@ -0,0 +1,54 @@
+#include "TimeManager.hpp"
+#include <algorithm>
+
+TimeBudget TimeManager::Allocate(int remainingMs, int incrementMs, int moveNumber, int legalMoves, bool inCheck) const
+{
+    TimeBudget budget;
+    int available = std::max(0, remainingMs - overheadMs);
+
+    // Only move: answer straight away
+    if (legalMoves <= 1)
+    {
+        budget.softMs = budget.hardMs = std::max(1, std::min(available, 20));
+        return budget;
+    }
+
+    // Assume 40 more moves at the start, tapering to 20 from move 30 on
+    int movesToGo = std::max(20, std::min(40, 50 - moveNumber));
+    double soft = static_cast<double>(available) / movesToGo + incrementMs * 0.75;
+
+    // Few choices (recaptures, king walks out of check) rarely need a full think
+    if (legalMoves <= 3)
+        soft *= 0.35;
+    else if (legalMoves <= 8 || inCheck)
+        soft *= 0.6;
+
+    // Up to 3x the soft limit when the main line keeps changing, but never
+    // more than a fifth of the clock (plus what the increment gives back)
+    double hard = std::min(soft * 3.0, available * 0.2 + incrementMs * 0.75);
+    hard = std::min(hard, available * 0.75);
+
+    budget.hardMs = std::max(1, static_cast<int>(hard));
+    budget.softMs = std::max(1, std::min(budget.hardMs, static_cast<int>(soft)));
+    return budget;
+}
+
+void TimeManager::Plan(SearchRequest &request, const GameClock &clock, const Position &pos) const
+{
+    if (!clock.Enabled())
+        return;
+
+    // Stockfish gets the real clocks (less our overhead) so its own time
+    // management agrees with ours; the soft/hard limits are enforced on top
+    request.wtimeMs = std::max(1, clock.RemainingMs(1) - overheadMs);
+    request.btimeMs = std::max(1, clock.RemainingMs(0) - overheadMs);
+    request.wincMs = clock.IncrementMs();
+    request.bincMs = clock.IncrementMs();
+
+    MoveList moves;
+    pos.GenerateLegalMoves(moves);
+    TimeBudget budget = Allocate(clock.RemainingMs(pos.SideToMove()), clock.IncrementMs(),
+                                 pos.FullmoveNumber(), moves.count, pos.InCheck());
+    request.softLimitMs = budget.softMs;
+    request.hardLimitMs = budget.hardMs;
+}
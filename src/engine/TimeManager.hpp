@@ -0,0 +1,34 @@
+#ifndef TIME_MANAGER_HPP
+#define TIME_MANAGER_HPP
+
+#include "SearchRequest.hpp"
+#include "../core/GameClock.hpp"
+#include "../core/Position.hpp"
+
+// TimeManager - decides how long the engine may think on a clock.
+//
+// The soft limit is the time we would like to spend: an equal share of the
+// remaining time over the moves still expected, plus most of the increment.
+// Forced or near-forced positions get a fraction of that. The hard limit is
+// the most one move may ever take, so a long think can not flag the clock.
+
+struct TimeBudget
+{
+    int softMs = 0; // Stop once the main line has settled after this
+    int hardMs = 0; // Always stop here
+};
+
+class TimeManager
+{
+public:
+    // Pipe round trip plus a frame or two before the move shows up on the board
+    int overheadMs = 60;
+
+    TimeBudget Allocate(int remainingMs, int incrementMs, int moveNumber, int legalMoves, bool inCheck) const;
+
+    // Fills the clock fields (wtime/btime/winc/binc) and soft/hard limits of
+    // request for the side to move in pos. Leaves request alone if the clock is off.
+    void Plan(SearchRequest &request, const GameClock &clock, const Position &pos) const;
+};
+
+#endif // TIME_MANAGER_HPP
@@ -4,9 +4,25 @@
 #include <iostream>
 #include <raylib.h>
 #include "raymath.h"
-#include "engine/StockfishEngine.hpp"
+#include "engine/EnginePool.hpp"
+#include "engine/CachedEngine.hpp"
+#include "engine/GameAnalyzer.hpp"
+#include "engine/TimeManager.hpp"
+#include "core/GameClock.hpp"
+#include "core/Tablebase.hpp"
+#include "core/Kpk.hpp"
+#include "core/GameJournal.hpp"
+#include "core/SavedGame.hpp"
+#include "core/OpeningExplorer.hpp"
 #include "ui/slider.hpp"
+#include "ui/explorer_panel.hpp"
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <thread>
 // #include <cstddef>
 
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
@@ -59,6 +75,7 @@ int main()
     Button whitePlayer{"resource/white.png", {0, 0}, 0.35};
     Button blackPlayer{"resource/black.png", {0, 0}, 0.35};
     Slider engineDifficultySlider({0.0f, 0.0f}, 360.0f, 1, 20, 10);
+    Slider timeControlSlider({0.0f, 0.0f}, 360.0f, 0, 30, 5); // Minutes per side, 0 = untimed
 
     bool exit = false;
 
@@ -72,46 +89,115 @@ int main()
     B1.LoadPieces();
     B1.LoadPromotionTexture();
 
+    // Endgame tables are mapped lazily from ./tablebases the first time a position needs them
+    Tablebase tablebase("tablebases");
+    B1.SetTablebase(&tablebase);
+
     // Current app state (menu navigation)
     AppState appState = MAIN_MENU;
 
-    StockfishEngine *engine = nullptr;
+    // Engine games lease a Stockfish process from the pool. The pool starts its
+    // processes in the background when the app opens and keeps them alive across
+    // games and menu visits; a returned process just gets ucinewgame.
+    // CHESS_ENGINE_POOL sets how many processes to keep warm (default half the
+    // cores, up to 4); game analysis spreads over all of them.
+    int enginePoolSize = std::max(1, std::min(4, static_cast<int>(std::thread::hardware_concurrency()) / 2));
+    if (const char *poolEnv = std::getenv("CHESS_ENGINE_POOL"))
+        enginePoolSize = std::max(1, std::min(8, std::atoi(poolEnv)));
+    EnginePool enginePool(enginePoolSize);
+    EngineLease engineLease;
+
+    // Replies are cached by position in engine_cache.bin, so openings that come
+    // up again are answered without a search (also across runs)
+    EngineCache engineCache("engine_cache.bin");
+    std::unique_ptr<CachedEngine> cachedEngine;
+    ChessEngine *engine = nullptr; // The cached engine in front of engineLease during an engine game
+
+    // Opening explorer (O during a game): what was played from the shown position
+    // in a local PGN collection, counted into a move table the first time it is opened
+    const char *explorerPgn = std::getenv("CHESS_EXPLORER_PGN");
+    OpeningExplorer openingExplorer(explorerPgn != nullptr ? explorerPgn : "openings.pgn");
+    ExplorerPanel explorerPanel;
+    bool showExplorer = false;
+
+    // "Analyze game" (A on the game-over panel) scores every position at full
+    // strength on every pool process and marks the mistakes in the move history
+    const int analysisMoveTimeMs = 500;
+    GameAnalyzer gameAnalyzer(enginePool);
+    bool gameAnalysisStarted = false;
+    std::vector<PositionEval> analysisResults;
     bool engineLaunchFailed = false;
     bool enginePlayerselect = false;
     std::string engineLaunchErrorMessage;
     std::size_t lastObservedUciMoveCount = 0;
+    std::size_t engineRequestPly = 0; // uciMoveList size the outstanding search was asked about
     bool deferEngineMoveOneFrame = false;
 
-    auto shutdownEngine = [&]()
+    // Engine games can be played on a clock (minutes from the slider, +2 s a move).
+    // The engine then gets wtime/btime and thinks for what the time manager allows.
+    const int clockIncrementMs = 2000;
+    GameClock gameClock;
+    TimeManager timeManager;
+
+    // Stockfish thinks on the player's time, on the reply it expects.
+    // CHESS_ENGINE_PONDER=0 turns that off.
+    bool enginePonder = true;
+    if (const char *ponderEnv = std::getenv("CHESS_ENGINE_PONDER"))
+        enginePonder = std::atoi(ponderEnv) != 0;
+
+    auto releaseEngine = [&]()
     {
-        if (engine != nullptr)
+        if (engineLease)
         {
-            engine->shutdown();
-            delete engine;
-            engine = nullptr;
+            EngineStats stats = engineLease->getStats();
+            if (stats.linesRead > 0)
+            {
+                std::cout << "Engine I/O: " << stats.linesRead << " lines, " << stats.bytesRead / 1024 << " KB in "
+                          << stats.readCalls << " reads + " << stats.pollCalls << " polls, "
+                          << stats.writeCalls << " writes" << std::endl;
+            }
+            if (stats.ponderHits + stats.ponderMisses > 0)
+            {
+                std::cout << "Engine ponder: " << stats.ponderHits << " hits, " << stats.ponderMisses << " misses" << std::endl;
+            }
+            const SearchTelemetry *telemetry = engineLease->getTelemetry();
+            if (telemetry != nullptr && telemetry->total.Count() > 0)
+                telemetry->Print(std::cout);
         }
+        cachedEngine.reset(); // Joins its worker before the process goes away
+        engineLease.Release(); // Cancels any search; the process goes back to the pool
+        engine = nullptr;
     };
 
     auto launchEngineGame = [&](int playerColor)
     {
         engineColor = 1 - playerColor;
 
-        shutdownEngine();
         engineLaunchFailed = false;
         engineLaunchErrorMessage.clear();
         enginePlayerselect = false;
 
         chessGameState.setGameMode(GameMode::VS_ENGINE);
+        B1.adjudicateTablebaseWins = false; // The engine plays won endings out from the tables
         if (playerColor == 0)
         {
             chessGameState.flipBoard();
         }
 
-        engine = new StockfishEngine();
-        if (!engine->init())
+        int clockMinutes = timeControlSlider.GetValue();
+        gameClock.Setup(clockMinutes * 60 * 1000, clockMinutes > 0 ? clockIncrementMs : 0);
+
+        EngineOptions options;
+        options.skillLevel = static_cast<int>(engineDifficultySlider.GetValue());
+        if (!engineLease)
+            engineLease = enginePool.Acquire(options); // Normally warm long before the click
+        if (engineLease && !cachedEngine)
+            cachedEngine.reset(new CachedEngine(engineLease.get(), engineCache));
+        engine = cachedEngine.get();
+
+        if (engine == nullptr)
         {
             std::cerr << "Failed to start Stockfish. Is stockfish.exe in project root?" << std::endl;
-            shutdownEngine();
             chessGameState.setGameMode(GameMode::PVP_LOCAL);
             appState = MAIN_MENU;
             engineLaunchFailed = true;
@@ -119,17 +205,197 @@ int main()
             return;
         }
 
-        engine->setDifficulty(engineDifficultySlider.GetValue());
-        engine->newGame();
+        engine->setDifficulty(options.skillLevel);
         appState = ENGINE_GAME;
     };
 
+    auto stopAnalysis = [&]()
+    {
+        gameAnalyzer.Cancel();
+        gameAnalysisStarted = false;
+    };
+
+    auto restartGame = [&]()
+    {
+        stopAnalysis();
+        B1.Reset();
+        if (appState != ENGINE_GAME)
+            return;
+        if (engine == nullptr)
+        {
+            launchEngineGame(1 - engineColor); // Analysis took the process back to the pool
+            return;
+        }
+        if (engineColor == 1)
+            chessGameState.flipBoard();
+        engine->reset(); // sends "ucinewgame" - reuses the process
+    };
+
+    // Live engine evaluation: a thin bar between the board and the side panel,
+    // plus score, depth and speed above the board
+    auto drawEvalBar = [&](const EngineInfo &info)
+    {
+        const float barX = 902.0f;
+        const float barY = boardPosition.y;
+        const float barW = 10.0f;
+        const float barH = 8 * squareSize;
+
+        float whiteShare = 1.0f / (1.0f + std::exp(-info.WhiteScore() / 250.0f));
+        float whiteH = barH * whiteShare;
+        bool whiteAtBottom = !chessGameState.isBoardFlipped();
+
+        DrawRectangleV({barX, barY}, {barW, barH}, Color{40, 40, 40, 255});
+        DrawRectangleV({barX, whiteAtBottom ? barY + barH - whiteH : barY}, {barW, whiteH}, RAYWHITE);
+
+        char text[24];
+        int whiteScore = info.whiteToMove ? info.score : -info.score;
+        if (info.mate)
+            std::snprintf(text, sizeof(text), "%sM%d", whiteScore < 0 ? "-" : "", std::abs(whiteScore));
+        else
+            std::snprintf(text, sizeof(text), "%+.2f", whiteScore / 100.0f);
+
+        char detail[160];
+        std::snprintf(detail, sizeof(detail), "%s   depth %d/%d   %llu kN/s", text, info.depth, info.seldepth,
+                      static_cast<unsigned long long>(info.nps / 1000));
+        int detailW = MeasureText(detail, 22);
+        DrawText(detail, 900 - detailW, 16, 22, LIGHTGRAY);
+    };
+
+    // Both clocks in the strips above and below the board, next to the side they belong to
+    auto drawClocks = [&]()
+    {
+        int topColor = chessGameState.isBoardFlipped() ? 1 : 0;
+        for (int color = 0; color <= 1; color++)
+        {
+            int ms = gameClock.RemainingMs(color);
+            char text[16];
+            if (ms < 10000)
+                std::snprintf(text, sizeof(text), "%d.%d", ms / 1000, (ms % 1000) / 100);
+            else
+                std::snprintf(text, sizeof(text), "%d:%02d", ms / 60000, (ms / 1000) % 60);
+
+            bool active = gameClock.Running() && gameClock.SideToMove() == color;
+            int y = (color == topColor) ? 12 : 968;
+            int textW = MeasureText(text, 32);
+            Color box = active ? (ms < 10000 ? MAROON : RAYWHITE) : Color{60, 60, 60, 255};
+            DrawRectangle(450 - textW / 2 - 12, y - 4, textW + 24, 40, box);
+            DrawText(text, 450 - textW / 2, y, 32, (active && ms >= 10000) ? BLACK : RAYWHITE);
+        }
+    };
+
+    // F5 saves the game in progress, F9 on the main menu picks it up again.
+    // Closing the window in the middle of a game saves it too.
+    const char *savePath = "savegame.bin";
+    bool saveAvailable = SavedGame().Load(savePath);
+
+    // Every ply of a game in progress is also journaled as it is played. A
+    // journal still there on startup belongs to a game that never ended
+    // (crash, power loss); R on the main menu resumes it.
+    const char *journalPath = "game.journal";
+    GameJournal gameJournal;
+    std::size_t journaledPlies = 0;
+    SavedGame interruptedGame;
+    bool journalAvailable = GameJournal::Recover(journalPath, interruptedGame);
+
+    auto currentGame = [&]()
+    {
+        SavedGame game;
+        game.vsEngine = appState == ENGINE_GAME;
+        game.engineColor = engineColor;
+        game.skillLevel = static_cast<int>(engineDifficultySlider.GetValue());
+        game.resignedPlayer = B1.Resigned ? B1.resignedPlayer : -1;
+        game.clockInitialMs = gameClock.InitialMs();
+        game.clockIncrementMs = gameClock.IncrementMs();
+        game.whiteClockMs = gameClock.RemainingMs(1);
+        game.blackClockMs = gameClock.RemainingMs(0);
+        game.savedAt = static_cast<int64_t>(std::time(nullptr));
+        game.uciMoves = B1.uciMoveList;
+        return game;
+    };
+
+    auto saveGame = [&]()
+    {
+        SavedGame saved = currentGame();
+        if (saved.Save(savePath))
+        {
+            saveAvailable = true;
+            std::cout << "Game saved to " << savePath << " (" << saved.uciMoves.size() << " plies)" << std::endl;
+            return true;
+        }
+        return false;
+    };
+
+    auto resumeGame = [&](const SavedGame &saved, const char *source)
+    {
+        stopAnalysis();
+        if (saved.vsEngine)
+        {
+            // Replay first: launching flips the board for black, Reset would undo it
+            chessGameState.setGameMode(GameMode::VS_ENGINE);
+            engineDifficultySlider.SetValue(saved.skillLevel);
+            B1.ReplayMoves(saved.uciMoves);
+            launchEngineGame(1 - saved.engineColor);
+            if (engineLaunchFailed)
+            {
+                B1.Reset();
+                return;
+            }
+        }
+        else
+        {
+            chessGameState.setGameMode(GameMode::PVP_LOCAL);
+            B1.adjudicateTablebaseWins = true;
+            B1.ReplayMoves(saved.uciMoves);
+            appState = GAME;
+        }
+
+        if (saved.resignedPlayer >= 0 && !B1.Checkmate && !B1.Stalemate && !B1.Adjudicated)
+        {
+            B1.Resigned = true;
+            B1.resignedPlayer = saved.resignedPlayer;
+        }
+
+        gameClock.Setup(saved.clockInitialMs, saved.clockIncrementMs);
+        if (!B1.uciMoveList.empty())
+            gameClock.Restore(saved.whiteClockMs, saved.blackClockMs, chessGameState.getCurrentPlayer());
+        lastObservedUciMoveCount = B1.uciMoveList.size();
+
+        // The resumed game gets a fresh journal, starting with the replayed moves
+        gameJournal.Close(true);
+        journaledPlies = 0;
+        std::cout << "Loaded " << source << " (" << B1.uciMoveList.size() << " plies)" << std::endl;
+    };
+
+    auto loadGame = [&]()
+    {
+        SavedGame saved;
+        if (saved.Load(savePath))
+            resumeGame(saved, savePath);
+    };
+
     auto drawHint = [&](const char *hintText, int centerX, int y, int fontSize, Color tint)
     {
         int hintWidth = MeasureText(hintText, fontSize);
         DrawText(hintText, centerX - hintWidth / 2, y, fontSize, tint);
     };
 
+    // The right-hand column: the opening explorer when it is open, else the move list
+    auto drawSidePanel = [&](float panelY, float panelHeight)
+    {
+        if (showExplorer)
+        {
+            std::size_t plies = B1.IsReviewing() ? static_cast<std::size_t>(B1.GetReviewIndex()) : B1.GetLivePlies();
+            explorerPanel.Draw(openingExplorer, B1.uciMoveList, plies, 914.0f, panelY, 380.0f, panelHeight);
+        }
+        else
+        {
+            B1.DrawMoveHistory(B1.IsReviewing() ? B1.GetReviewIndex() : -1, panelY, panelHeight);
+        }
+    };
+
+    // Spawn Stockfish while the user is still in the menu, so "play vs engine" starts instantly
+    enginePool.Start();
+
     while (!WindowShouldClose() && exit == false)
     {
         // Calculate scaling factor to fit game in window while maintaining aspect ratio
@@ -159,6 +425,13 @@ int main()
 
         if (B1.uciMoveList.size() != lastObservedUciMoveCount)
         {
+            // One more move punches the clock of the side that made it; a
+            // shorter list means the board was reset
+            if (B1.uciMoveList.size() == lastObservedUciMoveCount + 1)
+                gameClock.Press(lastObservedUciMoveCount % 2 == 0 ? 1 : 0);
+            else
+                gameClock.Reset();
+
             lastObservedUciMoveCount = B1.uciMoveList.size();
             deferEngineMoveOneFrame = true;
         }
@@ -178,13 +451,14 @@ int main()
                 float buttonsY = 420.0f;
                 float totalWidth = whiteSize.x + gap + blackSize.x;
                 float startX = (gameScreenWidth - totalWidth) / 2.0f;
-                float sliderX = (gameScreenWidth - 360.0f) / 2.0f;
+                float sliderX = (gameScreenWidth - 760.0f) / 2.0f;
                 float sliderY = 377.0f;
 
                 engineDifficultySlider.SetPosition({sliderX, sliderY});
-                sliderConsumedThisFrame = engineDifficultySlider.HandleInput(mousePosition,
-                                                                            mousePressed,
-                                                                            IsMouseButtonReleased(MOUSE_BUTTON_LEFT));
+                timeControlSlider.SetPosition({sliderX + 400.0f, sliderY});
+                bool mouseReleased = IsMouseButtonReleased(MOUSE_BUTTON_LEFT);
+                sliderConsumedThisFrame = engineDifficultySlider.HandleInput(mousePosition, mousePressed, mouseReleased);
+                sliderConsumedThisFrame |= timeControlSlider.HandleInput(mousePosition, mousePressed, mouseReleased);
 
                 whitePlayer.SetPosition({startX, buttonsY});
                 blackPlayer.SetPosition({startX + whiteSize.x + gap, buttonsY});
@@ -226,6 +500,21 @@ int main()
                 suppressMenuButtons = true;
             }
 
+            if (!engineLaunchFailed && !enginePlayerselect && !suppressMenuButtons && !engineLaunchAttemptedThisFrame &&
+                saveAvailable && IsKeyPressed(KEY_F9))
+            {
+                loadGame();
+                suppressMenuButtons = true;
+            }
+
+            if (!engineLaunchFailed && !enginePlayerselect && !suppressMenuButtons && !engineLaunchAttemptedThisFrame &&
+                journalAvailable && IsKeyPressed(KEY_R))
+            {
+                journalAvailable = false;
+                resumeGame(interruptedGame, journalPath);
+                suppressMenuButtons = true;
+            }
+
             if (!engineLaunchFailed && !enginePlayerselect && !suppressMenuButtons && !engineLaunchAttemptedThisFrame)
             {
                 startButton.SetDrawScale(0.9f);
@@ -240,6 +529,8 @@ int main()
                 {
                     std::cout << "Starting of 1v1 Game" << std::endl;
                     chessGameState.setGameMode(GameMode::PVP_LOCAL);
+                    B1.adjudicateTablebaseWins = true;
+                    gameClock.Setup(0, 0);
                     appState = GAME; // Switching to the game state
                 }
 
@@ -260,23 +551,41 @@ int main()
 
         if (appState == GAME || appState == ENGINE_GAME)
         {
-            if (IsKeyPressed(KEY_SPACE) && !B1.Checkmate && !B1.Stalemate)
+            if (IsKeyPressed(KEY_SPACE) && !B1.Checkmate && !B1.Stalemate && !B1.Adjudicated)
             {
                 Paused = !Paused;
             }
 
             // Toggle valid move highlights with 'M' key
-            if (IsKeyPressed(KEY_M) && !Paused && !B1.Checkmate && !B1.Stalemate)
+            if (IsKeyPressed(KEY_M) && !Paused && !B1.Checkmate && !B1.Stalemate && !B1.Adjudicated)
             {
                 B1.ToggleShowValidMoves();
             }
 
             //  The trigger key can be changed later
-            if (IsKeyPressed(KEY_H) && !Paused && !B1.Checkmate && !B1.Stalemate)
+            if (IsKeyPressed(KEY_H) && !Paused && !B1.Checkmate && !B1.Stalemate && !B1.Adjudicated)
             {
                 B1.showMoveHistory = !B1.showMoveHistory;
             }
 
+            // The opening explorer takes the move list's place while it is open
+            if (IsKeyPressed(KEY_O))
+            {
+                showExplorer = !showExplorer;
+                openingExplorer.Start();
+            }
+
+            if (IsKeyPressed(KEY_F5) && !B1.uciMoveList.empty())
+            {
+                saveGame();
+            }
+
+            // Dump the engine's search latencies so far to stdout
+            if (IsKeyPressed(KEY_T) && engine != nullptr && engine->getTelemetry() != nullptr)
+            {
+                engine->getTelemetry()->Print(std::cout);
+            }
+
             // Review arrow keys with long-press acceleration
             bool leftDown = IsKeyDown(KEY_LEFT);
             bool rightDown = IsKeyDown(KEY_RIGHT);
@@ -317,15 +626,17 @@ int main()
             }
             reviewRightWasDown = rightDown;
 
-            if (!B1.IsReviewing() && !B1.Checkmate && !B1.Stalemate && !B1.Resigned && resignButton.isPressed(mousePosition, mousePressed))
+            if (!B1.IsReviewing() && !B1.Checkmate && !B1.Stalemate && !B1.Resigned && !B1.Adjudicated && resignButton.isPressed(mousePosition, mousePressed))
             {
                 B1.Resigned = true;
                 B1.resignedPlayer = chessGameState.getCurrentPlayer();
+                if (engine != nullptr)
+                    engine->cancelMove(); // Stops the search now instead of waiting out movetime
                 mousePressed = false; // Consume click so it doesn't also trigger exit button
             }
         }
 
-        if ((appState == GAME || appState == ENGINE_GAME) && (B1.Checkmate || B1.Stalemate || B1.Resigned) && !Paused)
+        if ((appState == GAME || appState == ENGINE_GAME) && (B1.Checkmate || B1.Stalemate || B1.Resigned || B1.Adjudicated) && !Paused)
         {
             // position buttons in the size panel
             restartButton.SetDrawScale(0.70f);
@@ -338,27 +649,31 @@ int main()
 
             if (restartButton.isPressed(mousePosition, mousePressed))
             {
-                B1.Reset();
-                if (appState == ENGINE_GAME && engineColor == 1)
-                    chessGameState.flipBoard();
-                if (engine != nullptr)
-                    engine->reset(); // sends "ucinewgame" - reuses the process
+                restartGame();
             }
             if (menuButton.isPressed(mousePosition, mousePressed))
             {
+                stopAnalysis();
                 B1.Reset();
                 appState = MAIN_MENU;
-                if (engine != nullptr)
-                {
-                    engine->shutdown();
-                    delete engine;
-                    engine = nullptr; // null so that we don't call getmove in a dead engine
-                }
+                releaseEngine(); // The process stays warm in the pool for the next game
             }
             if (exitButton.isPressed(mousePosition, mousePressed))
             {
                 exit = true;
             }
+
+            // The game's own engine is done with; hand it to the analysis too
+            if (IsKeyPressed(KEY_A) && !gameAnalysisStarted && !B1.uciMoveList.empty())
+            {
+                releaseEngine();
+                EngineOptions analysisOptions; // Full strength
+                if (gameAnalyzer.Start(B1.uciMoveList, analysisMoveTimeMs, analysisOptions))
+                {
+                    gameAnalysisStarted = true;
+                    B1.SetAnalysisProgress(0, gameAnalyzer.Total());
+                }
+            }
         }
 
         if ((appState == GAME || appState == ENGINE_GAME) && Paused)
@@ -379,24 +694,16 @@ int main()
 
             if (restartButton.isPressed(mousePosition, mousePressed))
             {
-                B1.Reset();
-                if (appState == ENGINE_GAME && engineColor == 1)
-                    chessGameState.flipBoard();
-                if (engine != nullptr)
-                    engine->reset();
+                restartGame();
 
                 Paused = !Paused;
             }
             if (menuButton.isPressed(mousePosition, mousePressed))
             {
+                stopAnalysis();
                 B1.Reset();
                 appState = MAIN_MENU;
-                if (engine != nullptr)
-                {
-                    engine->shutdown();
-                    delete engine;
-                    engine = nullptr;
-                }
+                releaseEngine();
                 Paused = !Paused;
             }
             if (exitButton.isPressed(mousePosition, mousePressed))
@@ -405,6 +712,53 @@ int main()
             }
         }
 
+        // Clocks only run while an engine game is actually being played
+        bool gameFinished = B1.Checkmate || B1.Stalemate || B1.Resigned || B1.Adjudicated;
+        gameClock.SetRunning(appState == ENGINE_GAME && !Paused && !gameFinished);
+        if (engine != nullptr)
+            engine->setPondering(enginePonder && appState == ENGINE_GAME && !gameFinished);
+
+        if (gameAnalysisStarted)
+        {
+            analysisResults.clear();
+            gameAnalyzer.TakeResults(analysisResults);
+            for (const PositionEval &eval : analysisResults)
+                B1.SetPositionEval(eval);
+            B1.SetAnalysisProgress(gameAnalyzer.Done(), gameAnalyzer.Total());
+        }
+
+        int flaggedColor;
+        if (appState == ENGINE_GAME && !gameFinished && gameClock.Flagged(flaggedColor))
+        {
+            B1.AdjudicateTimeout(flaggedColor);
+            if (engine != nullptr)
+                engine->cancelMove();
+        }
+
+        // Journal each finished ply of the game being played. The journal goes
+        // once the game is over or the board is reset, so only an interrupted
+        // game leaves one behind.
+        gameFinished = B1.Checkmate || B1.Stalemate || B1.Resigned || B1.Adjudicated;
+        std::size_t livePlies = B1.GetLivePlies();
+        if ((appState == GAME || appState == ENGINE_GAME) && !gameFinished && livePlies > journaledPlies)
+        {
+            if (!gameJournal.IsOpen())
+            {
+                gameJournal.Open(journalPath, currentGame());
+                journalAvailable = false;
+            }
+            for (; journaledPlies < livePlies; journaledPlies++)
+            {
+                gameJournal.Append(B1.uciMoveList[journaledPlies], gameClock.RemainingMs(1), gameClock.RemainingMs(0),
+                                   B1.GetPositionKey(journaledPlies + 1));
+            }
+        }
+        else if (gameJournal.IsOpen() && (gameFinished || livePlies < journaledPlies))
+        {
+            gameJournal.Close(false);
+            journaledPlies = 0;
+        }
+
         // Draw everything to the render texture at fixed resolution
         BeginTextureMode(target);
         ClearBackground(BLACK);
@@ -442,6 +796,11 @@ int main()
             engineButton.DrawWithHover(mousePosition);
             exitButton.DrawWithHover(mousePosition);
 
+            if (journalAvailable)
+                drawHint("Press R to resume the interrupted game", panelX + panelW / 2, panelY + panelH - (saveAvailable ? 70 : 45), 20, MAROON);
+            if (saveAvailable)
+                drawHint("Press F9 to continue the saved game", panelX + panelW / 2, panelY + panelH - 45, 20, BROWN);
+
             if (enginePlayerselect)
             {
                 DrawRectangle(0, 0, gameScreenWidth, gameScreenHeight, Fade(BLACK, 0.35f));
@@ -464,6 +823,7 @@ int main()
                 DrawText(subtitle, panelX + (panelWidth - subtitleWidth) / 2, panelY + 70, subtitleSize, LIGHTGRAY);
 
                 engineDifficultySlider.Draw("Engine difficulty");
+                timeControlSlider.Draw("Minutes +2s (0 = off)");
 
                 Vector2 whiteSize = whitePlayer.GetSize();
                 Vector2 blackSize = blackPlayer.GetSize();
@@ -552,7 +912,7 @@ int main()
 
                 // Side panel
                 DrawRectangle(914, 55, sidePanelWidth + 180, 910, BROWN);
-                bool gameOver = B1.Checkmate || B1.Stalemate || B1.Resigned;
+                bool gameOver = B1.Checkmate || B1.Stalemate || B1.Resigned || B1.Adjudicated;
                 if (!gameOver)
                 {
                     B1.DrawPlayer();
@@ -560,6 +920,27 @@ int main()
 
                 B1.DrawPieces();
 
+                if (appState == ENGINE_GAME && gameClock.Enabled())
+                    drawClocks();
+
+                EngineInfo engineInfo;
+                if (appState == ENGINE_GAME && engine != nullptr && !gameOver && engine->getInfo(engineInfo))
+                {
+                    drawEvalBar(engineInfo);
+
+                    // While the engine thinks, show where its main line is heading
+                    if (engine->isThinking() && !B1.IsReviewing())
+                    {
+                        int shown = std::min(engineInfo.pvLength, 3);
+                        for (int i = shown - 1; i >= 0; i--)
+                        {
+                            unsigned char alpha = static_cast<unsigned char>(170 - 45 * i);
+                            Color arrowColor = (i % 2 == 0) ? Color{40, 120, 220, alpha} : Color{220, 90, 40, alpha};
+                            B1.DrawMoveArrow(engineInfo.pv[i].from, engineInfo.pv[i].to, arrowColor);
+                        }
+                    }
+                }
+
                 if (B1.PawnPromo)
                 {
                     int windowWidth = gameScreenWidth;   // Virtual window width
@@ -659,9 +1040,45 @@ int main()
                     exitButton.DrawWithHover(mousePosition);
                 }
 
+                else if (B1.Adjudicated)
+                {
+                    const char *title = B1.adjudicatedOnTime ? "TIME OUT"
+                                        : (B1.adjudicatedWinner == -1) ? "DRAW" : "TABLEBASE WIN";
+                    const char *detail = (B1.adjudicatedWinner == -1)
+                                             ? (B1.adjudicatedOnTime ? "Draw - no mating material" : "Tablebase draw")
+                                             : (B1.adjudicatedWinner == 1 ? "White Wins!" : "Black Wins!");
+                    switch (chessGameState.getPhase())
+                    {
+                    case GamePhase::REPETITION_DRAW: detail = "Threefold repetition"; break;
+                    case GamePhase::FIFTY_MOVE_DRAW: detail = "50-move rule"; break;
+                    case GamePhase::INSUFFICIENT_MATERIAL_DRAW: detail = "Insufficient material"; break;
+                    default: break;
+                    }
+                    Color accent = {120, 170, 220, 220};
+
+                    DrawRectangleRounded({922, 70, 364, 180}, 0.06f, 8, Fade(BLACK, 0.55f));
+                    DrawRectangleRoundedLines({922, 70, 364, 180}, 0.06f, 8, Fade(RAYWHITE, 0.15f));
+                    DrawRectangleRounded({932, 80, 344, 4}, 0.5f, 4, accent);
+
+                    int titleW = MeasureText(title, 32);
+                    DrawText(title, 1104 - titleW / 2, 110, 32, RAYWHITE);
+                    int detailW = MeasureText(detail, 24);
+                    DrawText(detail, 1104 - detailW / 2, 165, 24, BEIGE);
+
+                    restartButton.SetDrawScale(0.70f);
+                    menuButton.SetDrawScale(0.70f);
+                    exitButton.SetDrawScale(0.70f);
+
+                    Button::UpdateThreeButtonPositionsInPanel(restartButton,
+                                                       menuButton, exitButton, 914.0f, 380.0f, 320.0f);
+                    restartButton.DrawWithHover(mousePosition);
+                    menuButton.DrawWithHover(mousePosition);
+                    exitButton.DrawWithHover(mousePosition);
+                }
+
             else
                 {    
-                    B1.DrawMoveHistory(B1.IsReviewing() ? B1.GetReviewIndex() : -1);
+                    drawSidePanel(55.0f, 910.0f);
                     if (!B1.IsReviewing())
                     {
                         resignButton.SetDrawScale(1.0f);
@@ -672,23 +1089,54 @@ int main()
                         B1.UpdateDragging();
                         B1.HandleClickToMove();
                     }
-                    if (!B1.IsReviewing() && appState == ENGINE_GAME && engine != nullptr && !B1.Checkmate && !B1.Stalemate && !B1.PawnPromo && !B1.Resigned && !Paused && chessGameState.getCurrentPlayer() == engineColor)
+                    if (!B1.IsReviewing() && appState == ENGINE_GAME && engine != nullptr && !B1.Checkmate && !B1.Stalemate && !B1.PawnPromo && !B1.Resigned && !B1.Adjudicated && !Paused && chessGameState.getCurrentPlayer() == engineColor)
                     {
                         if (deferEngineMoveOneFrame)
                         {
                             deferEngineMoveOneFrame = false;
                         }
-                        else
+                        else if (engine->isThinking())
                         {
-                            EngineMove em = engine->getMove(B1.uciMoveList);
-                            if (em.isValid)
+                            // The search runs on the engine thread; pick the move up once it lands
+                            EngineMove em;
+                            if (engine->pollMove(em) && em.isValid && B1.uciMoveList.size() == engineRequestPly)
                             {
                                 B1.ApplyEngineMove(em);
                             }
                         }
+                        else
+                        {
+                            // Tablebase positions (and won KPK pushes) are answered locally, no engine round trip
+                            Move tablebaseMove;
+                            if (tablebase.BestMove(B1.GetLivePosition(), tablebaseMove) ||
+                                Kpk::FindWinningPush(B1.GetLivePosition(), tablebaseMove))
+                            {
+                                B1.ApplyUciMove(Position::ToUCI(tablebaseMove));
+                            }
+                            else
+                            {
+                                SearchRequest request;
+                                request.moveHistory = B1.uciMoveList;
+                                timeManager.Plan(request, gameClock, B1.GetLivePosition());
+                                if (engine->requestMove(request))
+                                    engineRequestPly = B1.uciMoveList.size();
+                            }
+                        }
                     }
 
                 }
+
+                // Below the game-over buttons: the move list, with analysis once asked for
+                if (gameOver && !B1.PawnPromo)
+                {
+                    float historyY = 320.0f + 3 * (restartButton.GetSize().y + 10.0f) + 10.0f;
+                    if (!gameAnalysisStarted)
+                    {
+                        drawHint("Press A to analyze the game", 1104, static_cast<int>(historyY), 22, RAYWHITE);
+                        historyY += 34.0f;
+                    }
+                    drawSidePanel(historyY, 965.0f - historyY);
+                }
             }
         }
 
@@ -706,8 +1154,36 @@ int main()
         EndDrawing();
     }
 
+    // Once a game still in progress is in savegame.bin its journal can go
+    if ((appState == GAME || appState == ENGINE_GAME) && !B1.uciMoveList.empty() && saveGame())
+        gameJournal.Close(false);
+
+    TablebaseStats tbStats = tablebase.Stats();
+    if (tbStats.probes > 0)
+    {
+        std::cout << "Tablebase: " << tbStats.probes << " probes, " << tbStats.hits << " hits, "
+                  << tbStats.tablesMapped << " tables mapped (" << tbStats.bytesMapped / 1024 << " KB)" << std::endl;
+    }
+
+    releaseEngine();
+    EngineCacheStats cacheStats = engineCache.Stats();
+    if (cacheStats.lookups > 0)
+    {
+        std::cout << "Engine cache: " << cacheStats.hits << "/" << cacheStats.lookups << " hits ("
+                  << static_cast<int>(cacheStats.HitRate() * 100) << "%), " << cacheStats.entries << "/"
+                  << cacheStats.capacity << " entries" << (cacheStats.persistent ? "" : " (memory only)") << std::endl;
+    }
+
+    EnginePoolStats poolStats = enginePool.Stats();
+    if (poolStats.acquires > 0)
+    {
+        std::cout << "Engine pool: " << poolStats.running << "/" << poolStats.size << " running, "
+                  << poolStats.acquires << " leases, " << poolStats.waits << " waited (max "
+                  << static_cast<int>(poolStats.maxWaitMs) << " ms), "
+                  << static_cast<int>(poolStats.utilization * 100) << "% utilization" << std::endl;
+    }
+
     // Unloading textures and closing the window
-    shutdownEngine();
     UnloadRenderTexture(target);
     UnloadTexture(boardTexture);
 
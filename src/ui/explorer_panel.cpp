@@ -0,0 +1,113 @@
+#include "explorer_panel.hpp"
+#include <algorithm>
+
+void ExplorerPanel::Follow(const std::vector<std::string> &uciMoves, std::size_t plies)
+{
+    plies = std::min(plies, uciMoves.size());
+    bool extends = shownMoves.size() <= plies && std::equal(shownMoves.begin(), shownMoves.end(), uciMoves.begin());
+    if (extends && shownMoves.size() == plies)
+        return;
+
+    // Moving forward plays the new moves; anything else replays from the start
+    if (!extends)
+    {
+        shown = Position::StartPosition();
+        shownMoves.clear();
+    }
+    while (shownMoves.size() < plies)
+    {
+        Move move;
+        if (!shown.ParseUCI(uciMoves[shownMoves.size()], move))
+            break;
+        shown.MakeMove(move);
+        shownMoves.push_back(uciMoves[shownMoves.size()]);
+    }
+    scrollOffset = 0;
+}
+
+void ExplorerPanel::Draw(OpeningExplorer &explorer, const std::vector<std::string> &uciMoves, std::size_t plies,
+                         float panelX, float panelY, float panelWidth, float panelHeight)
+{
+    const int titleSize = 35;
+    const int fontSize = 25;
+    const int smallSize = 20;
+    const int lineHeight = 34;
+    const int innerX = static_cast<int>(panelX + 12.0f);
+    const int gamesX = static_cast<int>(panelX + 120.0f);
+    const int scoreX = static_cast<int>(panelX + 215.0f);
+    const int barX = static_cast<int>(panelX + 285.0f);
+    const int barWidth = static_cast<int>(panelWidth) - (barX - static_cast<int>(panelX)) - 12;
+    const float contentTop = panelY + 90.0f;
+    const float contentBottom = panelY + panelHeight - 16.0f - lineHeight;
+    const int maxVisible = std::max(0, static_cast<int>((contentBottom - contentTop) / lineHeight));
+
+    DrawRectangle(static_cast<int>(panelX), static_cast<int>(panelY),
+                  static_cast<int>(panelWidth), static_cast<int>(panelHeight), Fade(BEIGE, 0.92f));
+    DrawRectangleLines(static_cast<int>(panelX), static_cast<int>(panelY),
+                       static_cast<int>(panelWidth), static_cast<int>(panelHeight), BLACK);
+    DrawText("Openings", innerX, static_cast<int>(panelY + 10), titleSize, BLACK);
+
+    ExplorerState state = explorer.State();
+    if (state == ExplorerState::UNAVAILABLE)
+    {
+        std::string where = "No games in " + explorer.PgnPath();
+        DrawText(where.c_str(), innerX, static_cast<int>(panelY + 60), smallSize, GRAY);
+        DrawText("Set CHESS_EXPLORER_PGN to a PGN file", innerX, static_cast<int>(panelY + 60 + lineHeight), smallSize, GRAY);
+        return;
+    }
+
+    Follow(uciMoves, plies);
+    if (const ExplorerResult *found = explorer.Find(shown))
+    {
+        if (!hasResult || result.key != found->key)
+            result = *found;
+        hasResult = true;
+    }
+
+    if (state == ExplorerState::BUILDING)
+    {
+        std::string progress = "Reading games... " + std::to_string(explorer.GamesCounted());
+        DrawText(progress.c_str(), innerX, static_cast<int>(panelY + 60), smallSize, GRAY);
+        return;
+    }
+    if (!hasResult)
+        return;
+
+    bool stale = result.key != shown.Key();
+    if (result.moves.empty())
+    {
+        DrawText(stale ? "..." : "Not in the collection", innerX, static_cast<int>(panelY + 60), smallSize, GRAY);
+        return;
+    }
+
+    DrawText("Move", innerX, static_cast<int>(panelY + 58), smallSize, DARKGRAY);
+    DrawText("Games", gamesX, static_cast<int>(panelY + 58), smallSize, DARKGRAY);
+    DrawText("Score", scoreX, static_cast<int>(panelY + 58), smallSize, DARKGRAY);
+
+    const int maxScroll = std::max(0, static_cast<int>(result.moves.size()) - maxVisible);
+    if (CheckCollisionPointRec(GetMousePosition(), {panelX, panelY, panelWidth, panelHeight}))
+        scrollOffset -= static_cast<int>(GetMouseWheelMove());
+    scrollOffset = std::max(0, std::min(scrollOffset, maxScroll));
+
+    // Until the new position's moves arrive the old ones are shown greyed out
+    Color textColor = stale ? GRAY : BLACK;
+    int y = static_cast<int>(contentTop);
+    int end = std::min(static_cast<int>(result.moves.size()), scrollOffset + maxVisible);
+    for (int i = scrollOffset; i < end; i++, y += lineHeight)
+    {
+        const ExplorerMove &move = result.moves[i];
+        DrawText(move.san.c_str(), innerX, y, fontSize, textColor);
+        DrawText(TextFormat("%u", move.games), gamesX, y, fontSize, textColor);
+        DrawText(TextFormat("%d%%", static_cast<int>(move.Score(result.sideToMove) + 0.5)), scoreX, y, fontSize, textColor);
+
+        int whiteW = static_cast<int>(barWidth * static_cast<double>(move.whiteWins) / move.games);
+        int drawW = static_cast<int>(barWidth * static_cast<double>(move.draws) / move.games);
+        DrawRectangle(barX, y + 4, barWidth, fontSize - 8, DARKGRAY);
+        DrawRectangle(barX, y + 4, whiteW, fontSize - 8, RAYWHITE);
+        DrawRectangle(barX + whiteW, y + 4, drawW, fontSize - 8, GRAY);
+        DrawRectangleLines(barX, y + 4, barWidth, fontSize - 8, BLACK);
+    }
+
+    std::string total = std::to_string(result.games) + " games";
+    DrawText(total.c_str(), innerX, static_cast<int>(contentBottom + 8), smallSize, DARKGRAY);
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <raylib.h>
+#include <string>
+#include <vector>
+#include "../core/OpeningExplorer.hpp"
+
+// Side panel listing the continuations of the shown position from the
+// opening explorer: move, games and the mover's score, with a white / draw /
+// black bar. The previous position's moves stay up until the new ones arrive.
+class ExplorerPanel
+{
+private:
+    Position shown = Position::StartPosition();
+    std::vector<std::string> shownMoves; // Moves that lead to shown
+    ExplorerResult result;
+    bool hasResult = false;
+    int scrollOffset = 0;
+
+    void Follow(const std::vector<std::string> &uciMoves, std::size_t plies);
+
+public:
+    // plies: how many of uciMoves lead to the position to show
+    void Draw(OpeningExplorer &explorer, const std::vector<std::string> &uciMoves, std::size_t plies,
+              float panelX, float panelY, float panelWidth, float panelHeight);
+};
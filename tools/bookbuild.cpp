@@ -0,0 +1,428 @@
+// bookbuild - builds a Polyglot opening book (.bin) from PGN archives.
+//
+// A reader thread streams games out of the PGN files and hands them to worker
+// threads in batches. Each worker replays its games and counts every
+// (position key, move) pair, once per game, in its own hash map. When a map grows past the
+// memory budget it is sorted and spilled to disk as a run file, so memory stays
+// bounded no matter how many games are processed. At the end all runs are
+// combined with a k-way merge (core/SortedRuns) and written out as sorted
+// Polyglot entries.
+//
+// Usage: bookbuild [options] -o book.bin games1.pgn [games2.pgn ...]
+
+#include "core/Position.hpp"
+#include "core/Pgn.hpp"
+#include "core/SortedRuns.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+
+struct Options
+{
+    std::string outputPath;
+    std::vector<std::string> inputs;
+    int threads = 0;         // 0 = hardware concurrency
+    int minGames = 1;        // Drop moves seen in fewer games than this
+    int maxPly = 40;         // Only record the first maxPly half-moves of each game
+    std::size_t memoryMb = 512;
+};
+
+// Key used in the per-thread maps and in run files
+struct BookKey
+{
+    uint64_t key;
+    uint16_t move;
+
+    bool operator==(const BookKey &other) const { return key == other.key && move == other.move; }
+    bool operator<(const BookKey &other) const { return key != other.key ? key < other.key : move < other.move; }
+};
+
+struct BookKeyHash
+{
+    std::size_t operator()(const BookKey &k) const
+    {
+        return static_cast<std::size_t>(k.key ^ (static_cast<uint64_t>(k.move) * 0x9E3779B97F4A7C15ULL));
+    }
+};
+
+struct BookCounts
+{
+    uint32_t games = 0;
+    uint32_t points = 0; // 2 per win, 1 per draw, from the mover's point of view
+};
+
+struct RunRecord
+{
+    BookKey id;
+    BookCounts counts;
+
+    bool operator<(const RunRecord &other) const { return id < other.id; }
+};
+
+typedef SortedRuns<RunRecord> BookRuns;
+
+// Rough per-entry cost of an unordered_map node, used to turn the memory
+// budget into an entry limit
+constexpr std::size_t bytesPerEntry = 64;
+constexpr std::size_t gamesPerBatch = 256;
+
+// Bounded hand-off between the reader and the workers. The bound is what keeps
+// the reader from pulling a whole archive into memory ahead of the workers.
+class BatchQueue
+{
+private:
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::deque<std::vector<PgnGame>> batches;
+    std::size_t capacity;
+    bool closed = false;
+
+public:
+    explicit BatchQueue(std::size_t cap) : capacity(cap) {}
+
+    void Push(std::vector<PgnGame> &&batch)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [&] { return batches.size() < capacity; });
+        batches.push_back(std::move(batch));
+        notEmpty.notify_one();
+    }
+
+    bool Pop(std::vector<PgnGame> &batch)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [&] { return !batches.empty() || closed; });
+        if (batches.empty())
+            return false;
+        batch = std::move(batches.front());
+        batches.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void Close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+    }
+};
+
+struct Stats
+{
+    std::atomic<uint64_t> games{0};
+    std::atomic<uint64_t> badGames{0};
+    std::atomic<uint64_t> positions{0};
+};
+
+bool SpillRun(std::unordered_map<BookKey, BookCounts, BookKeyHash> &map, BookRuns &runs)
+{
+    std::vector<RunRecord> records;
+    records.reserve(map.size());
+    for (const auto &entry : map)
+        records.push_back({entry.first, entry.second});
+    map.clear();
+    return runs.Spill(records);
+}
+
+// Score of the game for the side to move: 2 = win, 1 = draw, 0 = loss
+int ScoreFor(const std::string &result, int sideToMove)
+{
+    if (result == "1-0")
+        return sideToMove == 1 ? 2 : 0;
+    if (result == "0-1")
+        return sideToMove == 0 ? 2 : 0;
+    return 1;
+}
+
+void WorkerMain(BatchQueue &queue, BookRuns &runs, Stats &stats, const Options &opts,
+                std::size_t maxEntries, std::atomic<bool> &failed)
+{
+    std::unordered_map<BookKey, BookCounts, BookKeyHash> counts;
+    counts.reserve(std::min<std::size_t>(maxEntries, 1 << 20));
+
+    // Pairs seen in the current game since its last capture or pawn move.
+    // A position cannot come back past one of those, so this is all that is
+    // needed to count a transposition inside one game only once.
+    std::vector<BookKey> recent;
+
+    std::vector<PgnGame> batch;
+    while (queue.Pop(batch))
+    {
+        for (const PgnGame &game : batch)
+        {
+            if (game.result != "1-0" && game.result != "0-1" && game.result != "1/2-1/2")
+            {
+                stats.badGames++;
+                continue;
+            }
+
+            Position pos = Position::StartPosition();
+            std::string fen = game.Tag("FEN");
+            if (!fen.empty() && !pos.SetFromFEN(fen))
+            {
+                stats.badGames++;
+                continue;
+            }
+
+            int ply = 0;
+            recent.clear();
+            for (const std::string &san : game.moves)
+            {
+                if (ply >= opts.maxPly)
+                    break;
+
+                Move move;
+                if (!pos.ParseSAN(san.c_str(), move))
+                {
+                    stats.badGames++;
+                    break; // Keep what was recorded before the bad move
+                }
+
+                BookKey id{pos.Key(), pos.ToPolyglotMove(move)};
+                if (std::find(recent.begin(), recent.end(), id) == recent.end())
+                {
+                    BookCounts &entry = counts[id];
+                    entry.games++;
+                    entry.points += ScoreFor(game.result, pos.SideToMove());
+                    recent.push_back(id);
+                }
+
+                pos.MakeMove(move);
+                if (pos.HalfmoveClock() == 0)
+                    recent.clear();
+                ply++;
+            }
+
+            stats.games++;
+            stats.positions += ply;
+        }
+
+        if (counts.size() >= maxEntries && !SpillRun(counts, runs))
+            failed = true;
+    }
+
+    if (!SpillRun(counts, runs))
+        failed = true;
+}
+
+void PutBigEndian(unsigned char *out, uint64_t value, int bytes)
+{
+    for (int i = bytes - 1; i >= 0; i--)
+    {
+        out[i] = static_cast<unsigned char>(value & 0xFF);
+        value >>= 8;
+    }
+}
+
+// Write all moves of one position. Weights are 2 * wins + draws, scaled down
+// when a popular position would overflow Polyglot's 16-bit weight field.
+std::size_t WritePosition(std::FILE *out, std::vector<RunRecord> &group, int minGames)
+{
+    group.erase(std::remove_if(group.begin(), group.end(), [&](const RunRecord &r)
+                               { return r.counts.games < static_cast<uint32_t>(minGames) || r.counts.points == 0; }),
+                group.end());
+    if (group.empty())
+        return 0;
+
+    std::sort(group.begin(), group.end(), [](const RunRecord &a, const RunRecord &b)
+              { return a.counts.points > b.counts.points; });
+
+    uint32_t maxPoints = group.front().counts.points;
+    double scale = maxPoints > 0xFFFF ? 65535.0 / maxPoints : 1.0;
+
+    std::size_t written = 0;
+    for (const RunRecord &r : group)
+    {
+        uint32_t weight = static_cast<uint32_t>(r.counts.points * scale);
+        if (weight == 0)
+            continue;
+
+        unsigned char entry[16];
+        PutBigEndian(entry, r.id.key, 8);
+        PutBigEndian(entry + 8, r.id.move, 2);
+        PutBigEndian(entry + 10, weight, 2);
+        PutBigEndian(entry + 12, 0, 4); // learn field, unused
+        if (std::fwrite(entry, sizeof(entry), 1, out) == 1)
+            written++;
+    }
+    return written;
+}
+
+// Merges the runs into the book. The same (key, move) from different runs is
+// summed, and each position's moves are written together.
+bool MergeRuns(BookRuns &runs, const Options &opts, std::size_t &entriesWritten)
+{
+    std::FILE *out = std::fopen(opts.outputPath.c_str(), "wb");
+    if (out == nullptr)
+    {
+        std::cerr << "bookbuild: cannot create " << opts.outputPath << std::endl;
+        return false;
+    }
+
+    std::vector<RunRecord> group;
+    entriesWritten = 0;
+    bool ok = runs.Merge([&](const RunRecord &r)
+                         {
+                             if (!group.empty() && group.back().id == r.id)
+                             {
+                                 group.back().counts.games += r.counts.games;
+                                 group.back().counts.points += r.counts.points;
+                                 return true;
+                             }
+                             if (!group.empty() && group.back().id.key != r.id.key)
+                             {
+                                 entriesWritten += WritePosition(out, group, opts.minGames);
+                                 group.clear();
+                             }
+                             group.push_back(r);
+                             return true;
+                         });
+    entriesWritten += WritePosition(out, group, opts.minGames);
+
+    if (std::fclose(out) != 0 || !ok)
+    {
+        std::cerr << "bookbuild: failed writing " << opts.outputPath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void PrintUsage()
+{
+    std::cout << "Usage: bookbuild [options] -o book.bin games.pgn [more.pgn ...]\n"
+              << "  -o PATH          output Polyglot book\n"
+              << "  --threads N      worker threads (default: all cores)\n"
+              << "  --min-games N    drop moves played in fewer than N games (default 1)\n"
+              << "  --max-ply N      only record the first N half-moves (default 40)\n"
+              << "  --memory MB      memory budget for in-memory counts (default 512)\n";
+}
+
+bool ParseArgs(int argc, char **argv, Options &opts)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "-o" && hasValue)
+            opts.outputPath = argv[++i];
+        else if (arg == "--threads" && hasValue)
+            opts.threads = std::atoi(argv[++i]);
+        else if (arg == "--min-games" && hasValue)
+            opts.minGames = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--max-ply" && hasValue)
+            opts.maxPly = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--memory" && hasValue)
+            opts.memoryMb = static_cast<std::size_t>(std::max(16, std::atoi(argv[++i])));
+        else if (arg == "-h" || arg == "--help")
+            return false;
+        else if (!arg.empty() && arg[0] == '-')
+        {
+            std::cerr << "bookbuild: unknown option " << arg << std::endl;
+            return false;
+        }
+        else
+            opts.inputs.push_back(arg);
+    }
+    return !opts.outputPath.empty() && !opts.inputs.empty();
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options opts;
+    if (!ParseArgs(argc, argv, opts))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    // A book keyed with anything but the standard table is unreadable by other Polyglot tools
+    if (Position::StartPosition().Key() != POLYGLOT_START_KEY)
+    {
+        std::cerr << "bookbuild: position keys do not match the Polyglot table" << std::endl;
+        return 1;
+    }
+
+    if (opts.threads <= 0)
+        opts.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    const auto startTime = std::chrono::steady_clock::now();
+    const std::size_t maxEntries = std::max<std::size_t>(
+        1024, opts.memoryMb * 1024 * 1024 / bytesPerEntry / static_cast<std::size_t>(opts.threads));
+
+    BatchQueue queue(static_cast<std::size_t>(opts.threads) * 2);
+    BookRuns runs(opts.outputPath);
+    Stats stats;
+    std::atomic<bool> failed(false);
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < opts.threads; i++)
+        workers.emplace_back(WorkerMain, std::ref(queue), std::ref(runs), std::ref(stats),
+                             std::cref(opts), maxEntries, std::ref(failed));
+
+    // Reader runs on the main thread
+    PgnReader reader;
+    for (const std::string &path : opts.inputs)
+    {
+        if (!reader.Open(path))
+        {
+            std::cerr << "bookbuild: cannot open " << path << std::endl;
+            failed = true;
+            continue;
+        }
+
+        std::vector<PgnGame> batch(gamesPerBatch);
+        std::size_t filled = 0;
+        while (reader.NextGame(batch[filled]))
+        {
+            if (++filled == gamesPerBatch)
+            {
+                queue.Push(std::move(batch));
+                batch.assign(gamesPerBatch, PgnGame());
+                filled = 0;
+            }
+        }
+        if (filled > 0)
+        {
+            batch.resize(filled);
+            queue.Push(std::move(batch));
+        }
+        reader.Close();
+    }
+
+    queue.Close();
+    for (auto &worker : workers)
+        worker.join();
+
+    std::size_t entries = 0;
+    std::size_t spilled = runs.Spilled();
+    if (!failed)
+        failed = !MergeRuns(runs, opts, entries);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    std::cout << "bookbuild: " << stats.games << " games (" << stats.badGames << " skipped or truncated), "
+              << stats.positions << " positions, " << spilled << " runs, "
+              << entries << " book entries in " << seconds << " s" << std::endl;
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,716 @@
+// gamedb - builds and queries the game database read by core/GameDatabase.
+//
+// build: the main thread streams games out of the PGN files in numbered
+// batches. Worker threads replay them with Position and encode each game:
+// packed moves, tag text and the keys of every position it reached. A writer
+// thread takes the batches back in input order, so game ids follow the PGN
+// files, appends the games and headers files and collects index entries. When
+// those outgrow the memory budget they are sorted and spilled to run files
+// (core/SortedRuns), which are merged into the index at the end. The same
+// pass sums the results per key into the stats file.
+//
+// query: replays a FEN and/or moves, looks the position up and prints the
+// W/D/L stats and the first matching games.
+//
+// Usage: gamedb build [options] -o base games1.pgn [games2.pgn ...]
+//        gamedb query -d base [--fen FEN] [--limit N] [moves ...]
+
+#include "core/GameDatabase.hpp"
+#include "core/Pgn.hpp"
+#include "core/Position.hpp"
+#include "core/SortedRuns.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+struct Options
+{
+    std::string basePath;
+    std::vector<std::string> inputs; // PGN files, or the moves of a query
+    std::string fen;
+    int threads = 0;    // 0 = hardware concurrency
+    int maxPly = 0;     // Only index the first maxPly half-moves of each game, 0 = all
+    int limit = 20;     // Games listed by a query
+    std::size_t memoryMb = 1024;
+};
+
+constexpr std::size_t gamesPerBatch = 256;
+
+struct PgnBatch
+{
+    uint64_t seq = 0;
+    std::vector<PgnGame> games;
+};
+
+struct EncodedGame
+{
+    bool skipped = false;   // Bad FEN; gets no id
+    bool truncated = false; // Stopped at an illegal or unreadable move
+    std::string moves;      // Result, flags, then one legal-move index per ply
+    std::string tags;       // "[Name \"Value\"]" lines, values escaped
+    std::vector<uint64_t> keys;
+};
+
+struct EncodedBatch
+{
+    uint64_t seq = 0;
+    std::vector<EncodedGame> games;
+};
+
+// Bounded hand-off between the reader and the workers
+class BatchQueue
+{
+private:
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::deque<PgnBatch> batches;
+    std::size_t capacity;
+    bool closed = false;
+
+public:
+    explicit BatchQueue(std::size_t cap) : capacity(cap) {}
+
+    void Push(PgnBatch &&batch)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [&] { return batches.size() < capacity; });
+        batches.push_back(std::move(batch));
+        notEmpty.notify_one();
+    }
+
+    bool Pop(PgnBatch &batch)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [&] { return !batches.empty() || closed; });
+        if (batches.empty())
+            return false;
+        batch = std::move(batches.front());
+        batches.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void Close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+    }
+};
+
+// Puts the workers' batches back in input order for the writer. A worker
+// that is too far ahead waits, unless its batch is the one the writer needs.
+class OrderedBatches
+{
+private:
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::map<uint64_t, EncodedBatch> pending;
+    uint64_t nextSeq = 0;
+    std::size_t capacity;
+    bool closed = false;
+
+public:
+    explicit OrderedBatches(std::size_t cap) : capacity(cap) {}
+
+    void Push(EncodedBatch &&batch)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return pending.size() < capacity || batch.seq == nextSeq; });
+        uint64_t seq = batch.seq;
+        pending[seq] = std::move(batch);
+        changed.notify_all();
+    }
+
+    bool Pop(EncodedBatch &batch)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return pending.count(nextSeq) != 0 || (closed && pending.empty()); });
+        auto it = pending.find(nextSeq);
+        if (it == pending.end())
+            return false;
+        batch = std::move(it->second);
+        pending.erase(it);
+        nextSeq++;
+        changed.notify_all();
+        return true;
+    }
+
+    void Close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        changed.notify_all();
+    }
+};
+
+struct RunRecord
+{
+    uint64_t key;
+    uint32_t packed; // game id << 2 | result
+    uint32_t unused;
+
+    bool operator<(const RunRecord &other) const
+    {
+        return key != other.key ? key < other.key : packed < other.packed;
+    }
+};
+
+int ResultOf(const std::string &result)
+{
+    if (result == "1-0")
+        return GAMEDB_WHITE_WINS;
+    if (result == "0-1")
+        return GAMEDB_BLACK_WINS;
+    if (result == "1/2-1/2")
+        return GAMEDB_DRAW;
+    return GAMEDB_UNKNOWN;
+}
+
+void Encode(const PgnGame &game, int maxPly, EncodedGame &out)
+{
+    out = EncodedGame();
+
+    Position pos = Position::StartPosition();
+    std::string fen = game.Tag("FEN");
+    if (!fen.empty() && !pos.SetFromFEN(fen))
+    {
+        out.skipped = true;
+        return;
+    }
+
+    // Escaped as in PGN, so a quote or a backslash can not end the value
+    // early. PGN has no escape for line breaks; those become spaces, which
+    // also keeps every tag on its own line.
+    for (const auto &tag : game.tags)
+    {
+        out.tags += "[" + tag.first + " \"";
+        for (char c : tag.second)
+        {
+            if (c == '"' || c == '\\')
+                out.tags += '\\';
+            out.tags += static_cast<unsigned char>(c) < 0x20 ? ' ' : c;
+        }
+        out.tags += "\"]\n";
+    }
+
+    out.moves.push_back(static_cast<char>(ResultOf(game.result)));
+    out.moves.push_back(static_cast<char>(fen.empty() ? 0 : GAMEDB_FLAG_FEN));
+    out.keys.push_back(pos.Key());
+
+    MoveList legal;
+    for (const std::string &san : game.moves)
+    {
+        Move move;
+        if (!pos.ParseSAN(san.c_str(), move))
+        {
+            out.truncated = true;
+            break; // Keep the moves before the bad one
+        }
+
+        pos.GenerateLegalMoves(legal);
+        int index = 0;
+        while (!(legal.moves[index] == move))
+            index++;
+        out.moves.push_back(static_cast<char>(index));
+        pos.MakeMove(move);
+
+        if (maxPly == 0 || static_cast<int>(out.moves.size()) - 2 <= maxPly)
+            out.keys.push_back(pos.Key());
+    }
+
+    // A repeated position is indexed once per game
+    std::sort(out.keys.begin(), out.keys.end());
+    out.keys.erase(std::unique(out.keys.begin(), out.keys.end()), out.keys.end());
+}
+
+struct Stats
+{
+    std::atomic<uint64_t> games{0};
+    std::atomic<uint64_t> skipped{0};
+    std::atomic<uint64_t> truncated{0};
+};
+
+void WorkerMain(BatchQueue &queue, OrderedBatches &encoded, const Options &opts)
+{
+    PgnBatch batch;
+    while (queue.Pop(batch))
+    {
+        EncodedBatch out;
+        out.seq = batch.seq;
+        out.games.resize(batch.games.size());
+        for (std::size_t i = 0; i < batch.games.size(); i++)
+            Encode(batch.games[i], opts.maxPly, out.games[i]);
+        encoded.Push(std::move(out));
+    }
+}
+
+bool WriteAll(std::FILE *out, const void *data, std::size_t size)
+{
+    return size == 0 || std::fwrite(data, 1, size, out) == size;
+}
+
+bool WriteHeader(std::FILE *out, const char *magic, uint64_t count, uint64_t tableOffset)
+{
+    GameDbHeader header;
+    std::memcpy(header.magic, magic, 4);
+    header.version = GAMEDB_VERSION;
+    header.count = count;
+    header.tableOffset = tableOffset;
+    return std::fseek(out, 0, SEEK_SET) == 0 && WriteAll(out, &header, sizeof(header));
+}
+
+// One of the two blob files: a header, the blobs, then the offsets table
+class BlobFile
+{
+private:
+    std::FILE *file = nullptr;
+    const char *magic;
+    std::vector<uint64_t> offsets;
+    uint64_t size = sizeof(GameDbHeader);
+
+public:
+    std::string path;
+
+    explicit BlobFile(const char *m) : magic(m) {}
+    ~BlobFile()
+    {
+        if (file != nullptr)
+            std::fclose(file);
+    }
+
+    bool Open(const std::string &p)
+    {
+        path = p;
+        file = std::fopen(path.c_str(), "wb");
+        return file != nullptr && WriteHeader(file, magic, 0, 0);
+    }
+
+    bool Add(const std::string &blob)
+    {
+        offsets.push_back(size);
+        size += blob.size();
+        return WriteAll(file, blob.data(), blob.size());
+    }
+
+    bool Finish()
+    {
+        uint64_t count = offsets.size();
+        offsets.push_back(size);
+        bool ok = WriteAll(file, offsets.data(), offsets.size() * sizeof(uint64_t)) &&
+                  WriteHeader(file, magic, count, size);
+        ok = (std::fclose(file) == 0) && ok;
+        file = nullptr;
+        return ok;
+    }
+};
+
+// Receives the games in id order, on the writer thread
+class DatabaseWriter
+{
+private:
+    const Options &opts;
+    Stats &stats;
+    BlobFile games{"CGDG"};
+    BlobFile headers{"CGDH"};
+    std::vector<RunRecord> entries;
+    std::size_t maxEntries;
+    uint32_t nextId = 0;
+
+public:
+    SortedRuns<RunRecord> runs;
+    bool failed = false;
+
+    DatabaseWriter(const Options &o, Stats &s, std::size_t max)
+        : opts(o), stats(s), maxEntries(max), runs(o.basePath)
+    {
+    }
+
+    bool Open()
+    {
+        if (!games.Open(opts.basePath + ".games") || !headers.Open(opts.basePath + ".headers"))
+        {
+            std::cerr << "gamedb: cannot create " << opts.basePath << ".games / .headers" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void Add(EncodedGame &game)
+    {
+        if (failed)
+            return;
+        if (game.skipped)
+        {
+            stats.skipped++;
+            return;
+        }
+        if (nextId == GAMEDB_MAX_GAMES)
+        {
+            std::cerr << "gamedb: more than " << GAMEDB_MAX_GAMES << " games" << std::endl;
+            failed = true;
+            return;
+        }
+
+        uint32_t id = nextId++;
+        uint32_t packed = (id << 2) | static_cast<uint8_t>(game.moves[0]);
+        for (uint64_t key : game.keys)
+            entries.push_back({key, packed, 0});
+
+        if (!games.Add(game.moves) || !headers.Add(game.tags))
+        {
+            std::cerr << "gamedb: failed writing " << opts.basePath << ".games / .headers" << std::endl;
+            failed = true;
+        }
+        if (entries.size() >= maxEntries && !runs.Spill(entries))
+            failed = true;
+
+        stats.games++;
+        if (game.truncated)
+            stats.truncated++;
+    }
+
+    bool Finish()
+    {
+        if (!games.Finish() || !headers.Finish())
+        {
+            std::cerr << "gamedb: failed writing " << opts.basePath << ".games / .headers" << std::endl;
+            failed = true;
+        }
+        if (!failed && !runs.Spill(entries))
+            failed = true;
+        return !failed;
+    }
+};
+
+// Streams the merged entries into one of the two index files, in chunks
+class ChunkWriter
+{
+private:
+    std::FILE *out;
+    std::vector<unsigned char> chunk;
+
+public:
+    bool ok = true;
+
+    ChunkWriter(std::FILE *file, std::size_t recordSize) : out(file) { chunk.reserve(recordSize * 4096); }
+
+    void Add(const unsigned char *record, std::size_t size)
+    {
+        chunk.insert(chunk.end(), record, record + size);
+        if (chunk.size() >= chunk.capacity())
+            Flush();
+    }
+
+    void Flush()
+    {
+        ok = WriteAll(out, chunk.data(), chunk.size()) && ok;
+        chunk.clear();
+    }
+};
+
+// Merges the runs into the index and, in the same pass, writes one stats
+// record per key. The stats bucket table is counted along the way and
+// written over its placeholder.
+bool MergeRuns(SortedRuns<RunRecord> &runs, const std::string &basePath, uint64_t &entriesWritten,
+               uint64_t &keysWritten)
+{
+    std::string indexPath = basePath + ".index";
+    std::string statsPath = basePath + ".stats";
+    std::FILE *indexFile = std::fopen(indexPath.c_str(), "wb");
+    std::FILE *statsFile = std::fopen(statsPath.c_str(), "wb");
+    if (indexFile == nullptr || statsFile == nullptr)
+    {
+        std::cerr << "gamedb: cannot create " << indexPath << " / " << statsPath << std::endl;
+        if (indexFile != nullptr)
+            std::fclose(indexFile);
+        if (statsFile != nullptr)
+            std::fclose(statsFile);
+        return false;
+    }
+
+    std::vector<uint64_t> buckets(GAMEDB_BUCKETS + 1, 0);
+    const uint64_t recordsAt = sizeof(GameDbHeader) + buckets.size() * sizeof(uint64_t);
+    bool ok = WriteHeader(indexFile, "CGDI", 0, sizeof(GameDbHeader)) && WriteHeader(statsFile, "CGDS", 0, recordsAt) &&
+              WriteAll(statsFile, buckets.data(), buckets.size() * sizeof(uint64_t));
+
+    ChunkWriter entries(indexFile, GAMEDB_ENTRY_SIZE);
+    ChunkWriter records(statsFile, GAMEDB_STATS_SIZE);
+
+    // Totals of the key being merged: games, then one count per GameDbResult
+    uint64_t key = 0;
+    uint64_t first = 0;
+    uint32_t counts[4] = {0, 0, 0, 0};
+    auto finishKey = [&]
+    {
+        unsigned char record[GAMEDB_STATS_SIZE];
+        uint32_t games = counts[0] + counts[1] + counts[2] + counts[3];
+        std::memcpy(record, &key, 8);
+        std::memcpy(record + 8, &first, 8);
+        std::memcpy(record + 16, &games, 4);
+        std::memcpy(record + 20, counts, 12); // White wins, draws, black wins
+        records.Add(record, GAMEDB_STATS_SIZE);
+        buckets[(key >> 48) + 1]++;
+        keysWritten++;
+    };
+
+    entriesWritten = 0;
+    keysWritten = 0;
+    ok = ok && runs.Merge([&](const RunRecord &r)
+                          {
+                              if (entriesWritten == 0 || r.key != key)
+                              {
+                                  if (entriesWritten != 0)
+                                      finishKey();
+                                  key = r.key;
+                                  first = entriesWritten;
+                                  std::memset(counts, 0, sizeof(counts));
+                              }
+                              counts[r.packed & 3]++;
+
+                              unsigned char entry[GAMEDB_ENTRY_SIZE];
+                              std::memcpy(entry, &r.key, 8);
+                              std::memcpy(entry + 8, &r.packed, 4);
+                              entries.Add(entry, GAMEDB_ENTRY_SIZE);
+                              entriesWritten++;
+                              return entries.ok && records.ok;
+                          });
+    if (ok && entriesWritten != 0)
+        finishKey();
+    entries.Flush();
+    records.Flush();
+    ok = ok && entries.ok && records.ok;
+
+    // Counts per bucket -> first record of each bucket; the last one is the total
+    for (std::size_t i = 1; i < buckets.size(); i++)
+        buckets[i] += buckets[i - 1];
+
+    ok = ok && WriteHeader(indexFile, "CGDI", entriesWritten, sizeof(GameDbHeader)) &&
+         WriteHeader(statsFile, "CGDS", keysWritten, recordsAt) &&
+         WriteAll(statsFile, buckets.data(), buckets.size() * sizeof(uint64_t));
+    ok = (std::fclose(indexFile) == 0) && ok;
+    ok = (std::fclose(statsFile) == 0) && ok;
+    if (!ok)
+        std::cerr << "gamedb: failed writing " << indexPath << " / " << statsPath << std::endl;
+    return ok;
+}
+
+int Build(const Options &opts)
+{
+    const auto startTime = std::chrono::steady_clock::now();
+    const std::size_t maxEntries = std::max<std::size_t>(1 << 16, opts.memoryMb * 1024 * 1024 / sizeof(RunRecord));
+
+    Stats stats;
+    DatabaseWriter writer(opts, stats, maxEntries);
+    if (!writer.Open())
+        return 1;
+
+    BatchQueue queue(static_cast<std::size_t>(opts.threads) * 2);
+    OrderedBatches encoded(static_cast<std::size_t>(opts.threads) * 4);
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < opts.threads; i++)
+        workers.emplace_back(WorkerMain, std::ref(queue), std::ref(encoded), std::cref(opts));
+
+    std::thread writerThread([&]
+    {
+        EncodedBatch batch;
+        while (encoded.Pop(batch))
+        {
+            for (EncodedGame &game : batch.games)
+                writer.Add(game);
+        }
+    });
+
+    // Reader runs on the main thread
+    bool failed = false;
+    uint64_t seq = 0;
+    PgnReader reader;
+    for (const std::string &path : opts.inputs)
+    {
+        if (!reader.Open(path))
+        {
+            std::cerr << "gamedb: cannot open " << path << std::endl;
+            failed = true;
+            continue;
+        }
+
+        PgnBatch batch;
+        batch.games.resize(gamesPerBatch);
+        std::size_t filled = 0;
+        while (reader.NextGame(batch.games[filled]))
+        {
+            if (++filled == gamesPerBatch)
+            {
+                batch.seq = seq++;
+                queue.Push(std::move(batch));
+                batch = PgnBatch();
+                batch.games.resize(gamesPerBatch);
+                filled = 0;
+            }
+        }
+        if (filled > 0)
+        {
+            batch.games.resize(filled);
+            batch.seq = seq++;
+            queue.Push(std::move(batch));
+        }
+        reader.Close();
+    }
+
+    queue.Close();
+    for (auto &worker : workers)
+        worker.join();
+    encoded.Close();
+    writerThread.join();
+
+    failed = !writer.Finish() || failed;
+
+    uint64_t indexEntries = 0;
+    uint64_t keys = 0;
+    std::size_t spilled = writer.runs.Spilled();
+    if (!failed)
+        failed = !MergeRuns(writer.runs, opts.basePath, indexEntries, keys);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    std::cout << "gamedb: " << stats.games << " games (" << stats.skipped << " skipped, " << stats.truncated
+              << " truncated), " << indexEntries << " index entries, " << keys << " positions, " << spilled
+              << " runs in "
+              << seconds << " s" << std::endl;
+    return failed ? 1 : 0;
+}
+
+int Query(const Options &opts)
+{
+    Position pos = Position::StartPosition();
+    if (!opts.fen.empty() && !pos.SetFromFEN(opts.fen))
+    {
+        std::cerr << "gamedb: bad FEN " << opts.fen << std::endl;
+        return 1;
+    }
+    for (const std::string &text : opts.inputs)
+    {
+        Move move;
+        if (!pos.ParseSAN(text.c_str(), move) && !pos.ParseUCI(text, move))
+        {
+            std::cerr << "gamedb: illegal move " << text << " in " << pos.ToFEN() << std::endl;
+            return 1;
+        }
+        pos.MakeMove(move);
+    }
+
+    GameDatabase db;
+    if (!db.Open(opts.basePath))
+        return 1;
+
+    PositionStats stats;
+    const auto lookupStart = std::chrono::steady_clock::now();
+    db.Lookup(pos.Key(), static_cast<std::size_t>(opts.limit), stats);
+    double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - lookupStart).count();
+
+    std::cout << pos.ToFEN() << "\n"
+              << stats.games << " of " << db.GameCount() << " games: +" << stats.whiteWins << " =" << stats.draws
+              << " -" << stats.blackWins << ", white scores " << static_cast<int>(stats.WhiteScore() + 0.5)
+              << "% (lookup " << micros << " us)" << std::endl;
+
+    static const char *results[] = {"1-0", "1/2-1/2", "0-1", "*"};
+    for (uint32_t id : stats.gameIds)
+    {
+        std::vector<std::string> moves;
+        db.Moves(id, moves);
+        std::cout << "  #" << id << "  " << db.Tag(id, "White") << " - " << db.Tag(id, "Black") << "  "
+                  << results[db.Result(id)] << "  " << db.Tag(id, "Date") << "  (" << moves.size() << " plies)\n";
+    }
+    if (stats.games > stats.gameIds.size())
+        std::cout << "  ... " << stats.games - stats.gameIds.size() << " more" << std::endl;
+    return 0;
+}
+
+void PrintUsage()
+{
+    std::cout << "Usage: gamedb build [options] -o BASE games.pgn [more.pgn ...]\n"
+              << "  -o BASE          writes BASE.games, BASE.headers, BASE.index and BASE.stats\n"
+              << "  --threads N      worker threads (default: all cores)\n"
+              << "  --max-ply N      only index the first N half-moves of each game (default: all)\n"
+              << "  --memory MB      memory budget for index entries before spilling (default 1024)\n"
+              << "       gamedb query -d BASE [--fen FEN] [--limit N] [moves ...]\n"
+              << "  -d BASE          database to search\n"
+              << "  --fen FEN        start from this position (default: the start position)\n"
+              << "  --limit N        games to list (default 20)\n"
+              << "  moves            SAN or UCI moves played from there\n";
+}
+
+bool ParseArgs(int argc, char **argv, bool &build, Options &opts)
+{
+    if (argc < 2)
+        return false;
+    std::string command = argv[1];
+    if (command != "build" && command != "query")
+        return false;
+    build = command == "build";
+
+    for (int i = 2; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == (build ? "-o" : "-d") && hasValue)
+            opts.basePath = argv[++i];
+        else if (build && arg == "--threads" && hasValue)
+            opts.threads = std::atoi(argv[++i]);
+        else if (build && arg == "--max-ply" && hasValue)
+            opts.maxPly = std::max(0, std::atoi(argv[++i]));
+        else if (build && arg == "--memory" && hasValue)
+            opts.memoryMb = static_cast<std::size_t>(std::max(16, std::atoi(argv[++i])));
+        else if (!build && arg == "--fen" && hasValue)
+            opts.fen = argv[++i];
+        else if (!build && arg == "--limit" && hasValue)
+            opts.limit = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "-h" || arg == "--help")
+            return false;
+        else if (!arg.empty() && arg[0] == '-')
+        {
+            std::cerr << "gamedb: unknown option " << arg << std::endl;
+            return false;
+        }
+        else
+            opts.inputs.push_back(arg);
+    }
+    return !opts.basePath.empty() && (!build || !opts.inputs.empty());
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    bool build = false;
+    Options opts;
+    if (!ParseArgs(argc, argv, build, opts))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    if (!build)
+        return Query(opts);
+
+    if (opts.threads <= 0)
+        opts.threads = std::max(1u, std::thread::hardware_concurrency());
+    return Build(opts);
+}
@@ -0,0 +1,231 @@
+// kpkgen - generates the king + pawn vs king bitbase compiled into the game.
+//
+// Every position with the pawn on files a-d (the other half is a mirror
+// image) gets one bit: 1 if the side with the pawn wins, 0 if it is a draw.
+// That is 24 pawn squares x 64 x 64 king squares x 2 sides to move = 196608
+// bits, written as 6144 32-bit words in the initializer format src/core/Kpk.cpp
+// includes. The Makefile runs this before building the game.
+//
+// Usage: kpkgen output.inc
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+
+// Squares are 0-63 with a1 = 0; white always owns the pawn here
+constexpr int positionCount = 2 * 64 * 64 * 24;
+
+enum Result : uint8_t
+{
+    INVALID,
+    UNKNOWN,
+    DRAW,
+    WIN
+};
+
+// Same index layout as Kpk.cpp: side to move, black king, white king, pawn
+int Index(int whiteToMove, int blackKing, int whiteKing, int pawn)
+{
+    int pawnIndex = (pawn & 7) * 6 + ((pawn >> 3) - 1);
+    return (whiteToMove ? 0 : 1) | (blackKing << 1) | (whiteKing << 7) | (pawnIndex << 13);
+}
+
+int Distance(int a, int b)
+{
+    return std::max(std::abs((a & 7) - (b & 7)), std::abs((a >> 3) - (b >> 3)));
+}
+
+bool PawnAttacks(int pawn, int sq)
+{
+    return (sq >> 3) == (pawn >> 3) + 1 && std::abs((sq & 7) - (pawn & 7)) == 1;
+}
+
+// King moves staying on the board
+int KingMoves(int sq, int out[8])
+{
+    int count = 0;
+    for (int df = -1; df <= 1; df++)
+    {
+        for (int dr = -1; dr <= 1; dr++)
+        {
+            int f = (sq & 7) + df, r = (sq >> 3) + dr;
+            if ((df || dr) && f >= 0 && f <= 7 && r >= 0 && r <= 7)
+                out[count++] = r * 8 + f;
+        }
+    }
+    return count;
+}
+
+struct KpkPosition
+{
+    int whiteToMove;
+    int whiteKing;
+    int blackKing;
+    int pawn;
+};
+
+KpkPosition Decode(int index)
+{
+    KpkPosition p;
+    p.whiteToMove = (index & 1) ? 0 : 1;
+    p.blackKing = (index >> 1) & 63;
+    p.whiteKing = (index >> 7) & 63;
+    int pawnIndex = index >> 13;
+    p.pawn = ((pawnIndex % 6) + 1) * 8 + pawnIndex / 6;
+    return p;
+}
+
+Result Classify(const KpkPosition &p)
+{
+    int promotion = p.pawn + 8;
+
+    if (p.whiteKing == p.blackKing || p.whiteKing == p.pawn || p.blackKing == p.pawn ||
+        Distance(p.whiteKing, p.blackKing) <= 1 ||
+        (p.whiteToMove && PawnAttacks(p.pawn, p.blackKing)))
+        return INVALID;
+
+    // A pawn that promotes without being taken wins
+    if (p.whiteToMove && (p.pawn >> 3) == 6 &&
+        p.whiteKing != promotion && p.blackKing != promotion &&
+        (Distance(p.blackKing, promotion) > 1 || Distance(p.whiteKing, promotion) == 1))
+        return WIN;
+
+    if (!p.whiteToMove)
+    {
+        int moves[8];
+        int count = KingMoves(p.blackKing, moves);
+        bool canMove = false;
+        for (int i = 0; i < count; i++)
+        {
+            int to = moves[i];
+            if (Distance(to, p.whiteKing) <= 1 || PawnAttacks(p.pawn, to))
+                continue;
+            // Taking an undefended pawn leaves bare kings
+            if (to == p.pawn)
+                return DRAW;
+            canMove = true;
+        }
+        if (!canMove)
+            return PawnAttacks(p.pawn, p.blackKing) ? WIN : DRAW;
+    }
+
+    return UNKNOWN;
+}
+
+// One sweep: decide what can be decided from the children's current results
+bool Iterate(std::vector<uint8_t> &db)
+{
+    bool changed = false;
+    for (int index = 0; index < positionCount; index++)
+    {
+        if (db[index] != UNKNOWN)
+            continue;
+
+        KpkPosition p = Decode(index);
+        int moves[8];
+        bool anyWin = false, anyDraw = false, anyUnknown = false;
+
+        auto visit = [&](Result r)
+        {
+            if (r == WIN) anyWin = true;
+            else if (r == DRAW) anyDraw = true;
+            else if (r == UNKNOWN) anyUnknown = true;
+        };
+
+        if (p.whiteToMove)
+        {
+            int count = KingMoves(p.whiteKing, moves);
+            for (int i = 0; i < count; i++)
+            {
+                int to = moves[i];
+                if (to == p.pawn || Distance(to, p.blackKing) <= 1)
+                    continue;
+                visit(static_cast<Result>(db[Index(0, p.blackKing, to, p.pawn)]));
+            }
+
+            // Pushes from the 7th rank are promotions, already handled in Classify
+            int push = p.pawn + 8;
+            if ((p.pawn >> 3) < 6 && push != p.whiteKing && push != p.blackKing)
+            {
+                visit(static_cast<Result>(db[Index(0, p.blackKing, p.whiteKing, push)]));
+                int doublePush = push + 8;
+                if ((p.pawn >> 3) == 1 && doublePush != p.whiteKing && doublePush != p.blackKing)
+                    visit(static_cast<Result>(db[Index(0, p.blackKing, p.whiteKing, doublePush)]));
+            }
+
+            if (anyWin)
+                db[index] = WIN;
+            else if (!anyUnknown)
+                db[index] = DRAW;
+        }
+        else
+        {
+            int count = KingMoves(p.blackKing, moves);
+            for (int i = 0; i < count; i++)
+            {
+                int to = moves[i];
+                if (to == p.pawn || Distance(to, p.whiteKing) <= 1 || PawnAttacks(p.pawn, to))
+                    continue;
+                visit(static_cast<Result>(db[Index(1, to, p.whiteKing, p.pawn)]));
+            }
+
+            if (anyDraw)
+                db[index] = DRAW;
+            else if (!anyUnknown)
+                db[index] = WIN;
+        }
+
+        changed |= (db[index] != UNKNOWN);
+    }
+    return changed;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        std::fprintf(stderr, "Usage: kpkgen output.inc\n");
+        return 1;
+    }
+
+    std::vector<uint8_t> db(positionCount);
+    for (int index = 0; index < positionCount; index++)
+        db[index] = Classify(Decode(index));
+
+    while (Iterate(db))
+    {
+    }
+
+    std::vector<uint32_t> bits(positionCount / 32, 0);
+    int wins = 0;
+    for (int index = 0; index < positionCount; index++)
+    {
+        if (db[index] == WIN)
+        {
+            bits[index >> 5] |= 1u << (index & 31);
+            wins++;
+        }
+    }
+
+    FILE *f = std::fopen(argv[1], "w");
+    if (f == nullptr)
+    {
+        std::fprintf(stderr, "kpkgen: cannot write %s\n", argv[1]);
+        return 1;
+    }
+
+    std::fprintf(f, "// Generated by tools/kpkgen.cpp - do not edit\n");
+    for (std::size_t i = 0; i < bits.size(); i++)
+        std::fprintf(f, "0x%08X,%s", bits[i], (i % 8 == 7) ? "\n" : " ");
+    bool ok = std::fclose(f) == 0;
+
+    std::printf("kpkgen: %d winning positions, %d bytes\n", wins, static_cast<int>(bits.size() * 4));
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,627 @@
+// match - plays games between two engine configurations and reports the
+// Elo difference between them.
+//
+// Games run concurrently: every worker thread owns one process of each
+// engine and plays whole games, one after another, taking the next game
+// number from a shared counter. Each opening is played twice with colours
+// swapped. Games end by the rules (mate, stalemate, 50 moves, repetition,
+// bare kings), by adjudication on the engines' scores or the move count, or by
+// forfeit when an engine returns no legal move. After every game the running
+// score, Elo +- 95% error and the SPRT log-likelihood ratio are printed; the
+// match stops early once the SPRT accepts either hypothesis.
+//
+// Usage: match [options] --engine SPEC --engine SPEC
+// SPEC is a comma separated list, e.g.
+//   name=sf20,skill=20,movetime=100,threads=1,hash=16
+//   name=dev,path=./stockfish-dev,depth=12,option.Contempt=10
+
+#include "engine/StockfishEngine.hpp"
+#include "core/Pgn.hpp"
+#include "core/Position.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// EngineMove converts moves to board pixels; the tool has no board, so any layout will do
+float squareSize = 100.0f;
+Vector2 boardPosition = {0.0f, 0.0f};
+
+namespace
+{
+
+const int MATE_SCORE = 100000;
+
+struct EngineConfig
+{
+    std::string name;
+    std::string path;
+    int skill = 20;
+    int movetimeMs = 100;
+    int depth = 0;
+    uint64_t nodes = 0;
+    int threads = 1;
+    int hashMb = 16;
+    std::vector<std::pair<std::string, std::string>> options; // Extra setoption pairs
+};
+
+struct Options
+{
+    EngineConfig engines[2];
+    int engineCount = 0;
+    int games = 100;
+    int concurrency = 0;      // 0 = cores / threads per engine
+    std::string openingsPath; // EPD; one position per line
+    uint64_t seed = 0;        // 0 = openings in file order
+    std::string pgnPath;
+    int maxPlies = 400;       // Draw once a game gets this long
+    int resignCp = 700;       // Both engines agree one side is this far ahead...
+    int resignPlies = 6;      // ...for this many plies in a row
+    int drawCp = 10;          // Both engines within this of 0...
+    int drawPlies = 16;       // ...for this many plies in a row...
+    int drawAfterPly = 80;    // ...after this ply
+    bool sprt = false;
+    double elo0 = 0, elo1 = 5, alpha = 0.05, beta = 0.05;
+};
+
+enum GameOutcome
+{
+    WHITE_WINS,
+    BLACK_WINS,
+    DRAW
+};
+
+struct GameRecord
+{
+    GameOutcome outcome = DRAW;
+    std::string reason;
+    PgnGame pgn;
+};
+
+void PrintUsage()
+{
+    std::cerr << "Usage: match [options] --engine SPEC --engine SPEC\n"
+              << "  SPEC: name=N,path=P,skill=1-20,movetime=MS,depth=D,nodes=N,threads=T,hash=MB,option.NAME=VALUE\n"
+              << "        (path defaults to CHESS_ENGINE_PATH or stockfish; movetime is used when no depth/nodes)\n"
+              << "  --games N           games to play (default 100)\n"
+              << "  --concurrency N     games at once (default cores / engine threads)\n"
+              << "  --openings FILE     EPD positions, each played with both colours\n"
+              << "  --seed N            shuffle the openings with this seed\n"
+              << "  --pgn FILE          write every game to FILE\n"
+              << "  --max-plies N       adjudicate a draw after N plies (default 400)\n"
+              << "  --resign CP,PLIES   adjudicate a win when both engines see CP for PLIES plies (default 700,6)\n"
+              << "  --draw PLY,CP,PLIES adjudicate a draw after PLY when |score| <= CP for PLIES plies (default 80,10,16)\n"
+              << "  --sprt ELO0,ELO1[,ALPHA,BETA]  stop once the SPRT decides (default alpha = beta = 0.05)\n";
+}
+
+bool ParseEngineSpec(const std::string &spec, EngineConfig &config, int index)
+{
+    config.name = "engine" + std::to_string(index + 1);
+    config.path = StockfishEngine::DefaultPath();
+
+    std::istringstream in(spec);
+    std::string item;
+    while (std::getline(in, item, ','))
+    {
+        std::size_t eq = item.find('=');
+        if (eq == std::string::npos)
+        {
+            std::cerr << "match: expected key=value in engine spec, got " << item << std::endl;
+            return false;
+        }
+        std::string key = item.substr(0, eq);
+        std::string value = item.substr(eq + 1);
+
+        if (key == "name")
+            config.name = value;
+        else if (key == "path")
+            config.path = value;
+        else if (key == "skill")
+            config.skill = std::atoi(value.c_str());
+        else if (key == "movetime")
+            config.movetimeMs = std::atoi(value.c_str());
+        else if (key == "depth")
+            config.depth = std::atoi(value.c_str());
+        else if (key == "nodes")
+            config.nodes = std::strtoull(value.c_str(), nullptr, 10);
+        else if (key == "threads")
+            config.threads = std::max(1, std::atoi(value.c_str()));
+        else if (key == "hash")
+            config.hashMb = std::max(1, std::atoi(value.c_str()));
+        else if (key.compare(0, 7, "option.") == 0)
+            config.options.emplace_back(key.substr(7), value);
+        else
+        {
+            std::cerr << "match: unknown engine setting " << key << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// "a,b,c" -> numbers; false if fewer than minCount
+bool ParseNumbers(const char *text, std::vector<double> &out, std::size_t minCount)
+{
+    out.clear();
+    std::istringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ','))
+        out.push_back(std::atof(item.c_str()));
+    return out.size() >= minCount;
+}
+
+bool ParseArgs(int argc, char **argv, Options &opts)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            std::cerr << "match: " << arg << " needs a value" << std::endl;
+            return false;
+        }
+        const char *value = argv[++i];
+        std::vector<double> numbers;
+
+        if (arg == "--engine")
+        {
+            if (opts.engineCount == 2)
+            {
+                std::cerr << "match: exactly two engines" << std::endl;
+                return false;
+            }
+            if (!ParseEngineSpec(value, opts.engines[opts.engineCount], opts.engineCount))
+                return false;
+            opts.engineCount++;
+        }
+        else if (arg == "--games")
+            opts.games = std::max(1, std::atoi(value));
+        else if (arg == "--concurrency")
+            opts.concurrency = std::max(1, std::atoi(value));
+        else if (arg == "--openings")
+            opts.openingsPath = value;
+        else if (arg == "--seed")
+            opts.seed = std::strtoull(value, nullptr, 10);
+        else if (arg == "--pgn")
+            opts.pgnPath = value;
+        else if (arg == "--max-plies")
+            opts.maxPlies = std::max(1, std::atoi(value));
+        else if (arg == "--resign" && ParseNumbers(value, numbers, 2))
+        {
+            opts.resignCp = static_cast<int>(numbers[0]);
+            opts.resignPlies = static_cast<int>(numbers[1]);
+        }
+        else if (arg == "--draw" && ParseNumbers(value, numbers, 3))
+        {
+            opts.drawAfterPly = static_cast<int>(numbers[0]);
+            opts.drawCp = static_cast<int>(numbers[1]);
+            opts.drawPlies = static_cast<int>(numbers[2]);
+        }
+        else if (arg == "--sprt" && ParseNumbers(value, numbers, 2))
+        {
+            opts.sprt = true;
+            opts.elo0 = numbers[0];
+            opts.elo1 = numbers[1];
+            if (numbers.size() >= 4)
+            {
+                opts.alpha = numbers[2];
+                opts.beta = numbers[3];
+            }
+        }
+        else
+        {
+            std::cerr << "match: bad option " << arg << " " << value << std::endl;
+            return false;
+        }
+    }
+
+    if (opts.engineCount != 2)
+    {
+        std::cerr << "match: give two --engine specs" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// EPD lines carry the first four FEN fields plus operations; the move counters are made up
+bool LoadOpenings(const std::string &path, std::vector<std::string> &openings)
+{
+    std::ifstream in(path);
+    if (!in)
+        return false;
+
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::istringstream fields(line);
+        std::string board, side, castling, ep;
+        if (!(fields >> board >> side >> castling >> ep) || board[0] == '#')
+            continue;
+
+        std::string fen = board + " " + side + " " + castling + " " + ep + " 0 1";
+        Position pos;
+        if (pos.SetFromFEN(fen))
+            openings.push_back(fen);
+        else
+            std::cerr << "match: skipping bad EPD line: " << line << std::endl;
+    }
+    return true;
+}
+
+// Start a configured engine process; nullptr if it does not come up
+std::unique_ptr<StockfishEngine> LaunchEngine(const EngineConfig &config)
+{
+    std::unique_ptr<StockfishEngine> engine(new StockfishEngine(config.path));
+    if (!engine->init())
+        return nullptr;
+
+    engine->setDifficulty(config.skill);
+    engine->setOption("Threads", std::to_string(config.threads));
+    engine->setOption("Hash", std::to_string(config.hashMb));
+    for (const auto &option : config.options)
+        engine->setOption(option.first, option.second);
+    return engine;
+}
+
+std::string TodayPgnDate()
+{
+    std::time_t now = std::time(nullptr);
+    char date[16];
+    std::strftime(date, sizeof(date), "%Y.%m.%d", std::localtime(&now));
+    return date;
+}
+
+class Match
+{
+public:
+    explicit Match(const Options &opts) : opts(opts) {}
+
+    int Run(const std::vector<std::string> &openingList)
+    {
+        openings = openingList;
+        if (openings.empty())
+            openings.push_back(std::string()); // Standard start position
+
+        if (!opts.pgnPath.empty())
+        {
+            pgnOut.open(opts.pgnPath, std::ios::app);
+            if (!pgnOut)
+            {
+                std::cerr << "match: can not write " << opts.pgnPath << std::endl;
+                return 1;
+            }
+        }
+
+        int threadsPerGame = std::max(opts.engines[0].threads, opts.engines[1].threads);
+        int workers = opts.concurrency > 0
+                          ? opts.concurrency
+                          : std::max(1, static_cast<int>(std::thread::hardware_concurrency()) / threadsPerGame);
+        workers = std::min(workers, opts.games);
+
+        std::cout << opts.engines[0].name << " vs " << opts.engines[1].name << ": " << opts.games << " games, "
+                  << workers << " at a time, " << openings.size() << " openings" << std::endl;
+
+        startTime = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (int i = 0; i < workers; i++)
+            threads.emplace_back(&Match::Worker, this);
+        for (std::thread &thread : threads)
+            thread.join();
+
+        PrintSummary();
+        return failed.load() ? 1 : 0;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Options opts;
+    std::vector<std::string> openings;
+    std::ofstream pgnOut;
+    Clock::time_point startTime;
+
+    std::atomic<int> nextGame{0};
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> failed{false};
+
+    std::mutex resultMutex; // Guards everything below and pgnOut
+    int wins = 0, losses = 0, draws = 0; // From engine 1's side
+    int played = 0;
+    std::string sprtVerdict;
+
+    void Worker()
+    {
+        std::unique_ptr<StockfishEngine> engines[2];
+
+        while (!stopping.load())
+        {
+            int game = nextGame.fetch_add(1);
+            if (game >= opts.games)
+                break;
+
+            // A crashed or missing engine is started again for the next game
+            for (int e = 0; e < 2; e++)
+            {
+                if (!engines[e])
+                    engines[e] = LaunchEngine(opts.engines[e]);
+                if (!engines[e])
+                {
+                    std::cerr << "match: can not start " << opts.engines[e].name << " (" << opts.engines[e].path
+                              << ")" << std::endl;
+                    failed = true;
+                    stopping = true;
+                    return;
+                }
+            }
+
+            // Each opening twice, engine 1 white in the first of the pair
+            const std::string &opening = openings[(game / 2) % openings.size()];
+            int whiteEngine = game % 2;
+            GameRecord record = PlayGame(engines, whiteEngine, opening, game);
+            Record(game, whiteEngine, record);
+        }
+    }
+
+    // An engine that gave no legal move is dropped, so Worker() restarts it
+    GameRecord PlayGame(std::unique_ptr<StockfishEngine> (&engines)[2], int whiteEngine, const std::string &opening, int game)
+    {
+        GameRecord record;
+        engines[0]->newGame();
+        engines[1]->newGame();
+
+        Position pos = Position::StartPosition();
+        if (!opening.empty())
+            pos.SetFromFEN(opening);
+
+        SearchRequest request;
+        request.startFen = opening;
+        std::vector<uint64_t> keys(1, pos.Key());
+        int resignStreak = 0, resignSide = 0, drawStreak = 0;
+
+        while (true)
+        {
+            MoveList legal;
+            pos.GenerateLegalMoves(legal);
+            const int side = pos.SideToMove();
+            if (legal.count == 0)
+            {
+                record.outcome = pos.InCheck() ? (side == 1 ? BLACK_WINS : WHITE_WINS) : DRAW;
+                record.reason = pos.InCheck() ? "checkmate" : "stalemate";
+                break;
+            }
+            if (pos.IsFiftyMoveDraw())
+            {
+                record.reason = "fifty-move rule";
+                break;
+            }
+            if (Position::IsThreefoldRepetition(keys.data(), static_cast<int>(keys.size()), pos.HalfmoveClock()))
+            {
+                record.reason = "threefold repetition";
+                break;
+            }
+            if (pos.HasInsufficientMaterial())
+            {
+                record.reason = "insufficient material";
+                break;
+            }
+            if (static_cast<int>(request.moveHistory.size()) >= opts.maxPlies)
+            {
+                record.reason = "adjudication: move limit";
+                break;
+            }
+
+            int mover = side == 1 ? whiteEngine : 1 - whiteEngine;
+            const EngineConfig &config = opts.engines[mover];
+            request.movetimeMs = (config.depth > 0 || config.nodes > 0) ? 0 : config.movetimeMs;
+            request.depth = config.depth;
+            request.nodes = config.nodes;
+
+            SearchResult result = engines[mover]->search(request);
+            Move move;
+            if (!result.move.isValid || !pos.ParseUCI(result.bestMove, move))
+            {
+                record.outcome = side == 1 ? BLACK_WINS : WHITE_WINS;
+                record.reason = config.name + (result.bestMove.empty() ? " gave no move" : " played an illegal move " + result.bestMove);
+                engines[mover].reset();
+                break;
+            }
+
+            record.pgn.moves.push_back(pos.ToSAN(move));
+            request.moveHistory.push_back(result.bestMove);
+            pos.MakeMove(move);
+            keys.push_back(pos.Key());
+
+            // Score adjudication, on white's view of the mover's score
+            if (result.hasScore)
+            {
+                int score = result.mate ? (result.score > 0 ? MATE_SCORE : -MATE_SCORE) : result.score;
+                int whiteScore = side == 1 ? score : -score;
+
+                int winning = whiteScore >= opts.resignCp ? 1 : whiteScore <= -opts.resignCp ? -1 : 0;
+                resignStreak = (winning != 0 && winning == resignSide) ? resignStreak + 1 : (winning != 0 ? 1 : 0);
+                resignSide = winning;
+                if (opts.resignPlies > 0 && resignStreak >= opts.resignPlies)
+                {
+                    record.outcome = resignSide > 0 ? WHITE_WINS : BLACK_WINS;
+                    record.reason = "adjudication: score";
+                    break;
+                }
+
+                int ply = static_cast<int>(request.moveHistory.size());
+                drawStreak = (ply > opts.drawAfterPly && std::abs(whiteScore) <= opts.drawCp) ? drawStreak + 1 : 0;
+                if (opts.drawPlies > 0 && drawStreak >= opts.drawPlies)
+                {
+                    record.reason = "adjudication: draw score";
+                    break;
+                }
+            }
+            else
+            {
+                resignStreak = drawStreak = 0;
+            }
+        }
+
+        PgnGame &pgn = record.pgn;
+        const char *result = record.outcome == WHITE_WINS ? "1-0" : record.outcome == BLACK_WINS ? "0-1" : "1/2-1/2";
+        pgn.result = result;
+        pgn.tags.emplace_back("Event", "match");
+        pgn.tags.emplace_back("Site", "?");
+        pgn.tags.emplace_back("Date", TodayPgnDate());
+        pgn.tags.emplace_back("Round", std::to_string(game + 1));
+        pgn.tags.emplace_back("White", opts.engines[whiteEngine].name);
+        pgn.tags.emplace_back("Black", opts.engines[1 - whiteEngine].name);
+        pgn.tags.emplace_back("Result", result);
+        if (!opening.empty())
+        {
+            pgn.tags.emplace_back("SetUp", "1");
+            pgn.tags.emplace_back("FEN", opening);
+        }
+        pgn.tags.emplace_back("PlyCount", std::to_string(pgn.moves.size()));
+        pgn.tags.emplace_back("Termination", record.reason);
+        return record;
+    }
+
+    void Record(int game, int whiteEngine, const GameRecord &record)
+    {
+        std::lock_guard<std::mutex> lock(resultMutex);
+
+        // Count from engine 1's side
+        if (record.outcome == DRAW)
+            draws++;
+        else if ((record.outcome == WHITE_WINS) == (whiteEngine == 0))
+            wins++;
+        else
+            losses++;
+        played++;
+
+        if (pgnOut.is_open())
+        {
+            pgnOut << record.pgn.ToString() << "\n";
+            pgnOut.flush();
+        }
+
+        double elo, error;
+        EloEstimate(elo, error);
+        std::printf("Game %d (%s vs %s): %s {%s}  Score %d-%d-%d  Elo %+.1f +- %.1f",
+                    game + 1, opts.engines[whiteEngine].name.c_str(), opts.engines[1 - whiteEngine].name.c_str(),
+                    record.pgn.result.c_str(), record.reason.c_str(), wins, losses, draws, elo, error);
+
+        if (opts.sprt && sprtVerdict.empty())
+        {
+            double llr, lower, upper;
+            SprtBounds(llr, lower, upper);
+            std::printf("  LLR %.2f (%.2f, %.2f)", llr, lower, upper);
+            if (llr >= upper || llr <= lower)
+            {
+                sprtVerdict = llr >= upper ? "H1 accepted" : "H0 accepted";
+                stopping = true; // Games already running are finished and counted
+            }
+        }
+        std::printf("\n");
+        std::fflush(stdout);
+    }
+
+    // Logistic Elo from the mean score; error is the 95% interval half-width
+    void EloEstimate(double &elo, double &error) const
+    {
+        elo = error = 0;
+        if (played == 0)
+            return;
+
+        double n = played;
+        double score = (wins + 0.5 * draws) / n;
+        double variance = (wins * std::pow(1 - score, 2) + draws * std::pow(0.5 - score, 2) + losses * std::pow(score, 2)) / n;
+        double margin = 1.96 * std::sqrt(variance / n);
+
+        auto toElo = [](double s)
+        {
+            s = std::min(std::max(s, 1e-6), 1 - 1e-6);
+            return -400.0 * std::log10(1.0 / s - 1.0);
+        };
+        elo = toElo(score);
+        error = (toElo(score + margin) - toElo(score - margin)) / 2;
+    }
+
+    // GSPRT with the normal approximation of the per-game score (as used by fishtest)
+    void SprtBounds(double &llr, double &lower, double &upper) const
+    {
+        lower = std::log(opts.beta / (1 - opts.alpha));
+        upper = std::log((1 - opts.beta) / opts.alpha);
+        llr = 0;
+        if (played == 0)
+            return;
+
+        double n = played;
+        double score = (wins + 0.5 * draws) / n;
+        double variance = (wins * std::pow(1 - score, 2) + draws * std::pow(0.5 - score, 2) + losses * std::pow(score, 2)) / n;
+        if (variance <= 0)
+            return;
+
+        auto toScore = [](double elo) { return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0)); };
+        double s0 = toScore(opts.elo0), s1 = toScore(opts.elo1);
+        llr = (s1 - s0) * (2 * score - s0 - s1) / (2 * variance / n);
+    }
+
+    void PrintSummary()
+    {
+        double seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+        double elo, error;
+        EloEstimate(elo, error);
+
+        int decisive = wins + losses;
+        double los = decisive > 0 ? 0.5 * (1 + std::erf((wins - losses) / std::sqrt(2.0 * decisive))) : 0.5;
+
+        std::printf("\n%s vs %s: %d games in %.1f s (%.2f games/s)\n", opts.engines[0].name.c_str(),
+                    opts.engines[1].name.c_str(), played, seconds, seconds > 0 ? played / seconds : 0.0);
+        std::printf("Score %d-%d-%d (%.1f%%)  Elo %+.1f +- %.1f  LOS %.1f%%\n", wins, losses, draws,
+                    played ? 100.0 * (wins + 0.5 * draws) / played : 0.0, elo, error, 100 * los);
+        if (opts.sprt)
+        {
+            double llr, lower, upper;
+            SprtBounds(llr, lower, upper);
+            std::printf("SPRT [%.1f, %.1f]: LLR %.2f (%.2f, %.2f) %s\n", opts.elo0, opts.elo1, llr, lower, upper,
+                        sprtVerdict.empty() ? "no decision" : sprtVerdict.c_str());
+        }
+    }
+};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options opts;
+    if (!ParseArgs(argc, argv, opts))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    std::vector<std::string> openings;
+    if (!opts.openingsPath.empty())
+    {
+        if (!LoadOpenings(opts.openingsPath, openings))
+        {
+            std::cerr << "match: can not read " << opts.openingsPath << std::endl;
+            return 1;
+        }
+        if (opts.seed != 0)
+            std::shuffle(openings.begin(), openings.end(), std::mt19937_64(opts.seed));
+    }
+
+    Match match(opts);
+    return match.Run(openings);
+}
@@ -0,0 +1,508 @@
+// mockuci - a stand-in UCI engine for exercising the engine adapter without
+// Stockfish.
+//
+// It speaks enough UCI for StockfishEngine (uci, isready, setoption,
+// ucinewgame, position, go, stop, ponderhit, quit) and answers every search
+// with a random legal move from Position's move generator. How long it takes,
+// how much info output it produces and which faults it injects are set on the
+// command line, so throughput and timeout handling can be measured and tested
+// on any machine. The random choices come from --seed, so a run repeats.
+//
+// Usage: mockuci [options]
+// StockfishEngine starts engines without arguments, so the same options can be
+// given in the MOCKUCI_OPTIONS environment variable, e.g.
+//   CHESS_ENGINE_PATH=./mockuci MOCKUCI_OPTIONS="--latency 50 --hang 0.1" ./game
+
+#include "core/Position.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+struct Options
+{
+    int latencyMs = -1;     // Fixed think time per search; < 0 = use the go limits like an engine
+    int jitterMs = 0;       // Up to this much extra think time
+    int infoRate = 20;      // Info lines per second while searching, 0 = none
+    int infoPadding = 0;    // Extra bytes per info line
+    int startupMs = 0;      // Delay before answering "uci"
+    uint64_t seed = 1;
+    double hangChance = 0;     // A search never answers and ignores stop
+    double truncateChance = 0; // An output line is cut short
+    double crashChance = 0;    // The process exits in the middle of a search
+    int crashAfter = 0;        // Exit during this search (1-based), 0 = never
+    std::string logPath;       // Appends every command received
+};
+
+struct GoLimits
+{
+    int movetimeMs = -1;
+    int wtimeMs = -1;
+    int btimeMs = -1;
+    int wincMs = 0;
+    int bincMs = 0;
+    int depth = 0;
+    uint64_t nodes = 0;
+    bool infinite = false;
+    bool ponder = false;
+};
+
+// What one search will do, decided when it starts so the outcome only depends on the seed
+struct SearchPlan
+{
+    GoLimits limits;
+    Position position;
+    int thinkMs = 0;       // From the start, or from ponderhit when pondering
+    bool hang = false;
+    int crashAtMs = -1;    // -1 = no crash
+    uint64_t seed = 0;
+};
+
+void PrintUsage()
+{
+    std::cerr << "Usage: mockuci [options]\n"
+              << "  --latency MS     think this long for every search (default: use the go limits)\n"
+              << "  --jitter MS      add up to MS random think time\n"
+              << "  --info-rate N    info lines per second while searching (default 20, 0 = none)\n"
+              << "  --info-pad N     pad each info line with N extra bytes\n"
+              << "  --startup MS     wait before answering uci\n"
+              << "  --seed N         random seed (default 1)\n"
+              << "  --hang P         chance a search never answers, even to stop\n"
+              << "  --truncate P     chance an output line is cut short\n"
+              << "  --crash P        chance the process exits during a search\n"
+              << "  --crash-after N  exit during the Nth search\n"
+              << "  --log FILE       append every command received to FILE\n"
+              << "Options are also read from MOCKUCI_OPTIONS.\n";
+}
+
+bool ParseArgs(const std::vector<std::string> &args, Options &opts)
+{
+    for (std::size_t i = 0; i < args.size(); i++)
+    {
+        const std::string &arg = args[i];
+        if (i + 1 >= args.size())
+        {
+            std::cerr << "mockuci: " << arg << " needs a value" << std::endl;
+            return false;
+        }
+        const char *value = args[++i].c_str();
+
+        if (arg == "--latency")
+            opts.latencyMs = std::atoi(value);
+        else if (arg == "--jitter")
+            opts.jitterMs = std::max(0, std::atoi(value));
+        else if (arg == "--info-rate")
+            opts.infoRate = std::max(0, std::atoi(value));
+        else if (arg == "--info-pad")
+            opts.infoPadding = std::max(0, std::atoi(value));
+        else if (arg == "--startup")
+            opts.startupMs = std::max(0, std::atoi(value));
+        else if (arg == "--seed")
+            opts.seed = std::strtoull(value, nullptr, 10);
+        else if (arg == "--hang")
+            opts.hangChance = std::atof(value);
+        else if (arg == "--truncate")
+            opts.truncateChance = std::atof(value);
+        else if (arg == "--crash")
+            opts.crashChance = std::atof(value);
+        else if (arg == "--crash-after")
+            opts.crashAfter = std::max(0, std::atoi(value));
+        else if (arg == "--log")
+            opts.logPath = value;
+        else
+        {
+            std::cerr << "mockuci: unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+class MockEngine
+{
+public:
+    explicit MockEngine(const Options &opts)
+        : opts(opts), rng(opts.seed), position(Position::StartPosition())
+    {
+        if (!opts.logPath.empty())
+            log.open(opts.logPath, std::ios::app);
+    }
+
+    int Run()
+    {
+        std::string line;
+        while (std::getline(std::cin, line))
+        {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (log.is_open())
+                log << line << std::endl;
+
+            std::istringstream in(line);
+            std::string command;
+            in >> command;
+
+            if (command == "uci")
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(opts.startupMs));
+                Emit("id name mockuci");
+                Emit("id author chess project");
+                Emit("option name Skill Level type spin default 20 min 0 max 20");
+                Emit("option name Threads type spin default 1 min 1 max 512");
+                Emit("option name Hash type spin default 16 min 1 max 33554432");
+                Emit("option name MultiPV type spin default 1 min 1 max 500");
+                Emit("option name Ponder type check default false");
+                Emit("uciok");
+            }
+            else if (command == "isready")
+                Emit("readyok");
+            else if (command == "ucinewgame")
+            {
+                StopSearch();
+                position = Position::StartPosition();
+            }
+            else if (command == "position")
+                SetPosition(in);
+            else if (command == "go")
+                Go(in);
+            else if (command == "stop")
+                StopSearch();
+            else if (command == "ponderhit")
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ponderHit = true;
+                wake.notify_all();
+            }
+            else if (command == "quit")
+                break;
+            // setoption, debug, register: accepted and ignored
+        }
+
+        // A hung search never finishes; leave without joining it
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quitting = true;
+            wake.notify_all();
+        }
+        if (searchThread.joinable())
+        {
+            if (searchHung)
+                searchThread.detach();
+            else
+                searchThread.join();
+        }
+        return 0;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Options opts;
+    std::mt19937_64 rng; // Main thread only; each search gets its own
+    Position position;
+    std::ofstream log;
+
+    std::thread searchThread;
+    bool searchHung = false;
+    int searchCount = 0;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopRequested = false;
+    bool ponderHit = false;
+    bool quitting = false;
+
+    std::mutex outputMutex;
+
+    bool Chance(double p)
+    {
+        return p > 0 && std::uniform_real_distribution<double>(0.0, 1.0)(rng) < p;
+    }
+
+    void Emit(const std::string &line)
+    {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::fwrite(line.data(), 1, line.size(), stdout);
+        std::fputc('\n', stdout);
+        std::fflush(stdout);
+    }
+
+    void SetPosition(std::istringstream &in)
+    {
+        std::string token;
+        in >> token;
+
+        Position next = Position::StartPosition();
+        if (token == "fen")
+        {
+            std::string fen, part;
+            while (in >> part && part != "moves")
+                fen += (fen.empty() ? "" : " ") + part;
+            if (!next.SetFromFEN(fen))
+            {
+                std::cerr << "mockuci: bad fen " << fen << std::endl;
+                return;
+            }
+            token = part;
+        }
+        else
+        {
+            in >> token; // "moves", if any
+        }
+
+        if (token == "moves")
+        {
+            std::string uci;
+            while (in >> uci)
+            {
+                Move move;
+                if (!next.ParseUCI(uci, move))
+                {
+                    std::cerr << "mockuci: illegal move " << uci << std::endl;
+                    return;
+                }
+                next.MakeMove(move);
+            }
+        }
+        position = next;
+    }
+
+    void Go(std::istringstream &in)
+    {
+        StopSearch();
+
+        SearchPlan plan;
+        plan.position = position;
+        std::string token;
+        while (in >> token)
+        {
+            if (token == "infinite")
+                plan.limits.infinite = true;
+            else if (token == "ponder")
+                plan.limits.ponder = true;
+            else if (token == "movetime")
+                in >> plan.limits.movetimeMs;
+            else if (token == "wtime")
+                in >> plan.limits.wtimeMs;
+            else if (token == "btime")
+                in >> plan.limits.btimeMs;
+            else if (token == "winc")
+                in >> plan.limits.wincMs;
+            else if (token == "binc")
+                in >> plan.limits.bincMs;
+            else if (token == "depth")
+                in >> plan.limits.depth;
+            else if (token == "nodes")
+                in >> plan.limits.nodes;
+        }
+
+        plan.thinkMs = ThinkTime(plan.limits, position.SideToMove());
+        if (opts.jitterMs > 0)
+            plan.thinkMs += std::uniform_int_distribution<int>(0, opts.jitterMs)(rng);
+
+        searchCount++;
+        plan.hang = Chance(opts.hangChance);
+        if (searchCount == opts.crashAfter || Chance(opts.crashChance))
+            plan.crashAtMs = std::uniform_int_distribution<int>(0, std::max(0, plan.thinkMs))(rng);
+        plan.seed = rng();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopRequested = false;
+            ponderHit = false;
+        }
+        searchHung = plan.hang;
+        searchThread = std::thread(&MockEngine::Search, this, plan);
+    }
+
+    int ThinkTime(const GoLimits &limits, int side) const
+    {
+        if (opts.latencyMs >= 0)
+            return opts.latencyMs;
+        if (limits.movetimeMs > 0)
+            return limits.movetimeMs;
+
+        int remaining = side == 1 ? limits.wtimeMs : limits.btimeMs;
+        int increment = side == 1 ? limits.wincMs : limits.bincMs;
+        if (remaining >= 0)
+            return std::max(1, remaining / 30 + increment / 2);
+
+        if (limits.depth > 0 || limits.nodes > 0)
+            return 0; // Fixed-work searches answer at once
+        return 100;
+    }
+
+    void StopSearch()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopRequested = true;
+            wake.notify_all();
+        }
+        if (!searchThread.joinable())
+            return;
+
+        // A hung search keeps running on its own; the next one just starts
+        if (searchHung)
+            searchThread.detach();
+        else
+            searchThread.join();
+        searchHung = false;
+    }
+
+    std::string RandomMove(const Position &pos, std::mt19937_64 &gen, Move *chosen = nullptr) const
+    {
+        MoveList moves;
+        pos.GenerateLegalMoves(moves);
+        if (moves.count == 0)
+            return std::string();
+        Move move = moves.moves[std::uniform_int_distribution<int>(0, moves.count - 1)(gen)];
+        if (chosen != nullptr)
+            *chosen = move;
+        return Position::ToUCI(move);
+    }
+
+    // Writes line, sometimes cut off at a random point
+    void EmitMaybeTruncated(const std::string &line, std::mt19937_64 &gen)
+    {
+        if (opts.truncateChance > 0 && std::uniform_real_distribution<double>(0.0, 1.0)(gen) < opts.truncateChance)
+            Emit(line.substr(0, std::uniform_int_distribution<std::size_t>(0, line.size() - 1)(gen)));
+        else
+            Emit(line);
+    }
+
+    void Search(SearchPlan plan)
+    {
+        std::mt19937_64 gen(plan.seed);
+
+        Move best;
+        std::string bestMove = RandomMove(plan.position, gen, &best);
+        std::string ponderMove;
+        if (!bestMove.empty())
+        {
+            Position after = plan.position;
+            after.MakeMove(best);
+            ponderMove = RandomMove(after, gen);
+        }
+
+        Clock::time_point start = Clock::now();
+        Clock::time_point budgetStart = start;
+        bool waitForStop = plan.limits.infinite || plan.limits.ponder;
+        const int infoIntervalMs = opts.infoRate > 0 ? std::max(1, 1000 / opts.infoRate) : 0;
+        int depth = 0;
+        int score = std::uniform_int_distribution<int>(-50, 50)(gen);
+        uint64_t nodes = 0;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            if (quitting)
+                return;
+            if (!plan.hang && stopRequested)
+                break;
+            if (plan.limits.ponder && ponderHit && waitForStop)
+            {
+                // Now it is our move: the real budget starts here
+                waitForStop = plan.limits.infinite;
+                budgetStart = Clock::now();
+            }
+
+            Clock::time_point now = Clock::now();
+            int elapsedMs = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count());
+            if (plan.crashAtMs >= 0 && elapsedMs >= plan.crashAtMs)
+            {
+                std::fflush(stdout);
+                std::_Exit(3);
+            }
+
+            Clock::time_point deadline = budgetStart + std::chrono::milliseconds(plan.thinkMs);
+            if (!plan.hang && !waitForStop && now >= deadline)
+                break;
+
+            // Sleep until the next info line, the deadline, a crash or a command
+            Clock::time_point wakeAt = now + std::chrono::hours(1);
+            if (infoIntervalMs > 0)
+                wakeAt = std::min(wakeAt, now + std::chrono::milliseconds(infoIntervalMs));
+            if (!waitForStop && !plan.hang)
+                wakeAt = std::min(wakeAt, deadline);
+            if (plan.crashAtMs >= 0)
+                wakeAt = std::min(wakeAt, start + std::chrono::milliseconds(plan.crashAtMs));
+            wake.wait_until(lock, wakeAt);
+
+            // A hung engine goes quiet
+            if (infoIntervalMs > 0 && !plan.hang && Clock::now() >= wakeAt && !bestMove.empty())
+            {
+                depth++;
+                score += std::uniform_int_distribution<int>(-15, 15)(gen);
+                elapsedMs = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count());
+                nodes += 1000 + gen() % 50000;
+
+                std::string info = "info depth " + std::to_string(depth) + " seldepth " + std::to_string(depth + 4) +
+                                   " multipv 1 score cp " + std::to_string(score) + " nodes " + std::to_string(nodes) +
+                                   " nps " + std::to_string(elapsedMs > 0 ? nodes * 1000 / elapsedMs : nodes) +
+                                   " time " + std::to_string(elapsedMs) + " pv " + bestMove +
+                                   (ponderMove.empty() ? "" : " " + ponderMove);
+                if (opts.infoPadding > 0)
+                    info += " string " + std::string(opts.infoPadding, 'x');
+
+                lock.unlock();
+                EmitMaybeTruncated(info, gen);
+                lock.lock();
+            }
+        }
+        lock.unlock();
+
+        if (bestMove.empty())
+            Emit("bestmove (none)");
+        else
+            EmitMaybeTruncated("bestmove " + bestMove + (ponderMove.empty() ? "" : " ponder " + ponderMove), gen);
+    }
+};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    // Environment first, so the command line can override it
+    std::vector<std::string> args;
+    if (const char *env = std::getenv("MOCKUCI_OPTIONS"))
+    {
+        std::istringstream in(env);
+        std::string word;
+        while (in >> word)
+            args.push_back(word);
+    }
+    for (int i = 1; i < argc; i++)
+        args.push_back(argv[i]);
+
+    if (!args.empty() && (args[0] == "-h" || args[0] == "--help"))
+    {
+        PrintUsage();
+        return 0;
+    }
+
+    Options opts;
+    if (!ParseArgs(args, opts))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    // Never destroyed: a hung search may still be running on a detached thread
+    MockEngine *engine = new MockEngine(opts);
+    return engine->Run();
+}
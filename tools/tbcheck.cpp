@@ -0,0 +1,295 @@
+// tbcheck - verifies the Syzygy reader against independent results.
+//
+// Every position of a material set is decoded from the .ctb index layout and
+// probed through Tablebase::ProbeSyzygy(). The values have to agree with:
+//   - a one-ply search over the Syzygy values of the children (WDL is the best
+//     result over the moves, DTZ one more than the best child's, give or take
+//     the one ply the format may round away),
+//   - the .ctb table of the same material when tbgen has built one (same
+//     result, and no more plies to a zeroing move than to mate),
+//   - the compiled-in KPK bitbase for KPvK.
+//
+// Put the .rtbw/.rtbz files and the .ctb tables in the same folder.
+//
+// Usage: tbcheck [-d DIR] [KQvK KRvK ...]
+
+#include "core/Kpk.hpp"
+#include "core/Position.hpp"
+#include "core/Tablebase.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace PositionCodes;
+
+namespace
+{
+
+struct Options
+{
+    std::string directory = "tablebases";
+    std::vector<std::string> signatures; // Empty = KQvK, KRvK, KPvK
+    int maxErrors = 10;                  // Mismatches printed per table
+};
+
+struct CheckCounts
+{
+    uint64_t positions = 0;
+    uint64_t searched = 0; // Positions whose children could all be probed
+    uint64_t ctb = 0;      // Compared with a .ctb table
+    uint64_t kpk = 0;      // Compared with the KPK bitbase
+    uint64_t errors = 0;
+};
+
+int Sign(int value)
+{
+    return (value > 0) - (value < 0);
+}
+
+bool FileExists(const std::string &path)
+{
+    FILE *f = std::fopen(path.c_str(), "rb");
+    if (f == nullptr)
+        return false;
+    std::fclose(f);
+    return true;
+}
+
+class TableChecker
+{
+private:
+    Tablebase &tablebase;
+    const Options &opts;
+    CheckCounts counts;
+
+    void Fail(const Position &pos, const std::string &what)
+    {
+        if (counts.errors++ < static_cast<uint64_t>(opts.maxErrors))
+            std::cerr << "  " << what << ": " << pos.ToFEN() << std::endl;
+    }
+
+    void Mismatch(const Position &pos, const char *what, int got, int expected)
+    {
+        Fail(pos, std::string(what) + " " + std::to_string(got) + ", expected " + std::to_string(expected));
+    }
+
+    // WDL and DTZ from the children, as the probe code would derive them.
+    // False when a child's table is missing.
+    bool SearchChildren(const Position &pos, const MoveList &moves, int &wdl, int &dtz)
+    {
+        wdl = -2;
+        dtz = 0;
+        for (const Move &m : moves)
+        {
+            bool zeroing = (m.flags & (MOVE_CAPTURE | MOVE_EN_PASSANT)) != 0 || TypeOf(pos.PieceAt(m.from)) == PAWN;
+            Position child = pos;
+            child.MakeMove(m);
+
+            // Mate ends the count like a capture does
+            MoveList replies;
+            child.GenerateLegalMoves(replies);
+            zeroing = zeroing || replies.count == 0;
+
+            int childWdl, childDtz = 0;
+            if (!tablebase.ProbeSyzygy(child, childWdl, zeroing ? nullptr : &childDtz))
+                return false;
+
+            // Plies to zeroing for the mover along this move, signed like the WDL
+            int value = -childWdl;
+            int plies;
+            if (value == 0)
+                plies = 0;
+            else if (zeroing)
+                plies = (std::abs(value) == 1 ? 101 : 1) * Sign(value);
+            else
+                plies = -childDtz + Sign(value);
+
+            // Wins want the fewest plies, losses hold out longest
+            if (value > wdl || (value == wdl && value != 0 && plies < dtz))
+            {
+                wdl = value;
+                dtz = plies;
+            }
+        }
+        return true;
+    }
+
+    void CheckPosition(const Position &pos, bool pawnless3)
+    {
+        int wdl, dtz;
+        if (!tablebase.ProbeSyzygy(pos, wdl, &dtz))
+        {
+            Fail(pos, "probe failed");
+            return;
+        }
+        counts.positions++;
+
+        if (wdl != 0 && Sign(dtz) != Sign(wdl))
+            Mismatch(pos, "dtz sign", dtz, wdl);
+
+        MoveList moves;
+        pos.GenerateLegalMoves(moves);
+        if (moves.count == 0)
+        {
+            int expected = pos.InCheck() ? -2 : 0;
+            if (wdl != expected)
+                Mismatch(pos, "wdl without moves", wdl, expected);
+        }
+        else
+        {
+            int searchWdl, searchDtz;
+            if (SearchChildren(pos, moves, searchWdl, searchDtz))
+            {
+                counts.searched++;
+                if (Sign(wdl) != Sign(searchWdl))
+                    Mismatch(pos, "wdl vs. children", wdl, searchWdl);
+                else if (wdl != 0 && std::abs(dtz - searchDtz) > 1)
+                    Mismatch(pos, "dtz vs. children", dtz, searchDtz);
+            }
+        }
+
+        TablebaseResult ctb;
+        if (tablebase.ProbeCtb(pos, ctb))
+        {
+            counts.ctb++;
+            if (Sign(wdl) != ctb.wdl)
+                Mismatch(pos, "wdl vs. .ctb", wdl, ctb.wdl);
+            else if (std::abs(wdl) == 2 && ctb.dtm > 0)
+            {
+                // Mate zeroes the count too, so DTZ never exceeds DTM; with
+                // only the bare king to catch they are the same distance
+                int plies = std::abs(dtz);
+                if (plies > ctb.dtm + 1 || (pawnless3 && plies + 1 < ctb.dtm))
+                    Mismatch(pos, "dtz vs. .ctb dtm", dtz, ctb.dtm * Sign(wdl));
+            }
+        }
+
+        int kpk;
+        if (Kpk::Probe(pos, kpk))
+        {
+            counts.kpk++;
+            if (Sign(wdl) != kpk)
+                Mismatch(pos, "wdl vs. KPK", wdl, kpk);
+        }
+    }
+
+public:
+    TableChecker(Tablebase &tb, const Options &options)
+        : tablebase(tb), opts(options)
+    {
+    }
+
+    CheckCounts Run(const TablebaseLayout &layout)
+    {
+        counts = CheckCounts();
+        bool pawnless3 = layout.PieceCount() == 3 && !layout.HasPawns();
+
+        for (uint64_t index = 0; index < layout.Size(); index++)
+        {
+            Position pos;
+            if (!layout.Decode(index, pos))
+                continue;
+
+            // The .ctb layout only has the stronger side as given; Syzygy
+            // files cover both colours, so probe the mirror as well
+            CheckPosition(pos, pawnless3);
+            CheckPosition(pos.ColorFlipped(), pawnless3);
+        }
+        return counts;
+    }
+};
+
+void PrintUsage()
+{
+    std::cout << "Usage: tbcheck [options] [KQvK KRvK ...]\n"
+              << "  -d DIR           folder with the .rtbw/.rtbz files and .ctb tables (default: tablebases)\n"
+              << "  --max-errors N   mismatches printed per table (default: 10)\n"
+              << "Without signatures KQvK, KRvK and KPvK are checked (up to "
+              << TB_CTB_MAX_PIECES << " pieces).\n";
+}
+
+bool ParseArgs(int argc, char **argv, Options &opts)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "-d" && hasValue)
+            opts.directory = argv[++i];
+        else if (arg == "--max-errors" && hasValue)
+            opts.maxErrors = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "-h" || arg == "--help")
+            return false;
+        else if (!arg.empty() && arg[0] == '-')
+        {
+            std::cerr << "tbcheck: unknown option " << arg << std::endl;
+            return false;
+        }
+        else
+            opts.signatures.push_back(arg);
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options opts;
+    if (!ParseArgs(argc, argv, opts))
+    {
+        PrintUsage();
+        return 1;
+    }
+    if (opts.signatures.empty())
+        opts.signatures = {"KQvK", "KRvK", "KPvK"};
+
+    Tablebase tablebase(opts.directory);
+    TableChecker checker(tablebase, opts);
+    int checked = 0;
+    uint64_t errors = 0;
+
+    for (const std::string &sig : opts.signatures)
+    {
+        TablebaseLayout layout;
+        if (!layout.Init(sig))
+        {
+            std::cerr << "tbcheck: bad material signature " << sig << std::endl;
+            return 1;
+        }
+
+        std::string base = opts.directory + "/" + sig;
+        if (!FileExists(base + ".rtbw") || !FileExists(base + ".rtbz"))
+        {
+            std::cout << sig << ": no " << sig << ".rtbw/.rtbz in " << opts.directory << ", skipped" << std::endl;
+            continue;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        CheckCounts counts = checker.Run(layout);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::printf("%s: %llu positions, %llu searched, %llu against .ctb, %llu against KPK, %llu mismatches, %.2f s\n",
+                    sig.c_str(), static_cast<unsigned long long>(counts.positions),
+                    static_cast<unsigned long long>(counts.searched),
+                    static_cast<unsigned long long>(counts.ctb),
+                    static_cast<unsigned long long>(counts.kpk),
+                    static_cast<unsigned long long>(counts.errors), seconds);
+        std::fflush(stdout);
+        errors += counts.errors;
+        checked++;
+    }
+
+    if (checked == 0)
+    {
+        std::cerr << "tbcheck: no tables checked" << std::endl;
+        return 1;
+    }
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,712 @@
+// tbgen - builds endgame tables (.ctb) by retrograde analysis.
+//
+// Tables are generated smallest first, so every capture or promotion leads
+// into a table that is already on disk; those are read back through the
+// regular Tablebase reader. Inside one table the work goes level by level:
+// every position resolved at distance L goes into a frontier bitset, lost
+// frontier positions turn their predecessors into wins at L + 1, and won ones
+// get their predecessors re-checked for a loss. Threads split each pass and
+// claim positions with compare-and-swap, so the passes need no locks.
+//
+// The result for every index is written as 2-bit WDL plus 1-byte DTM, the
+// format Tablebase::ProbeCtb() reads.
+//
+// Usage: tbgen [options] [KQvK KRvK ...]
+
+#include "core/Position.hpp"
+#include "core/Tablebase.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+using namespace PositionCodes;
+
+namespace
+{
+
+struct Options
+{
+    std::string outputDir = "tablebases";
+    std::vector<std::string> signatures; // Empty = all sets up to maxPieces
+    int threads = 0;                      // 0 = hardware concurrency
+    int maxPieces = 4;
+    bool force = false;                   // Rebuild tables that already exist
+};
+
+// Per-position state while a table is being built
+enum CellState : uint8_t
+{
+    CELL_UNKNOWN = 0,
+    CELL_WIN,
+    CELL_LOSS,
+    CELL_DRAW,
+    CELL_BROKEN
+};
+
+// Set during the first pass from moves that leave the table
+enum ExitFlag : uint8_t
+{
+    EXIT_WIN = 1,  // A capture or promotion wins; dtm holds its distance until resolved
+    EXIT_DRAW = 2  // A capture or promotion holds the draw, so the position cannot be lost
+};
+
+constexpr int maxDtm = 255;
+constexpr uint64_t chunkSize = 1 << 14; // Multiple of 64 so chunks never share a bitset word
+
+class AtomicBitset
+{
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> words;
+    uint64_t wordCount = 0;
+
+public:
+    explicit AtomicBitset(uint64_t bits)
+        : words(new std::atomic<uint64_t>[(bits + 63) / 64]()), wordCount((bits + 63) / 64) {}
+
+    void Set(uint64_t i) { words[i >> 6].fetch_or(1ULL << (i & 63), std::memory_order_relaxed); }
+    uint64_t Word(uint64_t w) const { return words[w].load(std::memory_order_relaxed); }
+    uint64_t WordCount() const { return wordCount; }
+
+    void ClearAll()
+    {
+        for (uint64_t w = 0; w < wordCount; w++)
+            words[w].store(0, std::memory_order_relaxed);
+    }
+};
+
+// Runs fn(begin, end) over [0, count) in chunks handed out to all threads
+template <typename Fn>
+void ParallelFor(uint64_t count, int threads, Fn fn)
+{
+    std::atomic<uint64_t> next(0);
+    auto worker = [&]()
+    {
+        for (;;)
+        {
+            uint64_t begin = next.fetch_add(chunkSize);
+            if (begin >= count)
+                break;
+            fn(begin, std::min(count, begin + chunkSize));
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads; i++)
+        pool.emplace_back(worker);
+    worker();
+    for (auto &t : pool)
+        t.join();
+}
+
+class TableBuilder
+{
+private:
+    const TablebaseLayout &layout;
+    Tablebase &reader; // Already generated tables, for captures and promotions
+    int threads;
+    uint64_t size;
+
+    std::unique_ptr<std::atomic<uint8_t>[]> state;
+    std::unique_ptr<std::atomic<uint8_t>[]> dtm;
+    std::unique_ptr<uint8_t[]> exitFlags;
+    AtomicBitset frontier;
+
+    std::atomic<bool> missingTable{false};
+
+    void InitRange(uint64_t begin, uint64_t end);
+    template <typename Fn>
+    void ForEachPredecessor(uint64_t index, Fn fn) const;
+    bool AllMovesLose(uint64_t index, int &worst) const;
+
+public:
+    TableBuilder(const TablebaseLayout &layout, Tablebase &reader, int threads);
+
+    bool Build(int &longestMate);
+    bool Write(const std::string &path, uint64_t counts[4]) const;
+};
+
+TableBuilder::TableBuilder(const TablebaseLayout &l, Tablebase &r, int t)
+    : layout(l), reader(r), threads(t), size(l.Size()),
+      state(new std::atomic<uint8_t>[l.Size()]()),
+      dtm(new std::atomic<uint8_t>[l.Size()]()),
+      exitFlags(new uint8_t[l.Size()]()),
+      frontier(l.Size())
+{
+}
+
+// First pass: broken indices, mates, stalemates and everything reachable
+// through captures or promotions
+void TableBuilder::InitRange(uint64_t begin, uint64_t end)
+{
+    for (uint64_t i = begin; i < end; i++)
+    {
+        Position pos;
+        if (!layout.Decode(i, pos))
+        {
+            state[i] = CELL_BROKEN;
+            continue;
+        }
+
+        MoveList moves;
+        pos.GenerateLegalMoves(moves);
+        if (moves.count == 0)
+        {
+            state[i] = pos.InCheck() ? CELL_LOSS : CELL_DRAW;
+            continue;
+        }
+
+        int exitWin = 0, exitLoss = 0, inTable = 0;
+        bool exitDraw = false;
+
+        for (const Move &m : moves)
+        {
+            if (!(m.flags & MOVE_CAPTURE) && m.promotion == 0)
+            {
+                inTable++;
+                continue;
+            }
+
+            Position child = pos;
+            child.MakeMove(m);
+            TablebaseResult r;
+            if (!reader.ProbeCtb(child, r))
+            {
+                missingTable = true;
+                return;
+            }
+
+            int distance = std::max(r.dtm, 0) + 1;
+            if (r.wdl < 0)
+                exitWin = exitWin ? std::min(exitWin, distance) : distance;
+            else if (r.wdl > 0)
+                exitLoss = std::max(exitLoss, distance);
+            else
+                exitDraw = true;
+        }
+
+        if (exitWin)
+        {
+            // Resolved when the level loop reaches this distance, unless a faster win turns up
+            exitFlags[i] = EXIT_WIN;
+            dtm[i] = static_cast<uint8_t>(std::min(exitWin, maxDtm));
+        }
+        else
+        {
+            exitFlags[i] = exitDraw ? EXIT_DRAW : 0;
+            dtm[i] = static_cast<uint8_t>(std::min(exitLoss, maxDtm));
+            if (inTable == 0)
+                state[i] = exitDraw ? CELL_DRAW : CELL_LOSS;
+        }
+    }
+}
+
+// Positions one move earlier: the side that is not to move takes back a
+// non-capturing, non-promoting move. fn receives each predecessor's index.
+template <typename Fn>
+void TableBuilder::ForEachPredecessor(uint64_t index, Fn fn) const
+{
+    static const int knightSteps[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+    static const int kingSteps[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+
+    Position pos;
+    if (!layout.Decode(index, pos))
+        return;
+
+    const int stm = pos.SideToMove();
+    const int mover = 1 - stm;
+
+    int squares[TB_CTB_MAX_PIECES];
+    int codes[TB_CTB_MAX_PIECES];
+    int count = 0;
+    for (int sq = 0; sq < 64; sq++)
+    {
+        if (pos.PieceAt(sq) != 0)
+        {
+            squares[count] = sq;
+            codes[count++] = pos.PieceAt(sq);
+        }
+    }
+
+    auto emit = [&](int pieceSlot, int from)
+    {
+        Position prev;
+        prev.Clear();
+        for (int k = 0; k < count; k++)
+            prev.AddPiece(k == pieceSlot ? from : squares[k], codes[k]);
+        prev.SetSideToMove(mover);
+
+        // The side that did not move may not have been left in check
+        if (!prev.IsSquareAttacked(prev.KingSquare(stm), mover))
+            fn(layout.Index(prev));
+    };
+
+    for (int k = 0; k < count; k++)
+    {
+        if (ColorOf(codes[k]) != mover)
+            continue;
+
+        int sq = squares[k];
+        int file = FileOf(sq), rank = RankOf(sq);
+        int type = TypeOf(codes[k]);
+
+        if (type == PAWN)
+        {
+            int back = (mover == 1) ? -1 : 1;
+            int startRank = (mover == 1) ? 1 : 6;
+            int r1 = rank + back;
+            if (r1 < 1 || r1 > 6 || pos.PieceAt(MakeSquare(file, r1)) != 0)
+                continue;
+            emit(k, MakeSquare(file, r1));
+
+            int r2 = r1 + back;
+            if (r2 == startRank && pos.PieceAt(MakeSquare(file, r2)) == 0)
+                emit(k, MakeSquare(file, r2));
+            continue;
+        }
+
+        if (type == KNIGHT || type == KING)
+        {
+            const int(*steps)[2] = (type == KNIGHT) ? knightSteps : kingSteps;
+            for (int s = 0; s < 8; s++)
+            {
+                int f = file + steps[s][0], r = rank + steps[s][1];
+                if (f >= 0 && f <= 7 && r >= 0 && r <= 7 && pos.PieceAt(MakeSquare(f, r)) == 0)
+                    emit(k, MakeSquare(f, r));
+            }
+            continue;
+        }
+
+        for (int df = -1; df <= 1; df++)
+        {
+            for (int dr = -1; dr <= 1; dr++)
+            {
+                if (df == 0 && dr == 0)
+                    continue;
+                bool diagonal = (df != 0 && dr != 0);
+                if ((diagonal && type == ROOK) || (!diagonal && type == BISHOP))
+                    continue;
+
+                for (int f = file + df, r = rank + dr; f >= 0 && f <= 7 && r >= 0 && r <= 7; f += df, r += dr)
+                {
+                    if (pos.PieceAt(MakeSquare(f, r)) != 0)
+                        break;
+                    emit(k, MakeSquare(f, r));
+                }
+            }
+        }
+    }
+}
+
+// True if every move stays in the table and reaches a position already won
+// for the opponent. Moves out of the table were folded into exitFlags/dtm.
+bool TableBuilder::AllMovesLose(uint64_t index, int &worst) const
+{
+    Position pos;
+    if (!layout.Decode(index, pos))
+        return false;
+
+    MoveList moves;
+    pos.GenerateLegalMoves(moves);
+
+    worst = 0;
+    for (const Move &m : moves)
+    {
+        if ((m.flags & MOVE_CAPTURE) || m.promotion != 0)
+            continue;
+
+        Position child = pos;
+        child.MakeMove(m);
+        uint64_t c = layout.Index(child);
+        if (state[c].load(std::memory_order_relaxed) != CELL_WIN)
+            return false;
+        worst = std::max(worst, dtm[c].load(std::memory_order_relaxed) + 1);
+    }
+    return true;
+}
+
+bool TableBuilder::Build(int &longestMate)
+{
+    ParallelFor(size, threads, [&](uint64_t begin, uint64_t end) { InitRange(begin, end); });
+    if (missingTable)
+        return false;
+
+    longestMate = 0;
+    for (int level = 0; level < maxDtm; level++)
+    {
+        frontier.ClearAll();
+        std::atomic<uint64_t> frontierCount(0);
+        std::atomic<uint64_t> pending(0);
+
+        // Collect everything resolved at this distance. Wins through a capture
+        // or promotion become final here if nothing faster was found.
+        ParallelFor(size, threads, [&](uint64_t begin, uint64_t end)
+        {
+            uint64_t found = 0, later = 0;
+            for (uint64_t i = begin; i < end; i++)
+            {
+                uint8_t s = state[i].load(std::memory_order_relaxed);
+                int d = dtm[i].load(std::memory_order_relaxed);
+
+                if (s == CELL_UNKNOWN && (exitFlags[i] & EXIT_WIN) && d == level)
+                {
+                    state[i].store(CELL_WIN, std::memory_order_relaxed);
+                    s = CELL_WIN;
+                }
+
+                bool decided = (s == CELL_WIN || s == CELL_LOSS);
+                if (decided && d == level)
+                {
+                    frontier.Set(i);
+                    found++;
+                }
+                else if (d > level && (decided || (s == CELL_UNKNOWN && (exitFlags[i] & EXIT_WIN))))
+                {
+                    later++;
+                }
+            }
+            frontierCount += found;
+            pending += later;
+        });
+
+        if (frontierCount == 0)
+        {
+            if (pending == 0)
+                break;
+            continue;
+        }
+        longestMate = level;
+
+        auto forEachFrontier = [&](uint8_t wanted, auto fn)
+        {
+            ParallelFor(frontier.WordCount(), threads, [&](uint64_t begin, uint64_t end)
+            {
+                for (uint64_t w = begin; w < end; w++)
+                {
+                    for (uint64_t bits = frontier.Word(w); bits != 0; bits &= bits - 1)
+                    {
+                        uint64_t i = w * 64 + static_cast<uint64_t>(__builtin_ctzll(bits));
+                        if (state[i].load(std::memory_order_relaxed) == wanted)
+                            fn(i);
+                    }
+                }
+            });
+        };
+
+        const uint8_t next = static_cast<uint8_t>(std::min(level + 1, maxDtm));
+
+        // Lost positions: whoever can move into them wins one ply later
+        forEachFrontier(CELL_LOSS, [&](uint64_t i)
+        {
+            ForEachPredecessor(i, [&](uint64_t prev)
+            {
+                uint8_t expected = CELL_UNKNOWN;
+                if (state[prev].compare_exchange_strong(expected, CELL_WIN))
+                    dtm[prev].store(next, std::memory_order_relaxed);
+            });
+        });
+
+        // Won positions: a predecessor is lost once all of its moves lead to wins
+        forEachFrontier(CELL_WIN, [&](uint64_t i)
+        {
+            ForEachPredecessor(i, [&](uint64_t prev)
+            {
+                if (state[prev].load(std::memory_order_relaxed) != CELL_UNKNOWN ||
+                    (exitFlags[prev] & (EXIT_WIN | EXIT_DRAW)))
+                    return;
+
+                int worst = 0;
+                if (!AllMovesLose(prev, worst))
+                    return;
+
+                // dtm still holds the longest losing capture or promotion
+                int distance = std::min(std::max<int>(worst, dtm[prev].load(std::memory_order_relaxed)), maxDtm);
+                uint8_t expected = CELL_UNKNOWN;
+                if (state[prev].compare_exchange_strong(expected, CELL_LOSS))
+                    dtm[prev].store(static_cast<uint8_t>(distance), std::memory_order_relaxed);
+            });
+        });
+    }
+
+    // Nothing forced either way
+    for (uint64_t i = 0; i < size; i++)
+    {
+        if (state[i] == CELL_UNKNOWN)
+            state[i] = CELL_DRAW;
+    }
+    return true;
+}
+
+bool TableBuilder::Write(const std::string &path, uint64_t counts[4]) const
+{
+    TablebaseHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "CTB1", 4);
+    header.version = TB_VERSION;
+    std::strncpy(header.signature, layout.Signature().c_str(), sizeof(header.signature) - 1);
+    header.entries = size;
+    header.wdlOffset = sizeof(header);
+    header.dtmOffset = sizeof(header) + (size + 3) / 4;
+
+    std::vector<uint8_t> wdl((size + 3) / 4, 0);
+    std::vector<uint8_t> distances(size, 0);
+    counts[0] = counts[1] = counts[2] = counts[3] = 0;
+
+    for (uint64_t i = 0; i < size; i++)
+    {
+        int value;
+        switch (state[i].load())
+        {
+        case CELL_WIN: value = TB_WIN; break;
+        case CELL_LOSS: value = TB_LOSS; break;
+        case CELL_DRAW: value = TB_DRAW; break;
+        default: value = TB_INVALID; break;
+        }
+        counts[value]++;
+        wdl[i >> 2] |= static_cast<uint8_t>(value << ((i & 3) * 2));
+        if (value == TB_WIN || value == TB_LOSS)
+            distances[i] = dtm[i].load();
+    }
+
+    // Write to a temporary name so a crash never leaves a half-written table behind
+    std::string tmpPath = path + ".tmp";
+    FILE *f = std::fopen(tmpPath.c_str(), "wb");
+    if (f == nullptr)
+        return false;
+
+    bool ok = std::fwrite(&header, sizeof(header), 1, f) == 1 &&
+              std::fwrite(wdl.data(), 1, wdl.size(), f) == wdl.size() &&
+              std::fwrite(distances.data(), 1, distances.size(), f) == distances.size();
+    ok = (std::fclose(f) == 0) && ok;
+
+    std::remove(path.c_str());
+    if (!ok || std::rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Every material set with 3..maxPieces pieces, ordered so that the tables a
+// set captures or promotes into come before it
+std::vector<std::string> AllSignatures(int maxPieces)
+{
+    const int types[5] = {QUEEN, ROOK, BISHOP, KNIGHT, PAWN};
+    std::set<std::string> seen;
+    std::vector<std::string> result;
+
+    // Each side is a non-decreasing run of type slots
+    std::vector<std::vector<int>> sides;
+    std::vector<int> current;
+    auto build = [&](auto &self, int minSlot, int remaining) -> void
+    {
+        sides.push_back(current);
+        if (remaining == 0)
+            return;
+        for (int slot = minSlot; slot < 5; slot++)
+        {
+            current.push_back(types[slot]);
+            self(self, slot, remaining - 1);
+            current.pop_back();
+        }
+    };
+    build(build, 0, maxPieces - 2);
+
+    for (const auto &white : sides)
+    {
+        for (const auto &black : sides)
+        {
+            int pieces = 2 + static_cast<int>(white.size() + black.size());
+            if (pieces < 3 || pieces > maxPieces)
+                continue;
+
+            Position pos;
+            pos.Clear();
+            pos.AddPiece(0, MakeCode(KING, 1));
+            pos.AddPiece(63, MakeCode(KING, 0));
+            int sq = 8; // Placement is irrelevant, only the counts are used
+            int minors = 0;
+            bool heavy = false;
+            for (int t : white)
+            {
+                pos.AddPiece(sq++, MakeCode(t, 1));
+                minors += (t == BISHOP || t == KNIGHT);
+                heavy |= (t == QUEEN || t == ROOK || t == PAWN);
+            }
+            for (int t : black)
+            {
+                pos.AddPiece(sq++, MakeCode(t, 0));
+                minors += (t == BISHOP || t == KNIGHT);
+                heavy |= (t == QUEEN || t == ROOK || t == PAWN);
+            }
+
+            // KBvK and KNvK are dead draws the reader already knows about
+            if (!heavy && minors <= 1)
+                continue;
+
+            bool flipped;
+            std::string sig = TablebaseLayout::SignatureOf(pos, flipped);
+            if (seen.insert(sig).second)
+                result.push_back(sig);
+        }
+    }
+
+    auto sortKey = [](const std::string &sig)
+    {
+        int pawns = static_cast<int>(std::count(sig.begin(), sig.end(), 'P'));
+        return std::make_tuple(static_cast<int>(sig.size()) - 1, pawns, sig);
+    };
+    std::sort(result.begin(), result.end(), [&](const std::string &a, const std::string &b)
+    {
+        return sortKey(a) < sortKey(b);
+    });
+    return result;
+}
+
+bool FileExists(const std::string &path)
+{
+    FILE *f = std::fopen(path.c_str(), "rb");
+    if (f == nullptr)
+        return false;
+    std::fclose(f);
+    return true;
+}
+
+void MakeDirectory(const std::string &path)
+{
+#ifdef _WIN32
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0755);
+#endif
+}
+
+void PrintUsage()
+{
+    std::cout << "Usage: tbgen [options] [KQvK KRvK ...]\n"
+              << "  -o DIR           output directory (default: tablebases)\n"
+              << "  --threads N      worker threads (default: all cores)\n"
+              << "  --five           also build 5-piece tables (several GB of RAM)\n"
+              << "  --force          rebuild tables that already exist\n"
+              << "Without signatures every 3- and 4-piece table is built.\n";
+}
+
+bool ParseArgs(int argc, char **argv, Options &opts)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "-o" && hasValue)
+            opts.outputDir = argv[++i];
+        else if (arg == "--threads" && hasValue)
+            opts.threads = std::atoi(argv[++i]);
+        else if (arg == "--five")
+            opts.maxPieces = 5;
+        else if (arg == "--force")
+            opts.force = true;
+        else if (arg == "-h" || arg == "--help")
+            return false;
+        else if (!arg.empty() && arg[0] == '-')
+        {
+            std::cerr << "tbgen: unknown option " << arg << std::endl;
+            return false;
+        }
+        else
+            opts.signatures.push_back(arg);
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options opts;
+    if (!ParseArgs(argc, argv, opts))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    if (opts.threads <= 0)
+        opts.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<std::string> signatures = opts.signatures.empty() ? AllSignatures(opts.maxPieces) : opts.signatures;
+    MakeDirectory(opts.outputDir);
+
+    const auto startTime = std::chrono::steady_clock::now();
+    int built = 0;
+
+    for (const std::string &sig : signatures)
+    {
+        TablebaseLayout layout;
+        if (!layout.Init(sig))
+        {
+            std::cerr << "tbgen: bad material signature " << sig << std::endl;
+            return 1;
+        }
+
+        std::string path = opts.outputDir + "/" + sig + ".ctb";
+        if (!opts.force && FileExists(path))
+        {
+            std::cout << sig << ": exists, skipped" << std::endl;
+            continue;
+        }
+
+        // A fresh reader per table, so the tables written so far are all visible
+        Tablebase reader(opts.outputDir);
+        const auto tableStart = std::chrono::steady_clock::now();
+
+        TableBuilder builder(layout, reader, opts.threads);
+        int longestMate = 0;
+        if (!builder.Build(longestMate))
+        {
+            std::cerr << "tbgen: " << sig << " needs a smaller table that is missing, build it first" << std::endl;
+            return 1;
+        }
+
+        uint64_t counts[4];
+        if (!builder.Write(path, counts))
+        {
+            std::cerr << "tbgen: failed writing " << path << std::endl;
+            return 1;
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - tableStart).count();
+        uint64_t wdlBytes = (layout.Size() + 3) / 4;
+        uint64_t dtmBytes = layout.Size();
+
+        std::printf("%s: %llu positions, WDL %.1f KB + DTM %.1f KB, win %llu / draw %llu / loss %llu, "
+                    "longest mate %d plies, %.2f s\n",
+                    sig.c_str(), static_cast<unsigned long long>(layout.Size()),
+                    wdlBytes / 1024.0, dtmBytes / 1024.0,
+                    static_cast<unsigned long long>(counts[TB_WIN]),
+                    static_cast<unsigned long long>(counts[TB_DRAW]),
+                    static_cast<unsigned long long>(counts[TB_LOSS]),
+                    longestMate, seconds);
+        std::fflush(stdout);
+        built++;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    std::cout << "tbgen: " << built << " tables in " << seconds << " s" << std::endl;
+    return 0;
+}